@@ -29,8 +29,45 @@
 #include "plugin.h"
 #include "connectioncontainer.h"
 #include "utils.h"
+#include "../common/event_recorder.h"
 
-#include <atomic>
+/* keeps the event id and its first argument in the flight recorder */
+static void recordEvent(event_record_kind kind, DISPID dispId, const DISPPARAMS *pDispParams)
+{
+    event_recorder& recorder = event_recorder::instance();
+    if( !recorder.is_open() )
+        return;
+
+    if( NULL == pDispParams || 0 == pDispParams->cArgs )
+    {
+        recorder.record(kind, dispId);
+        return;
+    }
+
+    // arguments are stored in reverse order
+    const VARIANTARG& arg = pDispParams->rgvarg[pDispParams->cArgs - 1];
+    switch( arg.vt )
+    {
+        case VT_I2:
+            recorder.record(kind, dispId, (int64_t)arg.iVal);
+            break;
+        case VT_I2|VT_BYREF:
+            recorder.record(kind, dispId, (int64_t)*arg.piVal);
+            break;
+        case VT_I4:
+            recorder.record(kind, dispId, (int64_t)arg.lVal);
+            break;
+        case VT_BOOL:
+            recorder.record(kind, dispId, (int64_t)arg.boolVal);
+            break;
+        case VT_R4:
+            recorder.record(kind, dispId, (double)arg.fltVal);
+            break;
+        default:
+            recorder.record(kind, dispId);
+            break;
+    }
+}
 
 /* this function object is used to return the value from a map pair */
 struct VLCEnumConnectionsDereference
@@ -71,159 +108,6 @@ using VLCEnumConnectionPoints = VLCEnumIterator<IID_IEnumConnectionPoints,
                                     LPCONNECTIONPOINT,
                                     std::vector<LPCONNECTIONPOINT>,
                                     VLCEnumConnectionPointsDereference>;
-////////////////////////////////////////////////////////////////////////////////////////////////
-// EventSystemProxyWnd
-////////////////////////////////////////////////////////////////////////////////////////////////
-class EventSystemProxyWnd
-{
-private:
-    enum{
-        WM_NEW_EVENT_NOTIFY = WM_USER+1
-    };
-    static LPCTSTR getClassName(void) { return TEXT("VLC ActiveX ESP Class"); }
-    static void RegisterWndClassName();
-    static void UnRegisterWndClassName();
-    static LRESULT CALLBACK ESPWindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
-
-    static HINSTANCE _hInstance;
-    static ATOM _ESP_wndclass_atom;
-    HWND _hWnd;
-
-public:
-    static EventSystemProxyWnd* CreateESPWindow(HINSTANCE hInstance, VLCConnectionPointContainer *pCPC);
-
-private:
-    EventSystemProxyWnd(HWND hWnd, VLCConnectionPointContainer *pCPC)
-        : _hWnd(hWnd), _pCPC(pCPC)
-    {
-        // Initialize this out of members initialization list because MSVC
-        // doesn't implement atomic_int constructor until VS 2015
-        _HasUnprocessedNotify = false;
-    }
-    void ProcessNotify();
-
-public:
-    void DestroyWindow()
-        {::DestroyWindow(_hWnd);}
-
-
-    //allowed to invoke from any thread
-    void NewEventNotify();
-
-private:
-    VLCConnectionPointContainer *_pCPC;
-    std::atomic_bool _HasUnprocessedNotify;
-};
-
-HINSTANCE EventSystemProxyWnd::_hInstance=0;
-ATOM EventSystemProxyWnd::_ESP_wndclass_atom=0;
-
-
-void EventSystemProxyWnd::RegisterWndClassName()
-{
-    WNDCLASS wClass;
-    memset(&wClass, 0, sizeof(WNDCLASS));
-
-    if( ! GetClassInfo(_hInstance, getClassName(), &wClass) )
-    {
-        wClass.lpfnWndProc    = ESPWindowProc;
-        wClass.hInstance      = _hInstance;
-        wClass.lpszClassName  = getClassName();
-
-        _ESP_wndclass_atom = RegisterClass(&wClass);
-    }
-    else
-    {
-        _ESP_wndclass_atom = 0;
-    }
-}
-
-void EventSystemProxyWnd::UnRegisterWndClassName()
-{
-    if(0 != _ESP_wndclass_atom){
-        UnregisterClass(MAKEINTATOM(_ESP_wndclass_atom), _hInstance);
-        _ESP_wndclass_atom = 0;
-    }
-}
-
-LRESULT CALLBACK EventSystemProxyWnd::ESPWindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
-{
-    EventSystemProxyWnd* ESP = reinterpret_cast<EventSystemProxyWnd*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
-
-    switch( uMsg )
-    {
-        case WM_CREATE:{
-            CREATESTRUCT* CreateStruct = (CREATESTRUCT*)(lParam);
-            VLCConnectionPointContainer * pCPC = reinterpret_cast<VLCConnectionPointContainer *>(CreateStruct->lpCreateParams);
-
-            ESP = new EventSystemProxyWnd(hWnd, pCPC);
-            SetWindowLongPtr(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(ESP));
-            break;
-        }
-        case WM_NCDESTROY:
-            delete ESP;
-            SetWindowLongPtr(hWnd, GWLP_USERDATA, 0);
-            break;
-        case WM_NEW_EVENT_NOTIFY:
-            ESP->ProcessNotify();
-            break;
-        default:
-            return DefWindowProc(hWnd, uMsg, wParam, lParam);
-    }
-    return 0;
-}
-
-EventSystemProxyWnd* EventSystemProxyWnd::CreateESPWindow(HINSTANCE hInstance, VLCConnectionPointContainer *pCPC)
-{
-    //save hInstance for future use
-    _hInstance = hInstance;
-
-    RegisterWndClassName();
-
-    HWND hWnd = CreateWindow(getClassName(),
-                             0,
-                             0,
-                             0, 0, 0, 0,
-                             0,
-                             0,
-                             _hInstance,
-                             pCPC
-                             );
-
-    if(hWnd)
-        return reinterpret_cast<EventSystemProxyWnd*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
-
-    return 0;
-}
-
-void EventSystemProxyWnd::NewEventNotify()
-{
-    if(!_HasUnprocessedNotify){
-        _HasUnprocessedNotify=true;
-        PostMessage(_hWnd, WM_NEW_EVENT_NOTIFY, 0, 0);
-    }
-}
-
-void EventSystemProxyWnd::ProcessNotify()
-{
-    while(_pCPC->isRunning){
-        VLCDispatchEvent *ev = 0;
-        EnterCriticalSection(&(_pCPC->csEvents));
-        if(!_pCPC->_q_events.empty()){
-            ev = _pCPC->_q_events.front();
-            _pCPC->_q_events.pop();
-        }
-        LeaveCriticalSection(&(_pCPC->csEvents));
-
-        if(ev){
-            _pCPC->_p_events->fireEvent(ev->_dispId, &ev->_dispParams);
-            delete ev;
-        }
-        else break;
-    }
-    _HasUnprocessedNotify=false;
-}
-
 ////////////////////////////////////////////////////////////////////////////////////////////////
 // VLCConnectionPoint
 ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -369,9 +253,9 @@ VLCDispatchEvent::~VLCDispatchEvent()
 ////////////////////////////////////////////////////////////////////////////////////////////////
 // VLCConnectionPointContainer
 ////////////////////////////////////////////////////////////////////////////////////////////////
-extern HMODULE DllGetModule();
 VLCConnectionPointContainer::VLCConnectionPointContainer(VLCPlugin *p_instance) :
-    _ESProxyWnd(0), _p_instance(p_instance), isRunning(TRUE), freeze(FALSE)
+    _p_instance(p_instance), isRunning(TRUE), freeze(FALSE),
+    _hasUnprocessedNotify(false), _notifyPostedAt(0)
 {
     _p_events = new VLCConnectionPoint(this, _p_instance->getDispEventID());
 
@@ -384,7 +268,8 @@ VLCConnectionPointContainer::VLCConnectionPointContainer(VLCPlugin *p_instance)
     // init protection
     InitializeCriticalSection(&csEvents);
 
-    _ESProxyWnd = EventSystemProxyWnd::CreateESPWindow(DllGetModule(), this);
+    // shared with the other controls created on this thread
+    _dispatcher = event_dispatcher::current();
 }
 
 VLCConnectionPointContainer::~VLCConnectionPointContainer()
@@ -392,9 +277,9 @@ VLCConnectionPointContainer::~VLCConnectionPointContainer()
     isRunning = FALSE;
     freeze = TRUE;
 
-    if(_ESProxyWnd)
-        _ESProxyWnd->DestroyWindow();
-    _ESProxyWnd=0;
+    if(_dispatcher)
+        _dispatcher->cancel(this);
+    _dispatcher.reset();
 
     DeleteCriticalSection(&csEvents);
 
@@ -445,22 +330,128 @@ void VLCConnectionPointContainer::freezeEvents(BOOL bFreeze)
 
 void VLCConnectionPointContainer::fireEvent(DISPID dispId, DISPPARAMS* pDispParams)
 {
-    if(_ESProxyWnd){
+    recordEvent(erk_event, dispId, pDispParams);
+    if(_dispatcher){
         EnterCriticalSection(&csEvents);
 
         // queue event for later use when container is ready
-        _q_events.push(new VLCDispatchEvent(dispId, *pDispParams));
-        if( _q_events.size() > 1024 )
+        bool b_notify = queueEvent(new VLCDispatchEvent(dispId, *pDispParams));
+        LeaveCriticalSection(&csEvents);
+        if( b_notify )
+            notifyEvents();
+    }
+}
+
+void VLCConnectionPointContainer::fireMouseMoveEvent(short nButton, short nShiftState, int x, int y)
+{
+    event_recorder::instance().record(erk_event, DISPID_MOUSEMOVE, (int64_t)nButton);
+    if(_dispatcher){
+        mouse_move_event move = { nButton, nShiftState, x, y };
+        bool b_notify = false;
+
+        EnterCriticalSection(&csEvents);
+        // only the first move after a delivery takes a slot in the queue,
+        // the following ones are merged into it until it gets delivered
+        if( _mouse_moves.push(move) )
         {
-            // too many events in queue, get rid of older one
-            delete _q_events.front();
+            DISPPARAMS dispparamsNoArgs = {NULL, NULL, 0, 0};
+            b_notify = queueEvent(new VLCDispatchEvent(DISPID_MOUSEMOVE, dispparamsNoArgs));
+        }
+        LeaveCriticalSection(&csEvents);
+
+        if( b_notify )
+            notifyEvents();
+    }
+}
+
+bool VLCConnectionPointContainer::queueEvent(VLCDispatchEvent *ev)
+{
+    _q_events.push(ev);
+    _stats.queued(_q_events.size());
+    if( _q_events.size() > 1024 )
+    {
+        // too many events in queue, get rid of older one
+        VLCDispatchEvent *old = _q_events.front();
+        _q_events.pop();
+        if( old->isMouseMovePlaceholder() )
+            _mouse_moves.reset();
+        delete old;
+        _stats.dropped();
+    }
+
+    // a single notification covers everything queued until the drain starts
+    if( _hasUnprocessedNotify )
+        return false;
+    _hasUnprocessedNotify = true;
+    _notifyPostedAt = monotonic_now_us();
+    return true;
+}
+
+void VLCConnectionPointContainer::notifyEvents()
+{
+    _dispatcher->post(this, [this]() { processEvents(); });
+}
+
+void VLCConnectionPointContainer::processEvents()
+{
+    EnterCriticalSection(&csEvents);
+    _stats.woken(_notifyPostedAt, monotonic_now_us());
+    // events queued from now on need another notification
+    _hasUnprocessedNotify = false;
+    LeaveCriticalSection(&csEvents);
+
+    while(isRunning){
+        VLCDispatchEvent *ev = 0;
+        mouse_move_event move;
+        bool b_move = false;
+        EnterCriticalSection(&csEvents);
+        if(!_q_events.empty()){
+            ev = _q_events.front();
             _q_events.pop();
+            _stats.delivered(ev->_dispId, ev->_queuedAt, monotonic_now_us());
+            if( ev->isMouseMovePlaceholder() )
+                b_move = _mouse_moves.take(move);
         }
         LeaveCriticalSection(&csEvents);
-        _ESProxyWnd->NewEventNotify();
+
+        if(b_move){
+            // arguments are built at delivery time from the merged move
+            VARIANTARG args[4];
+            memset(args, 0, sizeof(args));
+            args[3].vt = VT_I2;
+            args[3].iVal = move.button;
+            args[2].vt = VT_I2;
+            args[2].iVal = move.shift;
+            args[1].vt = VT_I4;
+            args[1].lVal = move.x;
+            args[0].vt = VT_I4;
+            args[0].lVal = move.y;
+            DISPPARAMS params = { args, NULL, 4, 0 };
+            recordEvent(erk_dispatch, DISPID_MOUSEMOVE, &params);
+            _p_events->fireEvent(DISPID_MOUSEMOVE, &params);
+            delete ev;
+        }
+        else if(ev){
+            if( !ev->isMouseMovePlaceholder() )
+            {
+                recordEvent(erk_dispatch, ev->_dispId, &ev->_dispParams);
+                _p_events->fireEvent(ev->_dispId, &ev->_dispParams);
+            }
+            delete ev;
+        }
+        else break;
     }
 }
 
+void VLCConnectionPointContainer::getEventStats(event_stats& stats, bool reset)
+{
+    EnterCriticalSection(&csEvents);
+    stats = _stats;
+    if( reset )
+        _stats.reset();
+    LeaveCriticalSection(&csEvents);
+}
+
 void VLCConnectionPointContainer::firePropChangedEvent(DISPID dispId)
 {
     if( ! freeze )
@@ -32,6 +32,10 @@
 #include <cguid.h>
 
 #include "plugin.h"
+#include "../common/mouse_move_coalescer.h"
+#include "../common/event_stats.h"
+#include "../common/event_dispatcher.h"
+#include "../common/monotonic_clock.h"
 
 class VLCConnectionPoint : public IConnectionPoint
 {
@@ -85,16 +89,22 @@ class VLCDispatchEvent {
 
 public:
     VLCDispatchEvent(DISPID dispId, DISPPARAMS dispParams) :
-        _dispId(dispId), _dispParams(dispParams)
+        _dispId(dispId), _dispParams(dispParams), _queuedAt(monotonic_now_us())
     {
     }
     ~VLCDispatchEvent();
 
+    // mouse moves are queued without arguments, these are
+    // taken from the container's coalescer at delivery time
+    bool isMouseMovePlaceholder() const
+        { return DISPID_MOUSEMOVE == _dispId && 0 == _dispParams.cArgs; }
+
     DISPID      _dispId;
     DISPPARAMS  _dispParams;
+    // monotonic time of the libvlc callback that queued the event
+    uint64_t    _queuedAt;
 };
 
-class EventSystemProxyWnd;
 class VLCConnectionPointContainer : public IConnectionPointContainer
 {
 
@@ -127,11 +137,24 @@ public:
 
     void freezeEvents(BOOL);
     void fireEvent(DISPID, DISPPARAMS*);
+    void fireMouseMoveEvent(short nButton, short nShiftState, int x, int y);
     void firePropChangedEvent(DISPID dispId);
 
+    // copies the delivery statistics gathered so far, optionally
+    // starting a new measurement window
+    void getEventStats(event_stats& stats, bool reset);
+
+private:
+    // must be called with csEvents held, returns true when
+    // the caller must notify the dispatcher once unlocked
+    bool queueEvent(VLCDispatchEvent *ev);
+    void notifyEvents();
+    // delivers queued events, runs on the dispatcher thread
+    void processEvents();
+
 public:
     CRITICAL_SECTION csEvents;
-    EventSystemProxyWnd* _ESProxyWnd;
+    std::shared_ptr<event_dispatcher> _dispatcher;
 
     VLCPlugin *_p_instance;
     BOOL isRunning;
@@ -140,6 +163,13 @@ public:
     VLCConnectionPoint *_p_props;
     std::vector<LPCONNECTIONPOINT> _v_cps;
     std::queue<VLCDispatchEvent *> _q_events;
+    // mouse moves waiting for delivery, protected by csEvents
+    mouse_move_coalescer _mouse_moves;
+    // delivery latencies and queue depth, protected by csEvents
+    event_stats _stats;
+    // a drain is pending on the dispatcher, protected by csEvents
+    bool _hasUnprocessedNotify;
+    uint64_t _notifyPostedAt;
 };
 
 #endif
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * metacache.cpp: converted meta and track strings for scripts
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "metacache.h"
+#include "utils.h"
+
+VLCMetaCache::VLCMetaCache() :
+    _metaChanged(nullptr)
+{
+}
+
+VLCMetaCache::~VLCMetaCache()
+{
+    if( _metaChanged )
+        _metaChanged->unregister();
+}
+
+bool VLCMetaCache::lookup(Kind kind, long index, BSTR *val)
+{
+    const BSTR *cached = _entries.find(key(kind, index));
+    if( !cached )
+        return false;
+    *val = SysAllocStringLen(*cached, SysStringLen(*cached));
+    return NULL != *val;
+}
+
+bool VLCMetaCache::lookupMeta(const VLC::MediaPtr& media, libvlc_meta_t meta, BSTR *val)
+{
+    if( !_media || _media->get() != media->get() )
+    {
+        if( _metaChanged )
+            _metaChanged->unregister();
+        _media = media;
+        // holding the media keeps its address from being reused
+        _metaChanged = _media->eventManager().onMetaChanged( invalidator() );
+        invalidate();
+    }
+    return lookup(MetaKind, meta, val);
+}
+
+HRESULT VLCMetaCache::store(Kind kind, long index, const std::string& s, BSTR *val)
+{
+    *val = BSTRFromCStr(CP_UTF8, s.c_str());
+    if( NULL == *val )
+        return E_OUTOFMEMORY;
+
+    // an invalidation after the miss may come from a change read above,
+    // the cache then refuses the copy
+    BSTR cached = SysAllocStringLen(*val, SysStringLen(*val));
+    if( cached && !_entries.insert(key(kind, index), cached) )
+        SysFreeString(cached);
+    return S_OK;
+}
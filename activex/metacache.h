@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * metacache.h: converted meta and track strings for scripts
+ *****************************************************************************
+ * Copyright (C) 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef __METACACHE_H__
+#define __METACACHE_H__
+
+#include <ole2.h>
+
+#include <string>
+
+#include "../common/generation_cache.h"
+#include "../common/vlc_player.h"
+
+/*
+ * Strings handed to scripts, kept as BSTR once converted so that reading
+ * the same meta or track name again costs a copy of the cached buffer
+ * instead of a libvlc query and a UTF-8 conversion.
+ *
+ * invalidate() may be called from any thread, libvlc event callbacks use
+ * it; the entries are dropped by the next lookup. Lookups and stores run
+ * on the control's thread.
+ */
+class VLCMetaCache
+{
+public:
+    enum Kind
+    {
+        MetaKind,           // meta of the media given to lookupMeta()
+        AudioTrackKind,     // audio track names while playing
+        TitleKind,          // title names
+    };
+
+    VLCMetaCache();
+    ~VLCMetaCache();
+
+    void invalidate()
+        { _entries.invalidate(); }
+
+    // invalidates the cache whatever it is called with, for event handlers
+    struct Invalidator
+    {
+        VLCMetaCache *cache;
+        template <typename... Args>
+        void operator()(Args&&...) const
+            { cache->invalidate(); }
+    };
+    Invalidator invalidator()
+        { return Invalidator{ this }; }
+
+    // copies the cached string to *val, false on a miss
+    bool lookup(Kind kind, long index, BSTR *val);
+    // as lookup(), drops the Meta entries first if they belong to another
+    // media and watches its meta changes from then on
+    bool lookupMeta(const VLC::MediaPtr& media, libvlc_meta_t meta, BSTR *val);
+
+    // converts s, caches it unless the cache was invalidated since the
+    // lookup that missed, and returns a copy in *val
+    HRESULT store(Kind kind, long index, const std::string& s, BSTR *val);
+
+private:
+    static unsigned long long key(Kind kind, long index)
+        { return (unsigned long long)kind << 32 | (unsigned long)index; }
+
+    struct FreeBSTR
+    {
+        void operator()(BSTR s) const
+            { SysFreeString(s); }
+    };
+
+    generation_cache<unsigned long long, BSTR, FreeBSTR> _entries;
+
+    VLC::MediaPtr _media;
+    VLC::MediaEventManager::RegisteredEvent _metaChanged;
+};
+
+#endif
@@ -30,6 +30,8 @@
 #include "utils.h"
 #include "oleobject.h"
 
+#include "../common/property_schema.h"
+
 using namespace std;
 
 STDMETHODIMP VLCPersistPropertyBag::GetClassID(LPCLSID pClsID)
@@ -47,309 +49,210 @@ STDMETHODIMP VLCPersistPropertyBag::InitNew(void)
     return _p_instance->onInit();
 };
 
-STDMETHODIMP VLCPersistPropertyBag::Load(LPPROPERTYBAG pPropBag, LPERRORLOG pErrorLog)
+// variant type properties of type t are read and written as
+static VARTYPE variantType(vlc_property_type_e t)
 {
-    HRESULT hr = _p_instance->onInit();
-    if( FAILED(hr) )
-        return hr;
-
-    if( NULL == pPropBag )
-        return E_INVALIDARG;
-
-    VARIANT value;
-
-    V_VT(&value) = VT_BSTR;
-    if( S_OK == pPropBag->Read(OLESTR("mrl"), &value, pErrorLog) )
-    {
-        _p_instance->setMRL(V_BSTR(&value));
-        VariantClear(&value);
-    }
-    else
-    {
-        /*
-        ** try alternative syntax
-        */
-        V_VT(&value) = VT_BSTR;
-        if( S_OK == pPropBag->Read(OLESTR("src"), &value, pErrorLog) )
-        {
-            _p_instance->setMRL(V_BSTR(&value));
-            VariantClear(&value);
-        }
-        else
-        {
-            V_VT(&value) = VT_BSTR;
-            if( S_OK == pPropBag->Read(OLESTR("filename"), &value, pErrorLog) )
-            {
-                _p_instance->setMRL(V_BSTR(&value));
-                VariantClear(&value);
-            }
-            else
-            {
-                V_VT(&value) = VT_BSTR;
-                if( S_OK == pPropBag->Read(OLESTR("target"), &value, pErrorLog) )
-                {
-                    _p_instance->setMRL(V_BSTR(&value));
-                    VariantClear(&value);
-                }
-            }
-        }
-    }
-
-    V_VT(&value) = VT_BOOL;
-    if( S_OK == pPropBag->Read(OLESTR("autoplay"), &value, pErrorLog) )
+    switch( t )
     {
-        _p_instance->setAutoPlay(V_BOOL(&value) != VARIANT_FALSE);
-        VariantClear(&value);
-    }
-    else
-    {
-        /*
-        ** try alternative syntax
-        */
-        V_VT(&value) = VT_BOOL;
-        if( S_OK == pPropBag->Read(OLESTR("autostart"), &value, pErrorLog) )
-        {
-            _p_instance->setAutoPlay(V_BOOL(&value) != VARIANT_FALSE);
-            VariantClear(&value);
-        }
+    case pt_bool:
+        return VT_BOOL;
+    case pt_int:
+        return VT_I4;
+    default:
+        return VT_BSTR;
     }
+}
 
-    V_VT(&value) = VT_BOOL;
-    if( S_OK == pPropBag->Read(OLESTR("toolbar"), &value, pErrorLog) )
-    {
-        _p_instance->setShowToolbar(V_BOOL(&value) != VARIANT_FALSE);
-        VariantClear(&value);
-    }
-    else
+static void propertyName(const char *name, WCHAR *wname, size_t size)
+{
+    size_t i = 0;
+    for( ; name[i] && i + 1 < size; ++i )
+        wname[i] = name[i];
+    wname[i] = L'\0';
+}
+
+// value holds the canonical type of the property
+static void stageProperty(VLCStagedProperties& staged, vlc_property_e id, VARIANT& value)
+{
+    switch( V_VT(&value) )
     {
-        /*
-        ** try alternative syntax
-        */
-        V_VT(&value) = VT_BOOL;
-        if( S_OK == pPropBag->Read(OLESTR("controls"), &value, pErrorLog) )
-        {
-            _p_instance->setShowToolbar(V_BOOL(&value) != VARIANT_FALSE);
-            VariantClear(&value);
-        }
+    case VT_BSTR:
+        SysFreeString(staged.strings[id]);
+        // the staged copy takes the string over
+        staged.strings[id] = V_BSTR(&value);
+        V_VT(&value) = VT_EMPTY;
+        break;
+    case VT_BOOL:
+        staged.values[id] = V_BOOL(&value) != VARIANT_FALSE;
+        break;
+    case VT_I4:
+        staged.values[id] = V_I4(&value);
+        break;
+    default:
+        return;
     }
+    staged.present |= 1u << id;
+}
 
-    SIZEL size = _p_instance->getExtent();
-    V_VT(&value) = VT_I4;
-    if( S_OK == pPropBag->Read(OLESTR("extentwidth"), &value, pErrorLog) )
+static void getProperty(VLCPlugin *p, vlc_property_e id, VARIANT& value)
+{
+    V_VT(&value) = variantType(property_schema[id].type);
+    switch( id )
     {
-         size.cx = V_I4(&value);
-        VariantClear(&value);
+    case pp_mrl:
+        V_BSTR(&value) = SysAllocStringLen(p->getMRL(), SysStringLen(p->getMRL()));
+        break;
+    case pp_autoplay:
+        V_BOOL(&value) = p->getAutoPlay() ? VARIANT_TRUE : VARIANT_FALSE;
+        break;
+    case pp_toolbar:
+        V_BOOL(&value) = p->getShowToolbar() ? VARIANT_TRUE : VARIANT_FALSE;
+        break;
+    case pp_extent_width:
+        V_I4(&value) = p->getExtent().cx;
+        break;
+    case pp_extent_height:
+        V_I4(&value) = p->getExtent().cy;
+        break;
+    case pp_autoloop:
+        V_BOOL(&value) = p->getAutoLoop() ? VARIANT_TRUE : VARIANT_FALSE;
+        break;
+    case pp_visible:
+        V_BOOL(&value) = p->getVisible() ? VARIANT_TRUE : VARIANT_FALSE;
+        break;
+    case pp_volume:
+        V_I4(&value) = p->getVolume();
+        break;
+    case pp_start_time:
+        V_I4(&value) = p->getStartTime();
+        break;
+    case pp_base_url:
+        V_BSTR(&value) = SysAllocStringLen(p->getBaseURL(), SysStringLen(p->getBaseURL()));
+        break;
+    case pp_back_color:
+        V_I4(&value) = p->getBackColor();
+        break;
+    case pp_fullscreen_enabled:
+        V_BOOL(&value) = p->get_options().get_enable_fs() ? VARIANT_TRUE : VARIANT_FALSE;
+        break;
+    case pp_branding:
+        V_BOOL(&value) = p->get_options().get_enable_branding() ? VARIANT_TRUE : VARIANT_FALSE;
+        break;
+    case pp_resume_playback:
+        V_BOOL(&value) = p->get_options().get_resume_playback() ? VARIANT_TRUE : VARIANT_FALSE;
+        break;
+    default:
+        V_VT(&value) = VT_EMPTY;
+        break;
     }
-    V_VT(&value) = VT_I4;
-    if( S_OK == pPropBag->Read(OLESTR("extentheight"), &value, pErrorLog) )
-    {
-         size.cy = V_I4(&value);
-        VariantClear(&value);
-    }
-    _p_instance->setExtent(size);
+}
 
-    V_VT(&value) = VT_BOOL;
-    if( S_OK == pPropBag->Read(OLESTR("autoloop"), &value, pErrorLog) )
-    {
-        _p_instance->setAutoLoop(V_BOOL(&value) != VARIANT_FALSE);
-        VariantClear(&value);
-    }
-    else
+// value as returned by getProperty
+// the schema gives the default extent in pixels, the control keeps and
+// saves it in HIMETRIC, converted as onInit() does
+static LONG defaultExtent(vlc_property_e id)
+{
+    POINT extent = { property_schema[pp_extent_width].default_value,
+                     property_schema[pp_extent_height].default_value };
+    HDC hDC = CreateDevDC(NULL);
+    HimetricFromDP(hDC, &extent, 1);
+    DeleteDC(hDC);
+    return id == pp_extent_width ? extent.x : extent.y;
+}
+
+static bool isDefaultValue(vlc_property_e id, const VARIANT& value)
+{
+    switch( V_VT(&value) )
     {
-        /*
-        ** try alternative syntax
-        */
-        V_VT(&value) = VT_BOOL;
-        if( S_OK == pPropBag->Read(OLESTR("loop"), &value, pErrorLog) )
-        {
-            _p_instance->setAutoLoop(V_BOOL(&value) != VARIANT_FALSE);
-            VariantClear(&value);
-        }
+    case VT_BSTR:
+        return 0 == SysStringLen(V_BSTR(&value));
+    case VT_BOOL:
+        return (V_BOOL(&value) != VARIANT_FALSE) == (property_schema[id].default_value != 0);
+    case VT_I4:
+        if( id == pp_extent_width || id == pp_extent_height )
+            return V_I4(&value) == defaultExtent(id);
+        return V_I4(&value) == property_schema[id].default_value;
+    default:
+        return false;
     }
+}
 
-    V_VT(&value) = VT_BOOL;
-    if( S_OK == pPropBag->Read(OLESTR("mute"), &value, pErrorLog) )
-    {
-        _p_instance->setMute(V_BOOL(&value) != VARIANT_FALSE);
-        VariantClear(&value);
-    }
+STDMETHODIMP VLCPersistPropertyBag::Load(LPPROPERTYBAG pPropBag, LPERRORLOG pErrorLog)
+{
+    HRESULT hr = _p_instance->onInit();
+    if( FAILED(hr) )
+        return hr;
 
-    V_VT(&value) = VT_BOOL;
-    if( S_OK == pPropBag->Read(OLESTR("visible"), &value, pErrorLog) )
-    {
-        _p_instance->setVisible(V_BOOL(&value) != VARIANT_FALSE);
-        VariantClear(&value);
-    }
-    else
-    {
-        /*
-        ** try alternative syntax
-        */
-        V_VT(&value) = VT_BOOL;
-        if( S_OK == pPropBag->Read(OLESTR("showdisplay"), &value, pErrorLog) )
-        {
-            _p_instance->setVisible(V_BOOL(&value) != VARIANT_FALSE);
-            VariantClear(&value);
-        }
-    }
+    if( NULL == pPropBag )
+        return E_INVALIDARG;
 
-    V_VT(&value) = VT_I4;
-    if( S_OK == pPropBag->Read(OLESTR("volume"), &value, pErrorLog) )
-    {
-        _p_instance->setVolume(V_I4(&value));
-        VariantClear(&value);
-    }
+    // values are only staged here, onLoad applies them in one batch
+    VLCStagedProperties& staged = _p_instance->getStagedProperties();
 
-    V_VT(&value) = VT_I4;
-    if( S_OK == pPropBag->Read(OLESTR("starttime"), &value, pErrorLog) )
+    // names come grouped by property, skip the aliases once one was read
+    bool loaded[pp_count] = { };
+    for( size_t i = 0; i < property_names_count; ++i )
     {
-        _p_instance->setStartTime(V_I4(&value));
-        VariantClear(&value);
-    }
+        const vlc_property_name& prop = property_names[i];
+        if( loaded[prop.id] )
+            continue;
 
-    V_VT(&value) = VT_BSTR;
-    if( S_OK == pPropBag->Read(OLESTR("baseurl"), &value, pErrorLog) )
-    {
-        _p_instance->setBaseURL(V_BSTR(&value));
-        VariantClear(&value);
-    }
+        WCHAR name[32];
+        propertyName(prop.name, name, ARRAY_SIZE(name));
 
-    V_VT(&value) = VT_I4;
-    if( S_OK == pPropBag->Read(OLESTR("backcolor"), &value, pErrorLog) )
-    {
-        _p_instance->setBackColor(V_I4(&value));
-        VariantClear(&value);
-    }
-    else
-    {
-        /*
-        ** try alternative syntax
-        */
-        V_VT(&value) = VT_BSTR;
-        if( S_OK == pPropBag->Read(OLESTR("bgcolor"), &value, pErrorLog) )
-        {
-            long backcolor;
-            if( swscanf(V_BSTR(&value), L"#%lX", &backcolor) )
-            {
-                _p_instance->setBackColor(backcolor);
-            }
-            VariantClear(&value);
-        }
-    }
+        VARIANT value;
+        V_VT(&value) = variantType(prop.type);
+        if( S_OK != pPropBag->Read(name, &value, pErrorLog) )
+            continue;
+        loaded[prop.id] = true;
 
-    V_VT(&value) = VT_BOOL;
-    if( S_OK == pPropBag->Read(OLESTR("FullscreenEnabled"), &value, pErrorLog) )
-    {
-        _p_instance->get_options().set_enable_fs(V_BOOL(&value) != VARIANT_FALSE);
-        VariantClear(&value);
-    }
-    else
-    {
-        /*
-        ** try alternative syntax
-        */
-        V_VT(&value) = VT_BOOL;
-        if( S_OK == pPropBag->Read(OLESTR("allowfullscreen"), &value, pErrorLog) )
+        if( pt_html_color == prop.type )
         {
-            _p_instance->get_options().set_enable_fs(V_BOOL(&value) != VARIANT_FALSE);
+            long color;
+            bool valid = 1 == swscanf(V_BSTR(&value), L"#%lX", &color);
             VariantClear(&value);
+            if( !valid )
+                continue;
+            V_VT(&value) = VT_I4;
+            V_I4(&value) = color;
         }
-        else
-        {
-            V_VT(&value) = VT_BOOL;
-            if( S_OK == pPropBag->Read(OLESTR("fullscreen"), &value, pErrorLog) )
-            {
-                _p_instance->get_options().set_enable_fs(V_BOOL(&value) != VARIANT_FALSE);
-                VariantClear(&value);
-            }
-        }
-    }
-
-    V_VT(&value) = VT_BOOL;
-    if( S_OK == pPropBag->Read(OLESTR("Branding"), &value, pErrorLog) )
-    {
-        _p_instance->get_options().set_enable_branding(V_BOOL(&value) != VARIANT_FALSE);
+        stageProperty(staged, prop.id, value);
         VariantClear(&value);
     }
 
     return _p_instance->onLoad();
 };
 
-STDMETHODIMP VLCPersistPropertyBag::Save(LPPROPERTYBAG pPropBag, BOOL fClearDirty, BOOL)
+STDMETHODIMP VLCPersistPropertyBag::Save(LPPROPERTYBAG pPropBag, BOOL fClearDirty, BOOL fSaveAllProperties)
 {
     if( NULL == pPropBag )
         return E_INVALIDARG;
 
-    VARIANT value;
-
-    VariantInit(&value);
-
-    V_VT(&value) = VT_BOOL;
-    V_BOOL(&value) = _p_instance->getAutoLoop()? VARIANT_TRUE : VARIANT_FALSE;
-    pPropBag->Write(OLESTR("AutoLoop"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_BOOL;
-    V_BOOL(&value) = _p_instance->getAutoPlay()? VARIANT_TRUE : VARIANT_FALSE;
-    pPropBag->Write(OLESTR("AutoPlay"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_BOOL;
-    V_BOOL(&value) = _p_instance->getShowToolbar()? VARIANT_TRUE : VARIANT_FALSE;
-    pPropBag->Write(OLESTR("Toolbar"), &value);
-    VariantClear(&value);
-
-    SIZEL size = _p_instance->getExtent();
-    V_VT(&value) = VT_I4;
-    V_I4(&value) = size.cx;
-    pPropBag->Write(OLESTR("ExtentWidth"), &value);
-    V_I4(&value) = size.cy;
-    pPropBag->Write(OLESTR("ExtentHeight"), &value);
-
-    V_VT(&value) = VT_BSTR;
-    V_BSTR(&value) = SysAllocStringLen(_p_instance->getMRL(),
-                            SysStringLen(_p_instance->getMRL()));
-    pPropBag->Write(OLESTR("MRL"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_BOOL;
-    V_BOOL(&value) = _p_instance->getVisible()? VARIANT_TRUE : VARIANT_FALSE;
-    pPropBag->Write(OLESTR("Visible"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_I4;
-    V_I4(&value) = _p_instance->getVolume();
-    pPropBag->Write(OLESTR("Volume"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_I4;
-    V_I4(&value) = _p_instance->getStartTime();
-    pPropBag->Write(OLESTR("StartTime"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_BSTR;
-    V_BSTR(&value) = SysAllocStringLen(_p_instance->getBaseURL(),
-                            SysStringLen(_p_instance->getBaseURL()));
-    pPropBag->Write(OLESTR("BaseURL"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_I4;
-    V_I4(&value) = _p_instance->getBackColor();
-    pPropBag->Write(OLESTR("BackColor"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_BOOL;
-    V_BOOL(&value) = _p_instance->get_options().get_enable_fs()? VARIANT_TRUE : VARIANT_FALSE;
-    pPropBag->Write(OLESTR("FullscreenEnabled"), &value);
-    VariantClear(&value);
-
-    V_VT(&value) = VT_BOOL;
-    V_BOOL(&value) = _p_instance->get_options().get_enable_branding()? VARIANT_TRUE : VARIANT_FALSE;
-    pPropBag->Write(OLESTR("Branding"), &value);
-    VariantClear(&value);
+    for( int id = 0; id < pp_count; ++id )
+    {
+        const char *saved_name = property_schema[id].saved_name;
+        if( NULL == saved_name )
+            continue;
+
+        VARIANT value;
+        VariantInit(&value);
+        getProperty(_p_instance, vlc_property_e(id), value);
+
+        /* unless asked for everything only changed properties are written,
+        ** and those not at their default, so a bag that was not filled by
+        ** a previous save still gets the full state */
+        if( fSaveAllProperties || _p_instance->isDirty(vlc_property_e(id))
+         || !isDefaultValue(vlc_property_e(id), value) )
+        {
+            WCHAR name[32];
+            propertyName(saved_name, name, ARRAY_SIZE(name));
+            pPropBag->Write(name, &value);
+        }
+        VariantClear(&value);
+    }
 
     if( fClearDirty )
-        _p_instance->setDirty(FALSE);
+        _p_instance->clearDirty();
 
     return S_OK;
 };
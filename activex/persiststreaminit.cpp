@@ -28,13 +28,17 @@
 #include "persiststreaminit.h"
 
 #include "utils.h"
-#include <map>
-#include <vector>
+#include "../common/folded_name_map.h"
+#include "../common/property_blob.h"
 
+#include <utility>
+#include <vector>
 #include <wchar.h>
 
 using namespace std;
 
+static_assert(sizeof(WCHAR) == sizeof(char16_t), "property names are UTF-16");
+
 class AxVLCVariant
 {
 
@@ -68,27 +72,36 @@ public:
         VariantCopy(&_v, const_cast<VARIANTARG *>(&(vv._v)));
     };
 
-    AxVLCVariant(int i)
+    AxVLCVariant(AxVLCVariant &&vv)
     {
-        V_VT(&_v) = VT_I4;
-        V_I4(&_v) = i;
+        _v = vv._v;
+        VariantInit(&vv._v);
     };
 
-    AxVLCVariant(BSTR bstr)
+    AxVLCVariant& operator=(AxVLCVariant vv)
     {
-        VARIANT arg;
-        V_VT(&arg) = VT_BSTR;
-        V_BSTR(&arg) = bstr;
-        VariantInit(&_v);
-        VariantCopy(&_v, &arg);
-        VariantClear(&arg);
+        swap(*this, vv);
+        return *this;
+    };
+
+    AxVLCVariant(int i)
+    {
+        V_VT(&_v) = VT_I4;
+        V_I4(&_v) = i;
     };
 
     inline const VARIANTARG *variantArg(void) const {
         return &_v;
     }
 
-    inline void swap(AxVLCVariant &v1, AxVLCVariant &v2)
+    // takes ownership of the content of v
+    inline void attach(VARIANTARG &v)
+    {
+        VariantClear(&_v);
+        _v = v;
+    }
+
+    friend inline void swap(AxVLCVariant &v1, AxVLCVariant &v2)
     {
         VARIANTARG tmp = v1._v;
         v1._v = v2._v;
@@ -100,106 +113,12 @@ private:
     VARIANTARG _v;
 };
 
-class AxVLCWSTR
-{
-
-public:
-
-    AxVLCWSTR(void) : _data(NULL) {};
-
-    virtual ~AxVLCWSTR()
-    {
-        if( NULL != _data )
-        {
-            ULONG refcount = InterlockedDecrement(&(_data->refcount));
-            if( 0 == refcount )
-                CoTaskMemFree(_data);
-        }
-    };
-
-    AxVLCWSTR(LPCWSTR s)
-    {
-        if( NULL != s )
-        {
-            size_t len = wcslen(s);
-            if( len > 0 )
-            {
-                size_t size = len*sizeof(WCHAR);
-                _data = (struct data *)CoTaskMemAlloc(sizeof(struct data)+size);
-                if( NULL != _data )
-                {
-                    _data->len = len;
-                    _data->refcount = 1;
-                    memcpy(_data->wstr, s, size);
-                    _data->wstr[len]=L'\0';
-                    return;
-                }
-            }
-        }
-        _data = NULL;
-    };
+typedef folded_name_map<AxVLCVariant> AxVLCPropertyMap;
 
-    AxVLCWSTR(const AxVLCWSTR &s)
-    {
-        _data = s._data;
-        if( NULL != _data )
-            InterlockedIncrement(&(_data->refcount));
-    };
-
-    inline bool operator<(const AxVLCWSTR &s) const
-    {
-        return compareNoCase(s.wstr()) < 0;
-    };
-
-    inline bool operator<(LPCWSTR s) const
-    {
-        return compareNoCase(s) < 0;
-    };
-
-    inline bool operator==(const AxVLCWSTR &s) const
-    {
-        return size() == s.size() ?
-                    (compareNoCase(s.wstr()) == 0) : false;
-    };
-
-    inline bool operator==(LPCWSTR s) const
-    {
-        return compareNoCase(s) == 0;
-    };
-
-    LPCWSTR wstr(void) const
-    {
-        return (NULL != _data) ? _data->wstr : NULL;
-    };
-
-    size_t size(void) const
-    {
-        return (NULL != _data) ? _data->len : 0;
-    };
-
-private:
-
-    inline int compareNoCase(LPCWSTR s) const
-    {
-        if( NULL == _data )
-        {
-            return (NULL == s) ? 0 : -1;
-        }
-        if( NULL == s )
-            return 1;
-
-        return _wcsicmp(_data->wstr, s);
-    };
-
-    struct data {
-        size_t  len;
-        LONG    refcount;
-        wchar_t wstr[1];
-    } *_data;
-};
-
-typedef pair<class AxVLCWSTR, class AxVLCVariant> AxVLCPropertyPair;
-typedef map<class AxVLCWSTR, class AxVLCVariant> AxVLCPropertyMap;
+static inline const char16_t *u16(LPCOLESTR s)
+{
+    return reinterpret_cast<const char16_t *>(s);
+}
 
 ///////////////////////////
 
@@ -248,24 +167,24 @@ public:
         if( (NULL == pszPropName) || (NULL == pVar) )
             return E_POINTER;
 
-        AxVLCPropertyMap::const_iterator notfound = _pm.end();
-        AxVLCPropertyMap::const_iterator iter = _pm.find(pszPropName);
-        if( notfound != iter )
+        const AxVLCVariant *prop = _pm.find(u16(pszPropName), wcslen(pszPropName));
+        if( NULL == prop )
+            return E_INVALIDARG;
+
+        // converts straight from the stored value, no intermediate copy
+        VARIANTARG *stored = const_cast<VARIANTARG*>(prop->variantArg());
+        VARTYPE vtype = V_VT(pVar);
+        VARIANTARG v;
+        VariantInit(&v);
+        HRESULT result = (V_VT(stored) == vtype) ? VariantCopy(&v, stored)
+                                                 : VariantChangeType(&v, stored, 0, vtype);
+        if( FAILED(result) )
         {
-            VARTYPE vtype = V_VT(pVar);
-            VARIANTARG v;
-            VariantInit(&v);
-            VariantCopy(&v, const_cast<VARIANTARG*>((*iter).second.variantArg()));
-            if( (V_VT(&v) != vtype) && FAILED(VariantChangeType(&v, &v, 0, vtype)) )
-            {
-                VariantClear(&v);
-                return E_FAIL;
-            }
-            *pVar = v;
-            return S_OK;
+            VariantClear(&v);
+            return E_FAIL;
         }
-        else
-            return E_INVALIDARG;
+        *pVar = v;
+        return S_OK;
     };
  
     STDMETHODIMP Write(LPCOLESTR pszPropName, VARIANT *pVar)
@@ -273,11 +192,7 @@ public:
         if( (NULL == pszPropName) || (NULL == pVar) )
             return E_POINTER;
 
-        AxVLCPropertyPair val(pszPropName, pVar);
-        pair<AxVLCPropertyMap::iterator, bool> p = _pm.insert(val);
-        if( false == p.second )
-            // replace existing key value
-            (*p.first).second = val.second;
+        _pm.assign(u16(pszPropName), wcslen(pszPropName), AxVLCVariant(pVar));
         return S_OK;
     };
 
@@ -288,29 +203,32 @@ public:
         if( NULL == pStm )
             return E_INVALIDARG;
 
-        HRESULT result;
+        ULARGE_INTEGER start;
+        vector<unsigned char> blob;
+        bool seekable = ReadRemaining(pStm, blob, start);
 
-        AxVLCPropertyPair *val;
-        result = ReadProperty(pStm, &val);
-        if( SUCCEEDED(result) )
+        vector<property_record> records;
+        size_t consumed;
+        if( !read_property_blob(blob.empty() ? NULL : &blob[0], blob.size(),
+                                records, consumed) )
+            return E_FAIL;
+
+        HRESULT result = S_OK;
+        for( auto& record : records )
         {
-            if( (val->first == L"(Count)") && (VT_I4 == V_VT(val->second.variantArg())) )
-            {
-                size_t count = V_I4(val->second.variantArg());
-                delete val;
-                while( count-- )
-                {
-                    result = ReadProperty(pStm, &val);
-                    if( FAILED(result) )
-                        return result;
-
-                    pair<AxVLCPropertyMap::iterator, bool> p = _pm.insert(*val);
-                    if( false == p.second )
-                        // replace existing key value
-                        (*p.first).second = val->second;
-                    delete val;
-                }
-            }
+            AxVLCVariant value;
+            result = RecordValue(record, value);
+            if( FAILED(result) )
+                break;
+            _pm.assign(record.name.data(), record.name.size(), std::move(value));
+        }
+
+        // leave the stream right after the properties, as if read in place
+        if( seekable )
+        {
+            LARGE_INTEGER end;
+            end.QuadPart = start.QuadPart + consumed;
+            pStm->Seek(end, STREAM_SEEK_SET, NULL);
         }
         return result;
     };
@@ -320,167 +238,112 @@ public:
         if( NULL == pStm )
             return E_INVALIDARG;
 
-        HRESULT result;
-
-        AxVLCPropertyPair header(L"(Count)", _pm.size());
-        result = WriteProperty(pStm, header);
-        if( SUCCEEDED(result) )
+        property_blob_writer writer;
+        for( const auto& prop : _pm )
         {
-            AxVLCPropertyMap::const_iterator iter = _pm.begin();
-            AxVLCPropertyMap::const_iterator end  = _pm.end();
-
-            while( iter != end )
+            const char16_t *name = prop.name.data();
+            size_t len = prop.name.size();
+            const VARIANTARG *value = prop.value.variantArg();
+            bool added;
+            switch( V_VT(value) )
             {
-                result = WriteProperty(pStm, *(iter++));
-                if( FAILED(result) )
-                    return result;
+                case VT_BOOL:
+                    added = writer.add_bool(name, len, V_BOOL(value) != VARIANT_FALSE);
+                    break;
+                case VT_I4:
+                    added = writer.add_int(name, len, V_I4(value));
+                    break;
+                case VT_BSTR:
+                    added = writer.add_string(name, len, u16(V_BSTR(value)),
+                                              SysStringLen(V_BSTR(value)));
+                    break;
+                default:
+                    added = writer.add_empty(name, len);
+                    break;
             }
+            if( !added )
+                return E_INVALIDARG;
         }
-        return result;
+        writer.finish();
+        return pStm->Write(writer.data(), (ULONG)writer.size(), NULL);
     };
 
     BOOL IsEmpty()
     {
-        return _pm.size() == 0;
+        return _pm.empty();
     }
 
 private:
 
-    HRESULT WriteProperty(LPSTREAM pStm, const AxVLCPropertyPair &prop)
+    /* reads everything left in the stream, with a single Read when its
+     * size is known; returns whether the stream can be rewound to start */
+    static bool ReadRemaining(LPSTREAM pStm, vector<unsigned char> &blob,
+                              ULARGE_INTEGER &start)
     {
-        HRESULT result;
-
-        const AxVLCWSTR propName = prop.first;
-
-        ULONG len = propName.size();
-
-        if( 0 == len )
-            return E_INVALIDARG;
-
-        result = pStm->Write(&len, sizeof(len), NULL);
-        if( FAILED(result) )
-            return result;
-
-        result = pStm->Write(propName.wstr(), len*sizeof(WCHAR), NULL);
-        if( FAILED(result) )
-            return result;
+        LARGE_INTEGER zero;
+        zero.QuadPart = 0;
+        bool seekable = SUCCEEDED(pStm->Seek(zero, STREAM_SEEK_CUR, &start));
+
+        STATSTG stat;
+        if( seekable && SUCCEEDED(pStm->Stat(&stat, STATFLAG_NONAME))
+         && stat.cbSize.QuadPart >= start.QuadPart
+         && stat.cbSize.QuadPart - start.QuadPart <= MAXLONG )
+        {
+            ULONG remaining = (ULONG)(stat.cbSize.QuadPart - start.QuadPart);
+            ULONG got = 0;
+            blob.resize(remaining);
+            if( remaining > 0 && FAILED(pStm->Read(&blob[0], remaining, &got)) )
+                got = 0;
+            blob.resize(got);
+            return seekable;
+        }
 
-        const VARIANTARG *propValue = prop.second.variantArg();
-        VARTYPE vtype = V_VT(propValue);
-        switch( vtype )
+        const ULONG chunk = 4096;
+        for( ;; )
         {
-            case VT_BOOL:
-                result = pStm->Write(&vtype, sizeof(vtype), NULL);
-                if( FAILED(result) )
-                    return result;
-                result = pStm->Write(&V_BOOL(propValue), sizeof(V_BOOL(propValue)), NULL);
-                if( FAILED(result) )
-                    return result;
-                break;
-            case VT_I4:
-                result = pStm->Write(&vtype, sizeof(vtype), NULL);
-                if( FAILED(result) )
-                    return result;
-                result = pStm->Write(&V_I4(propValue), sizeof(V_I4(propValue)), NULL);
-                if( FAILED(result) )
-                    return result;
+            size_t size = blob.size();
+            ULONG got = 0;
+            blob.resize(size + chunk);
+            HRESULT result = pStm->Read(&blob[size], chunk, &got);
+            blob.resize(size + got);
+            if( FAILED(result) || got == 0 )
                 break;
-            case VT_BSTR:
-                result = pStm->Write(&vtype, sizeof(vtype), NULL);
-                if( FAILED(result) )
-                    return result;
-                len = SysStringLen(V_BSTR(propValue));
-                result = pStm->Write(&len, sizeof(len), NULL);
-                if( FAILED(result) )
-                    return result;
-                if( len > 0 )
-                {
-                    result = pStm->Write(V_BSTR(propValue), len*sizeof(OLECHAR), NULL);
-                    if( FAILED(result) )
-                        return result;
-                }
-                break;
-            default:
-                vtype = VT_EMPTY;
-                result = pStm->Write(&vtype, sizeof(vtype), NULL);
-                if( FAILED(result) )
-                    return result;
         }
-        return result;
-    };
+        return seekable;
+    }
 
-    HRESULT ReadProperty(LPSTREAM pStm, AxVLCPropertyPair **prop)
+    static HRESULT RecordValue(const property_record &record, AxVLCVariant &value)
     {
-        HRESULT result;
-        ULONG len;
-        *prop = NULL;
-
-        result = pStm->Read(&len, sizeof(len), NULL);
-        if( FAILED(result) )
-            return result;
-
-        if( 0 == len )
-            return E_INVALIDARG;
-
-        vector<WCHAR> propNameBuf(len + 1, 0);
-        WCHAR* propName = &propNameBuf[0];
-
-        result = pStm->Read(propName, len*sizeof(WCHAR), NULL);
-        if( FAILED(result) )
-            return result;
-
-        propName[len] = L'\0';
-
-        VARIANTARG propValue;
-
-        VARTYPE vtype;
-        result = pStm->Read(&vtype, sizeof(vtype), NULL);
-        if( FAILED(result) )
-            return result;
-
-        switch( vtype )
+        VARIANTARG v;
+        VariantInit(&v);
+        switch( record.type )
         {
-            case VT_BOOL:
-                V_VT(&propValue) = vtype;
-                result = pStm->Read(&V_BOOL(&propValue), sizeof(V_BOOL(&propValue)), NULL);
-                if( FAILED(result) )
-                    return result;
+            case prt_bool:
+                V_VT(&v) = VT_BOOL;
+                V_BOOL(&v) = record.int_value ? VARIANT_TRUE : VARIANT_FALSE;
                 break;
-            case VT_I4:
-                V_VT(&propValue) = vtype;
-                result = pStm->Read(&V_I4(&propValue), sizeof(V_I4(&propValue)), NULL);
-                if( FAILED(result) )
-                    return result;
+            case prt_int:
+                V_VT(&v) = VT_I4;
+                V_I4(&v) = record.int_value;
                 break;
-            case VT_BSTR:
-                V_VT(&propValue) = vtype;
-                result = pStm->Read(&len, sizeof(len), NULL);
-                if( FAILED(result) )
-                    return result;
-
-                V_BSTR(&propValue) = NULL;
-                if( len > 0 )
+            case prt_string:
+                V_VT(&v) = VT_BSTR;
+                V_BSTR(&v) = NULL;
+                if( !record.string_value.empty() )
                 {
-                    V_BSTR(&propValue) = SysAllocStringLen(NULL, len);
-                    if( NULL == V_BSTR(&propValue) )
+                    V_BSTR(&v) = SysAllocStringLen(
+                        reinterpret_cast<const OLECHAR *>(record.string_value.data()),
+                        record.string_value.size());
+                    if( NULL == V_BSTR(&v) )
                         return E_OUTOFMEMORY;
-
-                    result = pStm->Read(V_BSTR(&propValue), len*sizeof(OLECHAR), NULL);
-                    if( FAILED(result) )
-                    {
-                        SysFreeString(V_BSTR(&propValue));
-                        return result;
-                    }
                 }
                 break;
             default:
-                VariantInit(&propValue);
+                break;
         }
-
-        *prop = new AxVLCPropertyPair(propName, propValue);
-
+        value.attach(v);
         return S_OK;
-    };
+    }
 
     AxVLCPropertyMap _pm;
     LONG _i_ref;
@@ -534,14 +397,18 @@ STDMETHODIMP VLCPersistStreamInit::Save(LPSTREAM pStm, BOOL fClearDirty)
     if( NULL == pStm )
         return E_INVALIDARG;
 
-    LPPERSISTPROPERTYBAG pPersistPropBag;
-    if( FAILED(QueryInterface(IID_IPersistPropertyBag, (void**)&pPersistPropBag)) )
-        return E_FAIL;
+    // the retained bag already holds whatever did not change since
+    if( _p_instance->isDirty() || _p_props->IsEmpty() )
+    {
+        LPPERSISTPROPERTYBAG pPersistPropBag;
+        if( FAILED(QueryInterface(IID_IPersistPropertyBag, (void**)&pPersistPropBag)) )
+            return E_FAIL;
 
-    HRESULT result = pPersistPropBag->Save(_p_props, fClearDirty, _p_props->IsEmpty());
-    pPersistPropBag->Release();
-    if( FAILED(result) )
-        return result;
+        HRESULT result = pPersistPropBag->Save(_p_props, fClearDirty, _p_props->IsEmpty());
+        pPersistPropBag->Release();
+        if( FAILED(result) )
+            return result;
+    }
 
     return _p_props->Save(pStm);
 };
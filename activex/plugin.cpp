@@ -43,6 +43,7 @@
 #include "supporterrorinfo.h"
 
 #include "utils.h"
+#include "../common/property_schema.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -298,6 +299,9 @@ VLCPlugin::VLCPlugin(VLCPluginClass *p_class, LPUNKNOWN pUnkOuter) :
 
 VLCPlugin::~VLCPlugin()
 {
+    // the command worker fires events through the connection points
+    m_player.shutdown_commands();
+
     delete vlcSupportErrorInfo;
     delete vlcOleObject;
     delete vlcDataObject;
@@ -393,27 +397,38 @@ STDMETHODIMP_(ULONG) VLCPlugin::Release(void)
 
 HRESULT VLCPlugin::onInit(void)
 {
-    // initialize persistable properties
-    set_autoplay(true);
-    _b_autoloop   = FALSE;
+    // initialize persistable properties, the player is not open yet so
+    // the fields are set directly instead of through the setters
+    const vlc_property_info *defaults = property_schema;
+    set_autoplay(defaults[pp_autoplay].default_value != 0);
+    set_show_toolbar(defaults[pp_toolbar].default_value != 0);
+    set_enable_fs(defaults[pp_fullscreen_enabled].default_value != 0);
+    set_enable_branding(defaults[pp_branding].default_value != 0);
+    set_resume_playback(defaults[pp_resume_playback].default_value != 0);
+    _b_autoloop   = defaults[pp_autoloop].default_value;
     _bstr_baseurl = NULL;
+    _b_baseurl_parsed = FALSE;
     _bstr_mrl     = NULL;
-    _b_visible    = TRUE;
-    _b_mute       = FALSE;
-    _i_volume     = 100;
-    _i_time       = 0;
-    _i_backcolor  = 0;
-    // set default/preferred size (320x240) pixels in HIMETRIC
+    _b_visible    = defaults[pp_visible].default_value;
+    _b_mute       = defaults[pp_mute].default_value;
+    _i_volume     = defaults[pp_volume].default_value;
+    _i_time       = defaults[pp_start_time].default_value;
+    _i_backcolor  = defaults[pp_back_color].default_value;
+    // set default/preferred size pixels in HIMETRIC
     HDC hDC = CreateDevDC(NULL);
-    _extent.cx = 320;
-    _extent.cy = 240;
+    _extent.cx = defaults[pp_extent_width].default_value;
+    _extent.cy = defaults[pp_extent_height].default_value;
     HimetricFromDP(hDC, (LPPOINT)&_extent, 1);
     DeleteDC(hDC);
+    _staged.clear();
+    clearDirty();
     return S_OK;
 }
 
 HRESULT VLCPlugin::onLoad(void)
 {
+    applyStagedProperties();
+
     if( SysStringLen(_bstr_baseurl) == 0 )
     {
         /*
@@ -440,6 +455,7 @@ HRESULT VLCPlugin::onLoad(void)
                         {
                             /* copy base URL */
                             _bstr_baseurl = SysAllocString(base_url);
+                            _b_baseurl_parsed = FALSE;
                         }
                         CoTaskMemFree(base_url);
                     }
@@ -447,10 +463,81 @@ HRESULT VLCPlugin::onLoad(void)
             }
         }
     }
-    setDirty(FALSE);
+    clearDirty();
     return S_OK;
 }
 
+void VLCPlugin::applyStagedProperties()
+{
+    VLCStagedProperties& p = _staged;
+
+    // string properties change hands, the staged copies are dropped
+    if( p.has(pp_mrl) )
+    {
+        SysFreeString(_bstr_mrl);
+        _bstr_mrl = p.strings[pp_mrl];
+        p.strings[pp_mrl] = NULL;
+    }
+    if( p.has(pp_base_url) )
+    {
+        SysFreeString(_bstr_baseurl);
+        _bstr_baseurl = p.strings[pp_base_url];
+        p.strings[pp_base_url] = NULL;
+        _b_baseurl_parsed = FALSE;
+    }
+
+    if( p.has(pp_autoplay) )
+        set_autoplay(p.values[pp_autoplay] != 0);
+    if( p.has(pp_toolbar) )
+        set_show_toolbar(p.values[pp_toolbar] != 0);
+    if( p.has(pp_fullscreen_enabled) )
+        set_enable_fs(p.values[pp_fullscreen_enabled] != 0);
+    if( p.has(pp_branding) )
+        set_enable_branding(p.values[pp_branding] != 0);
+    if( p.has(pp_resume_playback) )
+        set_resume_playback(p.values[pp_resume_playback] != 0);
+    if( p.has(pp_extent_width) )
+        _extent.cx = p.values[pp_extent_width];
+    if( p.has(pp_extent_height) )
+        _extent.cy = p.values[pp_extent_height];
+    if( p.has(pp_start_time) )
+        _i_time = p.values[pp_start_time];
+    if( p.has(pp_back_color) )
+        _i_backcolor = p.values[pp_back_color];
+    if( p.has(pp_visible) && (p.values[pp_visible] != 0) != (_b_visible != FALSE) )
+        setVisible(p.values[pp_visible] != 0);
+
+    // what reaches the player goes in one batch, defaults are left alone
+    vlc_player_settings settings;
+    settings.set = 0;
+    if( p.has(pp_autoloop) )
+    {
+        _b_autoloop = p.values[pp_autoloop] != 0;
+        settings.loop = _b_autoloop != FALSE;
+        if( settings.loop != (property_schema[pp_autoloop].default_value != 0) )
+            settings.set |= vlc_player_settings::loop_set;
+    }
+    if( p.has(pp_mute) )
+    {
+        _b_mute = p.values[pp_mute] != 0;
+        settings.mute = _b_mute != FALSE;
+        if( settings.mute != (property_schema[pp_mute].default_value != 0) )
+            settings.set |= vlc_player_settings::mute_set;
+    }
+    if( p.has(pp_volume) )
+    {
+        int volume = p.values[pp_volume];
+        _i_volume = volume < 0 ? 0 : volume > 200 ? 200 : volume;
+        settings.volume = _i_volume;
+        if( settings.volume != property_schema[pp_volume].default_value )
+            settings.set |= vlc_player_settings::volume_set;
+    }
+    if( settings.set )
+        m_player.apply_settings(settings);
+
+    p.clear();
+}
+
 void VLCPlugin::initVLC()
 {
     try
@@ -471,9 +558,28 @@ void VLCPlugin::initVLC()
         return;
     }
 
+    // deferred commands complete on the player's worker thread
+    m_player.on_command_done([this](vlc_player_command_e command, int status) {
+        if( command == pc_stop )
+            fireOnMediaPlayerStopAsyncDoneEvent();
+        fireOnMediaPlayerCommandDoneEvent(command, status);
+    });
+
     // register player events
     player_register_events();
 
+    // resume positions are shared by every control of the user, and only
+    // kept for the pages which ask for them through ResumePlayback
+    char path[MAX_PATH];
+    DWORD len = GetEnvironmentVariableA("APPDATA", path, sizeof(path));
+    if( get_resume_playback() && len > 0 && len + sizeof("\\vlc\\axvlc-resume.dat") <= sizeof(path) )
+    {
+        strcat(path, "\\vlc");
+        CreateDirectoryA(path, NULL);
+        strcat(path, "\\axvlc-resume.dat");
+        m_player.open_resume_store(path);
+    }
+
     if( !isInPlaceActive()  )
     {
         LPOLECLIENTSITE pClientSite;
@@ -716,32 +822,8 @@ HRESULT VLCPlugin::onActivateInPlace(LPMSG, HWND hwndParent, LPCRECT lprcPosRect
         // initial playlist item
         if( SysStringLen(_bstr_mrl) > 0 )
         {
-            char *psz_mrl = NULL;
-
-            if( SysStringLen(_bstr_baseurl) > 0 )
-            {
-                /*
-                ** if the MRL a relative URL, we should end up with an absolute URL
-                */
-                LPWSTR abs_url = CombineURL(_bstr_baseurl, _bstr_mrl);
-                if( NULL != abs_url )
-                {
-                    psz_mrl = CStrFromWSTR(CP_UTF8, abs_url, wcslen(abs_url));
-                    CoTaskMemFree(abs_url);
-                }
-                else
-                {
-                    psz_mrl = CStrFromBSTR(CP_UTF8, _bstr_mrl);
-                }
-            }
-            else
-            {
-                /*
-                ** baseURL is empty, assume MRL is absolute
-                */
-                psz_mrl = CStrFromBSTR(CP_UTF8, _bstr_mrl);
-            }
-            if( NULL != psz_mrl )
+            std::string mrl;
+            if( resolveMRL(_bstr_mrl, mrl) )
             {
                 const char *options[1];
                 int i_options = 0;
@@ -753,14 +835,13 @@ HRESULT VLCPlugin::onActivateInPlace(LPMSG, HWND hwndParent, LPCRECT lprcPosRect
                     options[i_options++] = timeBuffer;
                 }
                 // add default target to playlist
-                m_player.add_item( psz_mrl, i_options, options);
-                CoTaskMemFree(psz_mrl);
+                m_player.add_item( mrl.c_str(), i_options, options);
             }
         }
 
         if( get_autoplay() )
         {
-            get_player().play();
+            get_player().async_play();
         }
     }
 
@@ -772,6 +853,42 @@ HRESULT VLCPlugin::onActivateInPlace(LPMSG, HWND hwndParent, LPCRECT lprcPosRect
     return S_OK;
 };
 
+bool VLCPlugin::resolveMRL(BSTR mrl, std::string& resolved)
+{
+    char *psz_mrl = CStrFromBSTR(CP_UTF8, mrl);
+    if( NULL == psz_mrl )
+        return false;
+
+    resolveMRL(psz_mrl, strlen(psz_mrl), resolved);
+    CoTaskMemFree(psz_mrl);
+    return true;
+}
+
+void VLCPlugin::resolveMRL(const char *mrl, size_t len, std::string& resolved)
+{
+    if( !_b_baseurl_parsed )
+    {
+        _base_resolver.clear();
+        if( SysStringLen(_bstr_baseurl) > 0 )
+        {
+            char *psz_base = CStrFromBSTR(CP_UTF8, _bstr_baseurl);
+            if( psz_base )
+            {
+                _base_resolver.set_base(psz_base, strlen(psz_base));
+                CoTaskMemFree(psz_base);
+            }
+        }
+        _b_baseurl_parsed = TRUE;
+    }
+
+    /*
+    ** if the MRL a relative URL, we should end up with an absolute URL,
+    ** without a usable base URL assume it is absolute
+    */
+    if( !_base_resolver.resolve(mrl, len, resolved) )
+        resolved.assign(mrl, len);
+}
+
 void VLCPlugin::toggleFullscreen()
 {
     _WindowsManager.ToggleFullScreen();
@@ -792,9 +909,9 @@ BOOL VLCPlugin::getFullscreen()
 
 HRESULT VLCPlugin::onInPlaceDeactivate(void)
 {
-    if( m_player.mlp().isPlaying() )
+    if( m_player.is_playing() )
     {
-        m_player.mlp().stopAsync();
+        m_player.stop_async();
     }
 
     _WindowsManager.DestroyWindows();
@@ -816,7 +933,7 @@ void VLCPlugin::setVisible(BOOL fVisible)
             if( fVisible )
                 InvalidateRect(_inplacewnd, NULL, TRUE);
         }
-        setDirty(TRUE);
+        setDirty(pp_visible);
         firePropChangedEvent(DISPID_Visible);
     }
 };
@@ -832,7 +949,7 @@ void VLCPlugin::setVolume(int volume)
     {
         _i_volume = volume;
         if ( m_player.get_mp().setVolume( volume ) )
-            setDirty(TRUE);
+            setDirty(pp_volume);
     }
 }
 
@@ -845,7 +962,7 @@ void VLCPlugin::setBackColor(OLE_COLOR backcolor)
         {
 
         }
-        setDirty(TRUE);
+        setDirty(pp_back_color);
     }
 };
 
@@ -1053,6 +1170,13 @@ void VLCPlugin::firePropChangedEvent(DISPID dispid)
     vlcConnectionPointContainer->firePropChangedEvent(dispid);
 };
 
+std::string VLCPlugin::getEventStatsReport(bool reset)
+{
+    event_stats stats;
+    vlcConnectionPointContainer->getEventStats(stats, reset);
+    return stats.report();
+};
+
 /*
  * Async events
  */
@@ -1123,6 +1247,21 @@ void VLCPlugin::fireOnMediaPlayerStopAsyncDoneEvent()
     vlcConnectionPointContainer->fireEvent(DISPID_MediaPlayerStopAsyncDoneEvent, &dispparamsNoArgs);
 };
 
+void VLCPlugin::fireOnMediaPlayerCommandDoneEvent(long command, long status)
+{
+    DISPPARAMS params;
+    params.cArgs = 2;
+    params.rgvarg = (VARIANTARG *) CoTaskMemAlloc(sizeof(VARIANTARG) * params.cArgs) ;
+    memset(params.rgvarg, 0, sizeof(VARIANTARG) * params.cArgs);
+    params.rgvarg[1].vt = VT_I4;
+    params.rgvarg[1].lVal = command;
+    params.rgvarg[0].vt = VT_I4;
+    params.rgvarg[0].lVal = status;
+    params.rgdispidNamedArgs = NULL;
+    params.cNamedArgs = 0;
+    vlcConnectionPointContainer->fireEvent(DISPID_MediaPlayerCommandDoneEvent, &params);
+};
+
 
 void VLCPlugin::fireOnMediaPlayerForwardEvent()
 {
@@ -1247,21 +1386,8 @@ void VLCPlugin::fireMouseDownEvent(short nButton, short nShiftState, int x, int
 
 void VLCPlugin::fireMouseMoveEvent(short nButton, short nShiftState, int x, int y)
 {
-    DISPPARAMS params;
-    params.cArgs = 4;
-    params.rgvarg = (VARIANTARG *) CoTaskMemAlloc(sizeof(VARIANTARG) * params.cArgs);
-    memset(params.rgvarg, 0, sizeof(VARIANTARG) * params.cArgs);
-    params.rgvarg[3].vt = VT_I2;
-    params.rgvarg[3].iVal = nButton;
-    params.rgvarg[2].vt = VT_I2;
-    params.rgvarg[2].iVal = nShiftState;
-    params.rgvarg[1].vt = VT_I4;
-    params.rgvarg[1].lVal = x;
-    params.rgvarg[0].vt = VT_I4;
-    params.rgvarg[0].lVal = y;
-    params.rgdispidNamedArgs = NULL;
-    params.cNamedArgs = 0;
-    vlcConnectionPointContainer->fireEvent(DISPID_MOUSEMOVE, &params);
+    // moves are merged while one is still pending delivery
+    vlcConnectionPointContainer->fireMouseMoveEvent(nButton, nShiftState, x, y);
 }
 
 
@@ -1395,8 +1521,12 @@ void VLCPlugin::player_register_events()
 {
     auto& em = m_player.get_mp().eventManager();
     em.onMediaChanged([this](VLC::MediaPtr) {
+        _meta_cache.invalidate();
         fireOnMediaPlayerMediaChangedEvent();
     });
+    em.onESAdded( _meta_cache.invalidator() );
+    em.onESDeleted( _meta_cache.invalidator() );
+    em.onTitleListChanged( _meta_cache.invalidator() );
     em.onNothingSpecial([this] {
         fireOnMediaPlayerNothingSpecialEvent();
     });
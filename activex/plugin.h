@@ -28,6 +28,11 @@
 
 #include "../common/win32_fullscreen.h"
 #include "../common/vlc_player.h"
+#include "../common/url_resolver.h"
+#include "../common/property_schema.h"
+#include "metacache.h"
+
+#include <string>
 
 extern "C" const GUID CLSID_VLCPlugin2;
 extern "C" const GUID LIBID_AXVLC;
@@ -72,6 +77,37 @@ private:
     LPPICTURE   _inplace_picture;
 };
 
+/*
+** persisted properties read by Load, applied together once it is done
+*/
+struct VLCStagedProperties
+{
+    VLCStagedProperties() : present(0)
+    {
+        for( int i = 0; i < pp_count; ++i )
+            strings[i] = NULL;
+    };
+    ~VLCStagedProperties() { clear(); };
+
+    bool has(vlc_property_e id) const { return (present >> id) & 1; };
+    void clear()
+    {
+        for( int i = 0; i < pp_count; ++i )
+        {
+            SysFreeString(strings[i]);
+            strings[i] = NULL;
+        }
+        present = 0;
+    };
+
+    // one bit per vlc_property_e
+    unsigned present;
+    // booleans and integers, by vlc_property_e
+    int      values[pp_count];
+    // string properties, owned
+    BSTR     strings[pp_count];
+};
+
 class VLCPlugin
     : public IUnknown, private vlc_player_options,
       public VLCWindowsManager::InputObserver
@@ -96,6 +132,9 @@ public:
         return m_player;
     }
 
+    VLCMetaCache& get_meta_cache()
+        { return _meta_cache; }
+
     vlc_player_options& get_options()
         { return *static_cast<vlc_player_options*>(this); }
     const vlc_player_options& get_options() const
@@ -108,30 +147,29 @@ public:
     {
         SysFreeString(_bstr_mrl);
         _bstr_mrl = SysAllocStringLen(mrl, SysStringLen(mrl));
-        setDirty(TRUE);
+        setDirty(pp_mrl);
     };
     BSTR getMRL(void) { return _bstr_mrl; };
 
     inline void setAutoPlay(BOOL autoplay)
     {
         set_autoplay(autoplay != FALSE);
-        setDirty(TRUE);
+        setDirty(pp_autoplay);
     };
     inline BOOL getAutoPlay(void) { return get_autoplay()? TRUE : FALSE; };
 
     inline void setAutoLoop(BOOL autoloop)
     {
         _b_autoloop = autoloop;
-        get_player().mlp().setPlaybackMode( autoloop ? libvlc_playback_mode_loop :
-                                            libvlc_playback_mode_default );
-        setDirty(TRUE);
+        get_player().set_loop( autoloop != FALSE );
+        setDirty(pp_autoloop);
     };
     inline BOOL getAutoLoop(void) { return _b_autoloop;};
 
     inline void setShowToolbar(BOOL showtoolbar)
     {
         set_show_toolbar(showtoolbar != FALSE);
-        setDirty(TRUE);
+        setDirty(pp_toolbar);
     };
     inline BOOL getShowToolbar(void) { return get_show_toolbar() ? TRUE : FALSE; };
 
@@ -148,7 +186,7 @@ public:
     inline void setStartTime(int time)
     {
         _i_time = time;
-        setDirty(TRUE);
+        setDirty(pp_start_time);
     };
     inline int getStartTime(void) { return _i_time; };
 
@@ -159,15 +197,27 @@ public:
     {
         SysFreeString(_bstr_baseurl);
         _bstr_baseurl = SysAllocStringLen(url, SysStringLen(url));
-        setDirty(TRUE);
+        _b_baseurl_parsed = FALSE;
+        setDirty(pp_base_url);
     };
     BSTR getBaseURL(void) { return _bstr_baseurl; };
 
+    // filled by Load, applied by onLoad
+    VLCStagedProperties& getStagedProperties(void) { return _staged; };
+
+    // converts mrl to UTF-8, resolved against the base URL if relative
+    bool resolveMRL(BSTR mrl, std::string& resolved);
+    // same, for an mrl already in UTF-8
+    void resolveMRL(const char *mrl, size_t len, std::string& resolved);
+
     // control size in HIMETRIC
     inline void setExtent(const SIZEL& extent)
     {
+        if( extent.cx != _extent.cx )
+            setDirty(pp_extent_width);
+        if( extent.cy != _extent.cy )
+            setDirty(pp_extent_height);
         _extent = extent;
-        setDirty(TRUE);
     };
     const SIZEL& getExtent(void) { return _extent; };
 
@@ -206,8 +256,11 @@ public:
     inline BOOL isUserMode(void) { return _b_usermode; };
     inline void setUserMode(BOOL um) { _b_usermode = um; };
 
-    inline BOOL isDirty(void) { return _b_dirty; };
-    inline void setDirty(BOOL dirty) { _b_dirty = dirty; };
+    // one bit per vlc_property_e, set by the setters of persisted properties
+    inline BOOL isDirty(void) { return _dirty != 0; };
+    inline BOOL isDirty(vlc_property_e id) { return (_dirty >> id) & 1; };
+    inline void setDirty(vlc_property_e id) { _dirty |= 1u << id; };
+    inline void clearDirty(void) { _dirty = 0; };
 
     void setErrorInfo(REFIID riid, const char *description);
 
@@ -243,6 +296,7 @@ public:
     */
     void freezeEvents(BOOL freeze);
     void firePropChangedEvent(DISPID dispid);
+    std::string getEventStatsReport(bool reset);
 
     // async events;
     void fireOnMediaPlayerNothingSpecialEvent();
@@ -256,6 +310,7 @@ public:
     void fireOnMediaPlayerEndReachedEvent();
     void fireOnMediaPlayerStoppedEvent();
     void fireOnMediaPlayerStopAsyncDoneEvent();
+    void fireOnMediaPlayerCommandDoneEvent(long command, long status);
 
     void fireOnMediaPlayerTimeChangedEvent(libvlc_time_t time);
     void fireOnMediaPlayerPositionChangedEvent(float position);
@@ -288,6 +343,7 @@ protected:
 
 private:
     void initVLC();
+    void applyStagedProperties();
     void set_player_window();
     void player_register_events();
 
@@ -315,6 +371,8 @@ private:
     VLCPluginClass* _p_class;
     ULONG _i_ref;
 
+    // before m_player, its event handlers invalidate the cache
+    VLCMetaCache _meta_cache;
     vlc_player m_player;
 
     UINT _i_codepage;
@@ -325,6 +383,10 @@ private:
     // persistable properties
     BSTR _bstr_baseurl;
     BSTR _bstr_mrl;
+    // base URL split once for resolveMRL(), redone when it changes
+    url_resolver _base_resolver;
+    BOOL _b_baseurl_parsed;
+    VLCStagedProperties _staged;
     BOOL _b_autoloop;
     BOOL _b_visible;
     BOOL _b_mute;
@@ -332,8 +394,8 @@ private:
     int  _i_time;
     SIZEL _extent;
     OLE_COLOR _i_backcolor;
-    // indicates whether properties needs persisting
-    BOOL _b_dirty;
+    // persisted properties changed since the last load or save
+    unsigned _dirty;
 };
 
 #endif
@@ -25,9 +25,9 @@
 #endif
 
 #include "utils.h"
+#include "../common/utf_transcoder.h"
 
-#include <wchar.h>
-#include <wctype.h>
+static_assert(sizeof(WCHAR) == sizeof(char16_t), "WCHAR must be UTF-16");
 
 /*
 ** conversion facilities
@@ -37,6 +37,16 @@ using namespace std;
 
 char *CStrFromWSTR(UINT codePage, LPCWSTR wstr, UINT len)
 {
+    if( len > 0 && CP_UTF8 == codePage )
+    {
+        // sized exactly, converted once, no need to clear the buffer
+        const char16_t *u16 = reinterpret_cast<const char16_t *>(wstr);
+        size_t mblen = utf16_to_utf8_length(u16, len);
+        char *buffer = (char *)CoTaskMemAlloc(mblen+1);
+        if( buffer )
+            buffer[utf16_to_utf8(u16, len, buffer)] = '\0';
+        return buffer;
+    }
     if( len > 0 )
     {
         size_t mblen = WideCharToMultiByte(codePage,
@@ -62,6 +72,17 @@ char *CStrFromBSTR(UINT codePage, BSTR bstr)
 
 BSTR BSTRFromCStr(UINT codePage, LPCSTR s)
 {
+    if( CP_UTF8 == codePage )
+    {
+        // converted straight into the BSTR
+        size_t len = strlen(s);
+        size_t wideLen = utf8_to_utf16_length(s, len);
+        BSTR bstr = SysAllocStringLen(NULL, wideLen);
+        if( bstr )
+            utf8_to_utf16(s, len, reinterpret_cast<char16_t *>(bstr));
+        return bstr;
+    }
+
     int wideLen = MultiByteToWideChar(codePage, 0, s, -1, NULL, 0);
     if( wideLen > 0 )
     {
@@ -162,166 +183,3 @@ void HimetricFromDP(HDC hdc, LPPOINT pt, int count)
     }
 };
 
-
-LPWSTR CombineURL(LPCWSTR baseUrl, LPCWSTR url)
-{
-    if( NULL != url )
-    {
-        // check whether URL is already absolute
-        const wchar_t *end=wcschr(url, L':');
-        if( (NULL != end) && (end != url) )
-        {
-            // validate protocol header
-            const wchar_t *start = url;
-            wchar_t c = *start;
-            if( iswalpha(c) )
-            {
-                ++start;
-                while( start != end )
-                {
-                    c = *start;
-                    if( ! (iswalnum(c)
-                       || (L'-' == c)
-                       || (L'+' == c)
-                       || (L'.' == c)
-                       || (L'/' == c)) ) /* VLC uses / to allow user to specify a demuxer */
-                        // not valid protocol header, assume relative URL
-                        goto relativeurl;
-                    ++start;
-                }
-                /* we have a protocol header, therefore URL is absolute */
-                UINT len = wcslen(url);
-                wchar_t *href = (LPWSTR)CoTaskMemAlloc((len+1)*sizeof(wchar_t));
-                if( href )
-                {
-                    memcpy(href, url, len*sizeof(wchar_t));
-                    href[len] = L'\0';
-                }
-                return href;
-            }
-        }
-
-relativeurl:
-
-        if( baseUrl )
-        {
-            size_t baseLen = wcslen(baseUrl);
-            wchar_t *href = (LPWSTR)CoTaskMemAlloc((baseLen+wcslen(url)+1)*sizeof(wchar_t));
-            if( href )
-            {
-                /* prepend base URL */
-                wcscpy(href, baseUrl);
-
-                /*
-                ** relative url could be empty,
-                ** in which case return base URL
-                */
-                if( L'\0' == *url )
-                    return href;
-
-                /*
-                ** locate pathname part of base URL
-                */
-
-                /* skip over protocol part  */
-                wchar_t *pathstart = wcschr(href, L':');
-                wchar_t *pathend;
-                if( pathstart )
-                {
-                    if( L'/' == *(++pathstart) )
-                    {
-                        if( L'/' == *(++pathstart) )
-                        {
-                            ++pathstart;
-                        }
-                    }
-                    /* skip over host part */
-                    pathstart = wcschr(pathstart, L'/');
-                    pathend = href+baseLen;
-                    if( ! pathstart )
-                    {
-                        // no path, add a / past end of url (over '\0')
-                        pathstart = pathend;
-                        *pathstart = L'/';
-                    }
-                }
-                else
-                {
-                    /* baseURL is just a UNIX file path */
-                    if( L'/' != *href )
-                    {
-                        /* baseURL is not an absolute path */
-                        CoTaskMemFree(href);
-                        return NULL;
-                    }
-                    pathstart = href;
-                    pathend = href+baseLen;
-                }
-
-                /* relative URL made of an absolute path ? */
-                if( L'/' == *url )
-                {
-                    /* replace path completely */
-                    wcscpy(pathstart, url);
-                    return href;
-                }
-
-                /* find last path component and replace it */
-                while( L'/' != *pathend )
-                    --pathend;
-
-                /*
-                ** if relative url path starts with one or more './' or '../',
-                ** factor them out of href so that we return a
-                ** normalized URL
-                */
-                while( pathend > pathstart )
-                {
-                    const wchar_t *p = url;
-                    if( L'.' != *p )
-                        break;
-                    ++p;
-                    if( L'\0' == *p  )
-                    {
-                        /* relative url is just '.' */
-                        url = p;
-                        break;
-                    }
-                    if( L'/' == *p  )
-                    {
-                        /* relative url starts with './' */
-                        url = ++p;
-                        continue;
-                    }
-                    if( L'.' != *p )
-                        break;
-                    ++p;
-                    if( L'\0' == *p )
-                    {
-                        /* relative url is '..' */
-                    }
-                    else
-                    {
-                        if( L'/' != *p )
-                            break;
-                        /* relative url starts with '../' */
-                        ++p;
-                    }
-                    url = p;
-                    do
-                    {
-                        --pathend;
-                    }
-                    while( L'/' != *pathend );
-                }
-                /* skip over '/' separator */
-                ++pathend;
-                /* concatenate remaining base URL and relative URL */
-                wcscpy(pathend, url);
-            }
-            return href;
-        }
-    }
-    return NULL;
-}
-
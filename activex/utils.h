@@ -40,9 +40,6 @@ extern HDC CreateDevDC(DVTARGETDEVICE *ptd);
 extern void DPFromHimetric(HDC hdc, LPPOINT pt, int count);
 extern void HimetricFromDP(HDC hdc, LPPOINT pt, int count);
 
-// URL
-extern LPWSTR CombineURL(LPCWSTR baseUrl, LPCWSTR url);
-
 /**************************************************************************************************/
 
 /* this function object is used to dereference the iterator into a value */
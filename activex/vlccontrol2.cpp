@@ -36,6 +36,8 @@
 #include "vlccontrol2.h"
 
 #include "../common/position.h"
+#include "../common/option_tokenizer.h"
+#include "../common/base64.h"
 
 // ---------
 
@@ -92,110 +94,32 @@ VARIANT_BOOL varbool(bool b) { return b ? VARIANT_TRUE : VARIANT_FALSE; }
 
 static inline INT negativeToZero(int i) { return i < 0 ? 0 : i; }
 
-static HRESULT parseStringOptions(int codePage, BSTR bstr, char*** cOptions, int *cOptionCount)
+static HRESULT parseStringOptions(int codePage, BSTR bstr, option_list& cOptions)
 {
-    HRESULT hr = E_INVALIDARG;
-    if (SysStringLen(bstr) > 0)
-    {
-        hr = E_OUTOFMEMORY;
-        char *s = CStrFromBSTR(codePage, bstr);
-        char *val = s;
-        if (val)
-        {
-            long capacity = 16;
-            char **options = (char **) CoTaskMemAlloc(capacity*sizeof(char *));
-            if (options)
-            {
-                int nOptions = 0;
+    if (SysStringLen(bstr) == 0)
+        return E_INVALIDARG;
 
-                char *end = val + strlen(val);
-                while (val < end)
-                {
-                    // skip leading blanks
-                    while ((val < end)
-                        && ((*val == ' ') || (*val == '\t')))
-                        ++val;
-
-                    char *start = val;
-                    // skip till we get a blank character
-                    while ((val < end)
-                        && (*val != ' ')
-                        && (*val != '\t'))
-                    {
-                        char c = *(val++);
-                        if (('\'' == c) || ('"' == c))
-                        {
-                            // skip till end of string
-                            while ((val < end) && (*(val++) != c));
-                        }
-                    }
+    char *s = CStrFromBSTR(codePage, bstr);
+    if (NULL == s)
+        return E_OUTOFMEMORY;
 
-                    if (val > start)
-                    {
-                        if (nOptions == capacity)
-                        {
-                            capacity += 16;
-                            char **moreOptions = (char **) CoTaskMemRealloc(options, capacity*sizeof(char*));
-                            if (!moreOptions)
-                            {
-                                /* failed to allocate more memory */
-                                CoTaskMemFree(s);
-                                /* return what we got so far */
-                                *cOptionCount = nOptions;
-                                *cOptions = options;
-                                return NOERROR;
-                            }
-                            options = moreOptions;
-                        }
-                        *(val++) = '\0';
-                        options[nOptions] = (char *) CoTaskMemAlloc(val - start);
-                        if (options[nOptions])
-                        {
-                            memcpy(options[nOptions], start, val - start);
-                            ++nOptions;
-                        }
-                        else
-                        {
-                            /* failed to allocate memory */
-                            CoTaskMemFree(s);
-                            /* return what we got so far */
-                            *cOptionCount = nOptions;
-                            *cOptions = options;
-                            return NOERROR;
-                        }
-                    }
-                    else
-                        // must be end of string
-                        break;
-                }
-                *cOptionCount = nOptions;
-                *cOptions = options;
-                hr = NOERROR;
-            }
-            CoTaskMemFree(s);
-        }
-    }
-    return hr;
+    cOptions.parse(s, strlen(s));
+    CoTaskMemFree(s);
+    return NOERROR;
 }
 
-static void FreeTargetOptions(char **cOptions, int cOptionCount)
+static HRESULT appendOption(int codePage, BSTR bstr, option_list& cOptions)
 {
-    // clean up
-    if (NULL != cOptions)
-    {
-        for (int pos = 0; pos<cOptionCount; ++pos)
-        {
-            char *cOption = cOptions[pos];
-            if (NULL != cOption)
-                CoTaskMemFree(cOption);
-            else
-                break;
-        }
-        CoTaskMemFree(cOptions);
-    }
-};
+    char *cOption = CStrFromBSTR(codePage, bstr);
+    if (NULL == cOption)
+        return (SysStringLen(bstr) > 0) ? E_OUTOFMEMORY : E_INVALIDARG;
+
+    cOptions.append(cOption, strlen(cOption));
+    CoTaskMemFree(cOption);
+    return NOERROR;
+}
 
-static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOptions, int *cOptionCount)
+static HRESULT CreateTargetOptions(int codePage, VARIANT *options, option_list& cOptions)
 {
     HRESULT hr = E_INVALIDARG;
     if (VT_ERROR == V_VT(options))
@@ -203,16 +127,12 @@ static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOpti
         if (DISP_E_PARAMNOTFOUND == V_ERROR(options))
         {
             // optional parameter not set
-            *cOptions = NULL;
-            *cOptionCount = 0;
             return NOERROR;
         }
     }
     else if ((VT_EMPTY == V_VT(options)) || (VT_NULL == V_VT(options)))
     {
         // null parameter
-        *cOptions = NULL;
-        *cOptionCount = 0;
         return NOERROR;
     }
     else if (VT_DISPATCH == V_VT(options))
@@ -227,55 +147,16 @@ static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOpti
             hr = V_UNKNOWN(&colEnum)->QueryInterface(IID_IEnumVARIANT, (LPVOID *) &enumVar);
             if (SUCCEEDED(hr))
             {
-                long pos = 0;
-                long capacity = 16;
                 VARIANT option;
-
-                *cOptions = (char **) CoTaskMemAlloc(capacity*sizeof(char *));
-                if (NULL != *cOptions)
+                while (SUCCEEDED(hr) && (S_OK == enumVar->Next(1, &option, NULL)))
                 {
-                    ZeroMemory(*cOptions, sizeof(char *)*capacity);
-                    while (SUCCEEDED(hr) && (S_OK == enumVar->Next(1, &option, NULL)))
-                    {
-                        if (VT_BSTR == V_VT(&option))
-                        {
-                            char *cOption = CStrFromBSTR(codePage, V_BSTR(&option));
-                            (*cOptions)[pos] = cOption;
-                            if (NULL != cOption)
-                            {
-                                ++pos;
-                                if (pos == capacity)
-                                {
-                                    char **moreOptions = (char **) CoTaskMemRealloc(*cOptions, (capacity + 16)*sizeof(char *));
-                                    if (NULL != moreOptions)
-                                    {
-                                        ZeroMemory(moreOptions + capacity, sizeof(char *) * 16);
-                                        capacity += 16;
-                                        *cOptions = moreOptions;
-                                    }
-                                    else
-                                        hr = E_OUTOFMEMORY;
-                                }
-                            }
-                            else
-                                hr = (SysStringLen(V_BSTR(&option)) > 0) ?
-                            E_OUTOFMEMORY : E_INVALIDARG;
-                        }
-                        else
-                            hr = E_INVALIDARG;
+                    if (VT_BSTR == V_VT(&option))
+                        hr = appendOption(codePage, V_BSTR(&option), cOptions);
+                    else
+                        hr = E_INVALIDARG;
 
-                        VariantClear(&option);
-                    }
-                    *cOptionCount = pos;
-                    if (FAILED(hr))
-                    {
-                        // free already processed elements
-                        FreeTargetOptions(*cOptions, *cOptionCount);
-                    }
+                    VariantClear(&option);
                 }
-                else
-                    hr = E_OUTOFMEMORY;
-
                 enumVar->Release();
             }
         }
@@ -287,7 +168,7 @@ static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOpti
             hr = VariantChangeType(&v_name, options, 0, VT_BSTR);
             if (SUCCEEDED(hr))
             {
-                hr = parseStringOptions(codePage, V_BSTR(&v_name), cOptions, cOptionCount);
+                hr = parseStringOptions(codePage, V_BSTR(&v_name), cOptions);
                 VariantClear(&v_name);
             }
         }
@@ -313,30 +194,19 @@ static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOpti
             if (FAILED(hr))
                 return hr;
 
-            long pos;
+            cOptions.reserve(0, uBound - lBound + 1);
 
-            // marshall options into an array of C strings
+            // marshall options into the list
             if (VT_VARIANT == vType)
             {
-                *cOptions = (char **) CoTaskMemAlloc(sizeof(char *)*(uBound - lBound + 1));
-                if (NULL == *cOptions)
-                    return E_OUTOFMEMORY;
-
-                ZeroMemory(*cOptions, sizeof(char *)*(uBound - lBound + 1));
-                for (pos = lBound; (pos <= uBound) && SUCCEEDED(hr); ++pos)
+                for (long pos = lBound; (pos <= uBound) && SUCCEEDED(hr); ++pos)
                 {
                     VARIANT option;
                     hr = SafeArrayGetElement(array, &pos, &option);
                     if (SUCCEEDED(hr))
                     {
                         if (VT_BSTR == V_VT(&option))
-                        {
-                            char *cOption = CStrFromBSTR(codePage, V_BSTR(&option));
-                            (*cOptions)[pos - lBound] = cOption;
-                            if (NULL == cOption)
-                                hr = (SysStringLen(V_BSTR(&option)) > 0) ?
-                            E_OUTOFMEMORY : E_INVALIDARG;
-                        }
+                            hr = appendOption(codePage, V_BSTR(&option), cOptions);
                         else
                             hr = E_INVALIDARG;
                         VariantClear(&option);
@@ -345,23 +215,13 @@ static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOpti
             }
             else if (VT_BSTR == vType)
             {
-                *cOptions = (char **) CoTaskMemAlloc(sizeof(char *)*(uBound - lBound + 1));
-                if (NULL == *cOptions)
-                    return E_OUTOFMEMORY;
-
-                ZeroMemory(*cOptions, sizeof(char *)*(uBound - lBound + 1));
-                for (pos = lBound; (pos <= uBound) && SUCCEEDED(hr); ++pos)
+                for (long pos = lBound; (pos <= uBound) && SUCCEEDED(hr); ++pos)
                 {
                     BSTR option;
                     hr = SafeArrayGetElement(array, &pos, &option);
                     if (SUCCEEDED(hr))
                     {
-                        char *cOption = CStrFromBSTR(codePage, option);
-
-                        (*cOptions)[pos - lBound] = cOption;
-                        if (NULL == cOption)
-                            hr = (SysStringLen(option) > 0) ?
-                        E_OUTOFMEMORY : E_INVALIDARG;
+                        hr = appendOption(codePage, option, cOptions);
                         SysFreeString(option);
                     }
                 }
@@ -371,19 +231,10 @@ static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOpti
                 // unsupported type
                 return E_INVALIDARG;
             }
-
-            *cOptionCount = pos - lBound;
-            if (FAILED(hr))
-            {
-                // free already processed elements
-                FreeTargetOptions(*cOptions, *cOptionCount);
-            }
         }
         else
         {
             // empty array
-            *cOptions = NULL;
-            *cOptionCount = 0;
             return NOERROR;
         }
     }
@@ -395,13 +246,90 @@ static HRESULT CreateTargetOptions(int codePage, VARIANT *options, char ***cOpti
         hr = VariantChangeType(&v_name, options, 0, VT_BSTR);
         if (SUCCEEDED(hr))
         {
-            hr = parseStringOptions(codePage, V_BSTR(&v_name), cOptions, cOptionCount);
+            hr = parseStringOptions(codePage, V_BSTR(&v_name), cOptions);
             VariantClear(&v_name);
         }
     }
     else if (VT_BSTR == V_VT(options))
     {
-        hr = parseStringOptions(codePage, V_BSTR(options), cOptions, cOptionCount);
+        hr = parseStringOptions(codePage, V_BSTR(options), cOptions);
+    }
+    return hr;
+}
+
+// uris in any of the forms options take, one per element, resolved like
+// add() resolves them
+static HRESULT CreateTargetMRLs(VLCPlugin *plug, VARIANT *uris, std::vector<std::string>& mrls)
+{
+    option_list list;
+    HRESULT hr = CreateTargetOptions(CP_UTF8, uris, list);
+    if( FAILED(hr) )
+        return hr;
+
+    mrls.resize(list.size());
+    for( size_t i = 0; i < list.size(); ++i )
+        plug->resolveMRL(list[i].data, list[i].size, mrls[i]);
+    return hr;
+}
+
+static HRESULT appendTime(VARIANT *value, std::vector<double>& times)
+{
+    VARIANT v_time;
+    VariantInit(&v_time);
+    HRESULT hr = VariantChangeType(&v_time, value, 0, VT_R8);
+    if( SUCCEEDED(hr) )
+        times.push_back(V_R8(&v_time));
+    return hr;
+}
+
+// an array or collection of numbers
+static HRESULT CreateTargetTimes(VARIANT *values, std::vector<double>& times)
+{
+    HRESULT hr = E_INVALIDARG;
+    if( VT_DISPATCH == V_VT(values) )
+    {
+        VARIANT colEnum;
+        V_VT(&colEnum) = VT_UNKNOWN;
+        hr = GetObjectProperty(V_DISPATCH(values), DISPID_NEWENUM, colEnum);
+        if( FAILED(hr) )
+            return hr;
+        IEnumVARIANT *enumVar;
+        hr = V_UNKNOWN(&colEnum)->QueryInterface(IID_IEnumVARIANT, (LPVOID *) &enumVar);
+        if( SUCCEEDED(hr) )
+        {
+            VARIANT value;
+            while( SUCCEEDED(hr) && (S_OK == enumVar->Next(1, &value, NULL)) )
+            {
+                hr = appendTime(&value, times);
+                VariantClear(&value);
+            }
+            enumVar->Release();
+        }
+        VariantClear(&colEnum);
+    }
+    else if( V_ISARRAY(values) )
+    {
+        SAFEARRAY *array = V_ISBYREF(values) ? *V_ARRAYREF(values) : V_ARRAY(values);
+        VARTYPE vType;
+        if( SafeArrayGetDim(array) != 1 || FAILED(SafeArrayGetVartype(array, &vType))
+         || VT_VARIANT != vType )
+            return E_INVALIDARG;
+
+        long lBound = 0;
+        long uBound = -1;
+        SafeArrayGetLBound(array, 1, &lBound);
+        SafeArrayGetUBound(array, 1, &uBound);
+        hr = NOERROR;
+        for( long pos = lBound; (pos <= uBound) && SUCCEEDED(hr); ++pos )
+        {
+            VARIANT value;
+            hr = SafeArrayGetElement(array, &pos, &value);
+            if( SUCCEEDED(hr) )
+            {
+                hr = appendTime(&value, times);
+                VariantClear(&value);
+            }
+        }
     }
     return hr;
 }
@@ -438,7 +366,7 @@ STDMETHODIMP VLCAudio::get_volume(long* volume)
 
 STDMETHODIMP VLCAudio::put_volume(long volume)
 {
-    _plug->get_player().get_mp().setVolume( volume );
+    _plug->get_player().async_set_volume( volume );
 
     return S_OK;
 }
@@ -506,11 +434,13 @@ STDMETHODIMP VLCAudio::description(long trackId, BSTR* name)
     case libvlc_Playing:
     case libvlc_Paused:
     {
+        VLCMetaCache& cache = _plug->get_meta_cache();
+        if( cache.lookup( VLCMetaCache::AudioTrackKind, trackId, name ) )
+            return S_OK;
         auto tracks = _plug->get_player().get_mp().tracks( VLC::MediaTrack::Type::Audio );
         if ( trackId >= tracks.size() )
             return E_INVALIDARG;
-        *name = BSTRFromCStr( CP_UTF8, tracks[trackId].name().c_str() );
-        return (NULL == *name) ? E_OUTOFMEMORY : S_OK;
+        return cache.store( VLCMetaCache::AudioTrackKind, trackId, tracks[trackId].name(), name );
     }
     default:
     {
@@ -603,11 +533,13 @@ STDMETHODIMP VLCTitle::description(long track, BSTR* name)
     if( NULL == name )
         return E_POINTER;
 
+    VLCMetaCache& cache = _plug->get_meta_cache();
+    if( cache.lookup( VLCMetaCache::TitleKind, track, name ) )
+        return S_OK;
     auto tracks = _plug->get_player().get_mp().titleDescription();
     if ( track >= tracks.size() )
         return E_INVALIDARG;
-    *name = BSTRFromCStr( CP_UTF8, tracks[track].name().c_str() );
-    return (NULL == *name) ? E_OUTOFMEMORY : S_OK;
+    return cache.store( VLCMetaCache::TitleKind, track, tracks[track].name(), name );
 }
 
 /****************************************************************************/
@@ -720,7 +652,7 @@ STDMETHODIMP VLCInput::get_position(double* position)
 
 STDMETHODIMP VLCInput::put_position(double position)
 {
-    _plug->get_player().get_mp().setPosition( static_cast<float>(position), true );
+    _plug->get_player().async_set_position( static_cast<float>(position) );
 
     return S_OK;
 }
@@ -737,7 +669,7 @@ STDMETHODIMP VLCInput::get_time(double* time)
 
 STDMETHODIMP VLCInput::put_time(double time)
 {
-    _plug->get_player().get_mp().setTime(static_cast<libvlc_time_t>(time), true);
+    _plug->get_player().async_set_time( static_cast<libvlc_time_t>(time) );
 
     return S_OK;
 }
@@ -764,7 +696,7 @@ STDMETHODIMP VLCInput::get_rate(double* rate)
 
 STDMETHODIMP VLCInput::put_rate(double rate)
 {
-    _plug->get_player().get_mp().setRate( static_cast<float>(rate) );
+    _plug->get_player().async_set_rate( static_cast<float>(rate) );
 
     return S_OK;
 }
@@ -893,27 +825,15 @@ STDMETHODIMP VLCPlaylistItems::remove(long item)
 }
 
 /****************************************************************************/
-enum PlaylistAsyncMessages
-{
-    PM_INPUT_STOP = WM_USER +1,
-    PM_DESTROY
-};
 
 VLCPlaylist::VLCPlaylist(VLCPlugin *p):
     VLCInterface<VLCPlaylist,IVLCPlaylist>(p),
     _p_vlcplaylistitems(new VLCPlaylistItems(p))
 {
-    _async_thread = CreateThread ( NULL , 0 ,
-        (LPTHREAD_START_ROUTINE)VLCPlaylist::async_handler_cb,
-        (LPVOID)this , 0, &_async_thread_id );
 }
 
 VLCPlaylist::~VLCPlaylist()
 {
-    PostThreadMessage(_async_thread_id, PM_DESTROY, 0, 0);
-    WaitForSingleObject(_async_thread, INFINITE);
-    CloseHandle (_async_thread);
-
     delete _p_vlcplaylistitems;
 }
 
@@ -933,7 +853,7 @@ STDMETHODIMP VLCPlaylist::get_isPlaying(VARIANT_BOOL* isPlaying)
     if( NULL == isPlaying )
         return E_POINTER;
 
-    *isPlaying = varbool( _plug->get_player().mlp().isPlaying() );
+    *isPlaying = varbool( _plug->get_player().is_playing() );
 
     return S_OK;
 }
@@ -957,45 +877,17 @@ STDMETHODIMP VLCPlaylist::add(BSTR uri, VARIANT name, VARIANT options, long* ite
         return E_INVALIDARG;
 
     HRESULT hr;
-    char *psz_uri = NULL;
-    if( SysStringLen(_plug->getBaseURL()) > 0 )
-    {
-        /*
-        ** if the MRL a relative URL, we should end up with an absolute URL
-        */
-        LPWSTR abs_url = CombineURL(_plug->getBaseURL(), uri);
-        if( NULL != abs_url )
-        {
-            psz_uri = CStrFromWSTR(CP_UTF8, abs_url, wcslen(abs_url));
-            CoTaskMemFree(abs_url);
-        }
-        else
-        {
-            psz_uri = CStrFromBSTR(CP_UTF8, uri);
-        }
-    }
-    else
-    {
-        /*
-        ** baseURL is empty, assume MRL is absolute
-        */
-        psz_uri = CStrFromBSTR(CP_UTF8, uri);
-    }
-
-    if( NULL == psz_uri )
+    std::string mrl;
+    if( !_plug->resolveMRL(uri, mrl) )
     {
         return E_OUTOFMEMORY;
     }
 
-    int i_options;
-    char **ppsz_options;
+    option_list target_options;
 
-    hr = CreateTargetOptions(CP_UTF8, &options, &ppsz_options, &i_options);
+    hr = CreateTargetOptions(CP_UTF8, &options, target_options);
     if( FAILED(hr) )
-    {
-        CoTaskMemFree(psz_uri);
         return hr;
-    }
 
     char *psz_name = NULL;
     VARIANT v_name;
@@ -1008,11 +900,9 @@ STDMETHODIMP VLCPlaylist::add(BSTR uri, VARIANT name, VARIANT options, long* ite
         VariantClear(&v_name);
     }
 
-    *item = _plug->get_player().add_item( psz_uri, i_options,
-                                               const_cast<const char **>(ppsz_options));
+    *item = _plug->get_player().add_item( mrl.c_str(), target_options.size(),
+                                          target_options.argv() );
 
-    FreeTargetOptions(ppsz_options, i_options);
-    CoTaskMemFree(psz_uri);
     if( psz_name ) /* XXX Do we even need to check? */
         CoTaskMemFree(psz_name);
     return hr;
@@ -1020,13 +910,13 @@ STDMETHODIMP VLCPlaylist::add(BSTR uri, VARIANT name, VARIANT options, long* ite
 
 STDMETHODIMP VLCPlaylist::play()
 {
-    _plug->get_player().mlp().play();
+    _plug->get_player().async_play();
     return S_OK;
 };
 
 STDMETHODIMP VLCPlaylist::playItem(long item)
 {
-    _plug->get_player().mlp().playItemAtIndex( item );
+    _plug->get_player().async_play_item( item );
     return S_OK;
 }
 
@@ -1038,31 +928,32 @@ STDMETHODIMP VLCPlaylist::pause()
 
 STDMETHODIMP VLCPlaylist::togglePause()
 {
-    _plug->get_player().mlp().pause();
+    _plug->get_player().toggle_pause();
     return S_OK;
 }
 
 STDMETHODIMP VLCPlaylist::stop()
 {
-    _plug->get_player().mlp().stopAsync();
+    _plug->get_player().stop_async();
     return S_OK;
 }
 
 STDMETHODIMP VLCPlaylist::stop_async()
 {
-    PostThreadMessage(_async_thread_id, PM_INPUT_STOP, 0, 0);
+    // MediaPlayerStopAsyncDone is fired once the player's worker ran it
+    _plug->get_player().async_stop();
     return S_OK;
 }
 
 STDMETHODIMP VLCPlaylist::next()
 {
-    _plug->get_player().mlp().next();
+    _plug->get_player().async_next();
     return S_OK;
 }
 
 STDMETHODIMP VLCPlaylist::prev()
 {
-    _plug->get_player().mlp().previous();
+    _plug->get_player().async_prev();
     return S_OK;
 }
 
@@ -1102,34 +993,243 @@ STDMETHODIMP VLCPlaylist::parse(long options, long timeout, long *status)
     return S_OK;
 }
 
-void VLCPlaylist::async_handler_cb(LPVOID obj)
+STDMETHODIMP VLCPlaylist::findItem(BSTR uri, long* item)
 {
-    VLCPlaylist* that = (VLCPlaylist*) obj;
-    that->async_handler();
+    if( NULL == item )
+        return E_POINTER;
+
+    if( 0 == SysStringLen(uri) )
+        return E_INVALIDARG;
+
+    // resolved like add() does, so relative uris find the items they added
+    std::string mrl;
+    if( !_plug->resolveMRL(uri, mrl) )
+        return E_OUTOFMEMORY;
+
+    *item = _plug->get_player().find_item( mrl.c_str() );
+    return S_OK;
+}
+
+STDMETHODIMP VLCPlaylist::search(BSTR query, VARIANT* items)
+{
+    if( NULL == items )
+        return E_POINTER;
+
+    VariantInit(items);
+    char *q = CStrFromBSTR(CP_UTF8, query);
+    if( NULL == q )
+        return SysStringLen(query) > 0 ? E_OUTOFMEMORY : E_INVALIDARG;
+
+    std::vector<unsigned> found;
+    _plug->get_player().search_items( q, found );
+    CoTaskMemFree(q);
+
+    // an array of variants, that is what scripts can read
+    SAFEARRAY *array = SafeArrayCreateVector(VT_VARIANT, 0, (ULONG)found.size());
+    if( NULL == array )
+        return E_OUTOFMEMORY;
+    VARIANT *v;
+    if( FAILED(SafeArrayAccessData(array, (void**)&v)) )
+    {
+        SafeArrayDestroy(array);
+        return E_FAIL;
+    }
+    for( size_t i = 0; i < found.size(); ++i )
+    {
+        V_VT(&v[i]) = VT_I4;
+        V_I4(&v[i]) = found[i];
+    }
+    SafeArrayUnaccessData(array);
+
+    V_VT(items) = VT_ARRAY | VT_VARIANT;
+    V_ARRAY(items) = array;
+    return S_OK;
+}
+
+STDMETHODIMP VLCPlaylist::saveSession(BSTR* session)
+{
+    if( NULL == session )
+        return E_POINTER;
+
+    *session = NULL;
+    std::vector<unsigned char> blob;
+    if( !_plug->get_player().save_session( blob ) )
+        return E_FAIL;
+
+    // base64, the blob is binary and scripts only carry strings
+    std::string text;
+    base64_encode( blob.data(), blob.size(), text );
+    *session = BSTRFromCStr( CP_UTF8, text.c_str() );
+    return (NULL != *session) ? S_OK : E_OUTOFMEMORY;
+}
+
+STDMETHODIMP VLCPlaylist::restoreSession(BSTR session, VARIANT_BOOL* restored)
+{
+    if( NULL == restored )
+        return E_POINTER;
+
+    *restored = VARIANT_FALSE;
+    char *text = CStrFromBSTR(CP_UTF8, session);
+    if( NULL == text )
+        return SysStringLen(session) > 0 ? E_OUTOFMEMORY : E_INVALIDARG;
+
+    std::vector<unsigned char> blob;
+    bool decoded = base64_decode( text, strlen(text), blob );
+    CoTaskMemFree(text);
+    if( !decoded )
+        return E_INVALIDARG;
+
+    *restored = varbool( _plug->get_player().restore_session( blob.data(), blob.size() ) );
+    return S_OK;
+}
+
+STDMETHODIMP VLCPlaylist::get_repeat(VARIANT_BOOL* repeat)
+{
+    if( NULL == repeat )
+        return E_POINTER;
+
+    *repeat = varbool( _plug->get_player().get_repeat() );
+    return S_OK;
+}
+
+STDMETHODIMP VLCPlaylist::put_repeat(VARIANT_BOOL repeat)
+{
+    _plug->get_player().set_repeat( VARIANT_FALSE != repeat );
+    return S_OK;
 }
 
+STDMETHODIMP VLCPlaylist::get_shuffle(VARIANT_BOOL* shuffle)
+{
+    if( NULL == shuffle )
+        return E_POINTER;
+
+    *shuffle = varbool( _plug->get_player().get_shuffle() );
+    return S_OK;
+}
+
+STDMETHODIMP VLCPlaylist::put_shuffle(VARIANT_BOOL shuffle)
+{
+    _plug->get_player().set_shuffle( VARIANT_FALSE != shuffle );
+    return S_OK;
+}
 
-void VLCPlaylist::async_handler()
+STDMETHODIMP VLCPlaylist::getGapStats(VARIANT_BOOL reset, VARIANT* stats)
 {
-    MSG msg;
-    bool b_quit = false;
-    while (!b_quit && GetMessage(&msg, 0, 0, 0))
+    if( NULL == stats )
+        return E_POINTER;
+
+    VariantInit(stats);
+    vlc_player_gap_stats gaps;
+    _plug->get_player().get_gap_stats( gaps );
+    if( VARIANT_FALSE != reset )
+        _plug->get_player().reset_gap_stats();
+
+    SAFEARRAY *array = SafeArrayCreateVector(VT_VARIANT, 0, 4);
+    if( NULL == array )
+        return E_OUTOFMEMORY;
+    VARIANT *v;
+    if( FAILED(SafeArrayAccessData(array, (void**)&v)) )
     {
-        switch(msg.message)
-        {
-        case PM_INPUT_STOP:
-            this->stop();
-            _plug->fireOnMediaPlayerStopAsyncDoneEvent();
-            break;
-        case PM_DESTROY:
-            b_quit = true;
-            break;
-        default:
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-            break;
-        }
+        SafeArrayDestroy(array);
+        return E_FAIL;
+    }
+    V_VT(&v[0]) = VT_R8;
+    V_R8(&v[0]) = (double)gaps.count;
+    const uint64_t us[] = { gaps.last_us, gaps.mean_us, gaps.max_us };
+    for( int i = 0; i < 3; ++i )
+    {
+        V_VT(&v[i + 1]) = VT_R8;
+        V_R8(&v[i + 1]) = us[i] / 1000.0;
     }
+    SafeArrayUnaccessData(array);
+
+    V_VT(stats) = VT_ARRAY | VT_VARIANT;
+    V_ARRAY(stats) = array;
+    return S_OK;
+}
+
+STDMETHODIMP VLCPlaylist::addItems(VARIANT uris, VARIANT options, long* item)
+{
+    if( NULL == item )
+        return E_POINTER;
+
+    std::vector<std::string> mrls;
+    HRESULT hr = CreateTargetMRLs(_plug, &uris, mrls);
+    if( FAILED(hr) )
+        return hr;
+    if( mrls.empty() )
+        return E_INVALIDARG;
+
+    option_list target_options;
+    hr = CreateTargetOptions(CP_UTF8, &options, target_options);
+    if( FAILED(hr) )
+        return hr;
+
+    vlc_player& player = _plug->get_player();
+    option_set_ptr set = player.intern_options( target_options.size(),
+                                                target_options.argv() );
+    std::vector<const char *> mrlv;
+    mrlv.reserve( mrls.size() );
+    for( const auto& m : mrls )
+        mrlv.push_back( m.c_str() );
+    *item = player.add_items( mrlv.size(), &mrlv[0], set );
+    return hr;
+}
+
+STDMETHODIMP VLCPlaylist::applyPlaylist(VARIANT uris, VARIANT options, long* inserted)
+{
+    if( NULL == inserted )
+        return E_POINTER;
+
+    // an empty array empties the playlist
+    std::vector<std::string> mrls;
+    HRESULT hr = CreateTargetMRLs(_plug, &uris, mrls);
+    if( FAILED(hr) )
+        return hr;
+
+    option_list target_options;
+    hr = CreateTargetOptions(CP_UTF8, &options, target_options);
+    if( FAILED(hr) )
+        return hr;
+
+    vlc_player& player = _plug->get_player();
+    option_set_ptr set = player.intern_options( target_options.size(),
+                                                target_options.argv() );
+    std::vector<const char *> mrlv;
+    mrlv.reserve( mrls.size() );
+    for( const auto& m : mrls )
+        mrlv.push_back( m.c_str() );
+    *inserted = player.apply_playlist( mrlv.size(), mrlv.empty() ? NULL : &mrlv[0], set );
+    return hr;
+}
+
+STDMETHODIMP VLCPlaylist::addSegments(VARIANT uris, VARIANT ranges, long* item)
+{
+    if( NULL == item )
+        return E_POINTER;
+
+    std::vector<std::string> mrls;
+    HRESULT hr = CreateTargetMRLs(_plug, &uris, mrls);
+    if( FAILED(hr) )
+        return hr;
+
+    // a start and a stop time per uri
+    std::vector<double> times;
+    hr = CreateTargetTimes(&ranges, times);
+    if( FAILED(hr) )
+        return hr;
+    if( mrls.empty() || times.size() != 2 * mrls.size() )
+        return E_INVALIDARG;
+
+    std::vector<vlc_edl_segment> segments( mrls.size() );
+    for( size_t i = 0; i < mrls.size(); ++i )
+    {
+        segments[i].mrl.swap( mrls[i] );
+        segments[i].start_ms = (int64_t)times[2 * i];
+        segments[i].stop_ms = (int64_t)times[2 * i + 1];
+    }
+    *item = _plug->get_player().add_segments( segments );
+    return S_OK;
 }
 
 /****************************************************************************/
@@ -1684,9 +1784,11 @@ STDMETHODIMP VLCMediaDescription::get_meta(BSTR* val, libvlc_meta_t e_meta)
         if ( media == nullptr )
             return E_FAIL;
     }
+    VLCMetaCache& cache = _plug->get_meta_cache();
+    if( cache.lookupMeta( media, e_meta, val ) )
+        return S_OK;
     auto info = media->meta( e_meta );
-    *val = BSTRFromCStr( CP_UTF8, info.c_str() );
-    return *val ? S_OK : E_FAIL;
+    return SUCCEEDED(cache.store( VLCMetaCache::MetaKind, e_meta, info, val )) ? S_OK : E_FAIL;
 }
 
 STDMETHODIMP VLCMediaDescription::get_title(BSTR *val)
@@ -1846,6 +1948,7 @@ STDMETHODIMP VLCControl2::Invoke(DISPID dispIdMember, REFIID,
         LCID, WORD wFlags, DISPPARAMS* pDispParams,
         VARIANT* pVarResult, EXCEPINFO* pExcepInfo, UINT* puArgErr)
 {
+    event_recorder::instance().record(erk_command, dispIdMember, (int64_t)wFlags);
     if( SUCCEEDED(loadTypeInfo()) )
     {
         return DispInvoke(this, _p_typeinfo, dispIdMember, wFlags, pDispParams,
@@ -1987,7 +2090,6 @@ STDMETHODIMP VLCControl2::getVersionInfo(BSTR *version)
     return get_VersionInfo(version);
 };
 
-
 STDMETHODIMP VLCControl2::get_Visible(VARIANT_BOOL *isVisible)
 {
     if( NULL == isVisible )
@@ -2049,6 +2151,16 @@ STDMETHODIMP VLCControl2::put_Branding(VARIANT_BOOL visible)
     return S_OK;
 };
 
+STDMETHODIMP VLCControl2::getEventStats(VARIANT_BOOL reset, BSTR *report)
+{
+    if( NULL == report )
+        return E_POINTER;
+
+    std::string stats = _p_instance->getEventStatsReport(VARIANT_FALSE != reset);
+    *report = BSTRFromCStr(CP_UTF8, stats.c_str());
+    return (NULL == *report) ? E_OUTOFMEMORY : NOERROR;
+};
+
 STDMETHODIMP VLCControl2::get_audio(IVLCAudio** obj)
 {
     return object_get(obj,_p_vlcaudio);
@@ -29,6 +29,8 @@
 
 #include <ole2.h>
 
+#include "../common/event_recorder.h"
+
 class VLCInterfaceBase {
 public:
     VLCInterfaceBase(VLCPlugin *p): _plug(p), _ti(NULL) { }
@@ -110,6 +112,7 @@ public:
         LCID , WORD wFlags, DISPPARAMS* pDispParams,
         VARIANT* pVarResult, EXCEPINFO* pExcepInfo, UINT* puArgErr)
     {
+        event_recorder::instance().record(erk_command, dispIdMember, (int64_t)wFlags);
         return FAILED(loadTypeInfo()) ? E_NOTIMPL :
             DispInvoke(This(), TypeInfo(), dispIdMember, wFlags,
                        pDispParams, pVarResult, pExcepInfo, puArgErr);
@@ -308,15 +311,21 @@ public:
     STDMETHODIMP removeItem(long);
     STDMETHODIMP get_items(IVLCPlaylistItems**);
     STDMETHODIMP parse(long options, long timeout, long* status);
-
-private:
-    static void async_handler_cb(LPVOID obj);
-    void async_handler();
+    STDMETHODIMP findItem(BSTR, long*);
+    STDMETHODIMP search(BSTR, VARIANT*);
+    STDMETHODIMP saveSession(BSTR*);
+    STDMETHODIMP restoreSession(BSTR, VARIANT_BOOL*);
+    STDMETHODIMP get_repeat(VARIANT_BOOL*);
+    STDMETHODIMP put_repeat(VARIANT_BOOL);
+    STDMETHODIMP get_shuffle(VARIANT_BOOL*);
+    STDMETHODIMP put_shuffle(VARIANT_BOOL);
+    STDMETHODIMP getGapStats(VARIANT_BOOL, VARIANT*);
+    STDMETHODIMP addItems(VARIANT, VARIANT, long*);
+    STDMETHODIMP applyPlaylist(VARIANT, VARIANT, long*);
+    STDMETHODIMP addSegments(VARIANT, VARIANT, long*);
 
 private:
     VLCPlaylistItems*    _p_vlcplaylistitems;
-    HANDLE               _async_thread;
-    DWORD                _async_thread_id;
 };
 
 class VLCSubtitle: public VLCInterface<VLCSubtitle,IVLCSubtitle>
@@ -463,6 +472,7 @@ public:
     STDMETHODIMP put_FullscreenEnabled(VARIANT_BOOL enabled) override;
     STDMETHODIMP get_Branding(VARIANT_BOOL* visible) override;
     STDMETHODIMP put_Branding(VARIANT_BOOL visible) override;
+    STDMETHODIMP getEventStats(VARIANT_BOOL reset, BSTR *report) override;
 
     STDMETHODIMP get_audio(IVLCAudio**) override;
     STDMETHODIMP get_input(IVLCInput**) override;
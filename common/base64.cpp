@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * base64.cpp: base64 text form of binary blobs
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "base64.h"
+
+static const char alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int value_of(char c)
+{
+    if( c >= 'A' && c <= 'Z' )
+        return c - 'A';
+    if( c >= 'a' && c <= 'z' )
+        return c - 'a' + 26;
+    if( c >= '0' && c <= '9' )
+        return c - '0' + 52;
+    if( c == '+' )
+        return 62;
+    if( c == '/' )
+        return 63;
+    return -1;
+}
+
+void base64_encode(const unsigned char *data, size_t size, std::string& out)
+{
+    out.clear();
+    out.reserve((size + 2) / 3 * 4);
+    size_t i = 0;
+    for( ; i + 3 <= size; i += 3 )
+    {
+        unsigned v = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+        out += alphabet[v >> 18];
+        out += alphabet[(v >> 12) & 0x3F];
+        out += alphabet[(v >> 6) & 0x3F];
+        out += alphabet[v & 0x3F];
+    }
+    if( i < size )
+    {
+        unsigned v = data[i] << 16 | (i + 1 < size ? data[i + 1] << 8 : 0);
+        out += alphabet[v >> 18];
+        out += alphabet[(v >> 12) & 0x3F];
+        out += i + 1 < size ? alphabet[(v >> 6) & 0x3F] : '=';
+        out += '=';
+    }
+}
+
+bool base64_decode(const char *s, size_t len, std::vector<unsigned char>& out)
+{
+    out.clear();
+    if( len % 4 )
+        return false;
+    out.reserve(len / 4 * 3);
+    for( size_t i = 0; i < len; i += 4 )
+    {
+        bool last = i + 4 == len;
+        int pad = last ? (s[i + 3] == '=') + (s[i + 2] == '=' && s[i + 3] == '=') : 0;
+        int v[4];
+        for( int k = 0; k < 4 - pad; ++k )
+        {
+            v[k] = value_of(s[i + k]);
+            if( v[k] < 0 )
+            {
+                out.clear();
+                return false;
+            }
+        }
+        // the bits padding drops must be zero for the encoding to be canonical
+        if( (pad == 2 && (v[1] & 0x0F)) || (pad == 1 && (v[2] & 0x03)) )
+        {
+            out.clear();
+            return false;
+        }
+        out.push_back((unsigned char)(v[0] << 2 | v[1] >> 4));
+        if( pad < 2 )
+            out.push_back((unsigned char)(v[1] << 4 | v[2] >> 2));
+        if( pad < 1 )
+            out.push_back((unsigned char)(v[2] << 6 | v[3]));
+    }
+    return true;
+}
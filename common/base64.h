@@ -0,0 +1,39 @@
+/*****************************************************************************
+ * base64.h: base64 text form of binary blobs
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _BASE64_H_
+#define _BASE64_H_
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/*
+ * RFC 4648 base64 with padding, so that binary blobs can go through
+ * script strings. Decoding is strict: no whitespace, no other alphabet,
+ * padding only at the end.
+ */
+
+void base64_encode(const unsigned char *data, size_t size, std::string& out);
+
+// returns false, leaving out empty, on anything but well formed base64
+bool base64_decode(const char *s, size_t len, std::vector<unsigned char>& out);
+
+#endif //_BASE64_H_
@@ -0,0 +1,131 @@
+/*****************************************************************************
+ * blob_cursor.h: bounds checked reads from in-memory blobs
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _BLOB_CURSOR_H_
+#define _BLOB_CURSOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+#include "utf_transcoder.h"
+
+/*
+ * Reads fields in host byte order from a blob held in memory. Every read
+ * checks the bytes left first and fails without moving on a short blob,
+ * so parsers only have to test the result.
+ */
+class blob_cursor
+{
+public:
+    blob_cursor(const unsigned char *data, size_t size)
+        : _data(data), _size(size), _pos(0)
+    {
+    }
+
+    bool get(void *p, size_t size)
+    {
+        if( _size - _pos < size )
+            return false;
+        memcpy(p, _data + _pos, size);
+        _pos += size;
+        return true;
+    }
+
+    // len units of UTF-16
+    bool get_utf16(std::u16string& s, uint32_t len)
+    {
+        if( (_size - _pos) / sizeof(char16_t) < len )
+            return false;
+        s.resize(len);
+        if( len > 0 )
+            memcpy(&s[0], _data + _pos, len * sizeof(char16_t));
+        _pos += len * sizeof(char16_t);
+        return true;
+    }
+
+    // size bytes of UTF-8, converted
+    bool get_utf8(std::u16string& s, uint32_t size)
+    {
+        if( _size - _pos < size )
+            return false;
+        const char *p = reinterpret_cast<const char*>(_data + _pos);
+        s.resize(utf8_to_utf16_length(p, size));
+        if( !s.empty() )
+            utf8_to_utf16(p, size, &s[0]);
+        _pos += size;
+        return true;
+    }
+
+    // size bytes, as they are
+    bool get_bytes(std::string& s, uint32_t size)
+    {
+        if( _size - _pos < size )
+            return false;
+        s.assign(reinterpret_cast<const char*>(_data + _pos), size);
+        _pos += size;
+        return true;
+    }
+
+    const unsigned char *at() const
+        { return _data + _pos; }
+    size_t left() const
+        { return _size - _pos; }
+    size_t pos() const
+        { return _pos; }
+
+private:
+    const unsigned char *_data;
+    size_t               _size;
+    size_t               _pos;
+};
+
+// byte at a time CRC-32 (IEEE) table, built on first use
+inline const uint32_t *crc32_table()
+{
+    static const struct table
+    {
+        uint32_t v[256];
+        table()
+        {
+            for( uint32_t i = 0; i < 256; ++i )
+            {
+                uint32_t crc = i;
+                for( int k = 0; k < 8; ++k )
+                    crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+                v[i] = crc;
+            }
+        }
+    } t;
+    return t.v;
+}
+
+// continues a CRC-32 (IEEE), start from 0xFFFFFFFF and invert the result
+inline uint32_t crc32_update(uint32_t crc, const unsigned char *p, size_t n)
+{
+    const uint32_t *table = crc32_table();
+    while( n-- )
+        crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#endif //_BLOB_CURSOR_H_
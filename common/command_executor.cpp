@@ -0,0 +1,211 @@
+/*****************************************************************************
+ * command_executor.cpp: serializes player commands on a worker thread
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <system_error>
+
+#include "command_executor.h"
+
+#if defined(_WIN32)
+
+command_executor::command_executor()
+    : _quit(false), _collapsed(0), _wakeup(NULL), _thread(NULL)
+{
+    InitializeCriticalSection(&_cs);
+}
+
+command_executor::~command_executor()
+{
+    shutdown();
+    if( _wakeup )
+        CloseHandle(_wakeup);
+    DeleteCriticalSection(&_cs);
+}
+
+void command_executor::shutdown()
+{
+    lock();
+    _quit = true;
+    _queue.clear();
+    HANDLE thread = _thread;
+    _thread = NULL;
+    unlock();
+
+    if( thread )
+    {
+        SetEvent(_wakeup);
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+}
+
+DWORD WINAPI command_executor::thread_cb(LPVOID obj)
+{
+    static_cast<command_executor*>(obj)->run();
+    return 0;
+}
+
+bool command_executor::start()
+{
+    if( _thread )
+        return true;
+    _wakeup = CreateEvent(nullptr, false, false, nullptr);
+    if( _wakeup == nullptr )
+        return false;
+    _thread = CreateThread(NULL, 0, thread_cb, this, 0, NULL);
+    if( _thread == nullptr )
+    {
+        CloseHandle(_wakeup);
+        _wakeup = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void command_executor::lock()
+{
+    EnterCriticalSection(&_cs);
+}
+
+void command_executor::unlock()
+{
+    LeaveCriticalSection(&_cs);
+}
+
+#else
+
+command_executor::command_executor()
+    : _quit(false), _collapsed(0)
+{
+}
+
+command_executor::~command_executor()
+{
+    shutdown();
+}
+
+void command_executor::shutdown()
+{
+    lock();
+    _quit = true;
+    _queue.clear();
+    std::thread thread = std::move(_thread);
+    unlock();
+
+    if( thread.joinable() )
+    {
+        _cond.notify_one();
+        thread.join();
+    }
+}
+
+bool command_executor::start()
+{
+    if( _thread.joinable() )
+        return true;
+    try {
+        _thread = std::thread(&command_executor::run, this);
+    }
+    catch( std::system_error& ) {
+        return false;
+    }
+    return true;
+}
+
+void command_executor::lock()
+{
+    _mutex.lock();
+}
+
+void command_executor::unlock()
+{
+    _mutex.unlock();
+}
+
+#endif
+
+void command_executor::post(int kind, command cmd, bool collapsible)
+{
+    lock();
+    if( _quit || !start() )
+    {
+        unlock();
+        return;
+    }
+
+    if( collapsible )
+    {
+        // latest wins, and runs after everything posted before it: taking
+        // the stale command's place would let a seek overtake a play item
+        for( auto it = _queue.begin(); it != _queue.end(); ++it )
+        {
+            if( it->kind == kind && it->collapsible )
+            {
+                _queue.erase(it);
+                ++_collapsed;
+                break;
+            }
+        }
+    }
+    pending p = { kind, collapsible, std::move(cmd) };
+    _queue.push_back(std::move(p));
+    unlock();
+
+#if defined(_WIN32)
+    SetEvent(_wakeup);
+#else
+    _cond.notify_one();
+#endif
+}
+
+void command_executor::run()
+{
+    for( ;; )
+    {
+#if defined(_WIN32)
+        lock();
+        while( !_quit && _queue.empty() )
+        {
+            unlock();
+            WaitForSingleObject(_wakeup, INFINITE);
+            lock();
+        }
+#else
+        std::unique_lock<std::mutex> guard(_mutex);
+        _cond.wait(guard, [this]() { return _quit || !_queue.empty(); });
+        guard.release();
+#endif
+        if( _quit )
+        {
+            unlock();
+            break;
+        }
+        pending p = std::move(_queue.front());
+        _queue.pop_front();
+        unlock();
+
+        int status = p.cmd();
+        if( _done )
+            _done(p.kind, status);
+    }
+}
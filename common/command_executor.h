@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * command_executor.h: serializes player commands on a worker thread
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _COMMAND_EXECUTOR_H_
+#define _COMMAND_EXECUTOR_H_
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <condition_variable>
+#  include <mutex>
+#  include <thread>
+#endif
+
+#include <deque>
+#include <functional>
+
+/*
+ * Runs commands one after the other on a private worker thread, in posting
+ * order. A command posted as collapsible drops a pending command of the
+ * same kind and is queued last, so a burst of seeks or volume changes only
+ * reaches libvlc once, with the newest value, and never ahead of a command
+ * posted between the two. Completion is reported through the done
+ * callback, on the worker thread.
+ *
+ * The worker is started on the first post and joined by shutdown() or on
+ * destruction, commands still pending at that point are dropped
+ * unreported.
+ */
+class command_executor
+{
+public:
+    typedef std::function<int()> command;
+    typedef std::function<void(int kind, int status)> done_cb;
+
+    command_executor();
+    ~command_executor();
+    command_executor(const command_executor&) = delete;
+    command_executor& operator=(const command_executor&) = delete;
+
+    // must be set before the first post
+    void set_done_callback(done_cb cb)
+        { _done = cb; }
+
+    void post(int kind, command cmd, bool collapsible);
+
+    // drops the pending commands, waits for the running one and stops the
+    // worker, later posts are ignored; the done callback is not called
+    // anymore once this returns
+    void shutdown();
+
+    // commands replaced by a newer one before they could run
+    unsigned long collapsed_count() const
+        { return _collapsed; }
+
+private:
+    void run();
+    void lock();
+    void unlock();
+    bool start();
+
+    struct pending
+    {
+        int     kind;
+        bool    collapsible;
+        command cmd;
+    };
+
+    std::deque<pending> _queue;
+    done_cb             _done;
+    bool                _quit;
+    unsigned long       _collapsed;
+#if defined(_WIN32)
+    static DWORD WINAPI thread_cb(LPVOID obj);
+
+    CRITICAL_SECTION    _cs;
+    HANDLE              _wakeup;
+    HANDLE              _thread;
+#else
+    std::mutex              _mutex;
+    std::condition_variable _cond;
+    std::thread             _thread;
+#endif
+};
+
+#endif //_COMMAND_EXECUTOR_H_
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * edl.cpp: edit decision list segments and the gaps between items
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "edl.h"
+
+// ":name=<seconds>.<milliseconds>", written without the locale decimal point
+static void format_time_option(std::string& option, const char *name, int64_t ms)
+{
+    char buffer[64];
+    snprintf( buffer, sizeof(buffer), ":%s=%lu.%03u", name,
+              (unsigned long)(ms / 1000), (unsigned)(ms % 1000) );
+    option = buffer;
+}
+
+unsigned edl_segment_options(const vlc_edl_segment& seg, std::string options[2])
+{
+    unsigned count = 0;
+    if( seg.start_ms > 0 )
+        format_time_option( options[count++], "start-time", seg.start_ms );
+    if( seg.stop_ms > 0 && seg.stop_ms > seg.start_ms )
+        format_time_option( options[count++], "stop-time", seg.stop_ms );
+    return count;
+}
+
+bool edl_sets_time_range(size_t optc, const char * const *optv)
+{
+    for( size_t i = 0; i < optc; ++i )
+    {
+        // libvlc takes options with or without their leading ':'
+        const char *o = optv[i] + (optv[i][0] == ':');
+        if( strncmp( o, "start-time=", 11 ) == 0 || strncmp( o, "stop-time=", 10 ) == 0 )
+            return true;
+    }
+    return false;
+}
+
+void edl_gap_stats::record(uint64_t us)
+{
+    _last = us;
+    _total += us;
+    ++_count;
+    uint64_t max = _max;
+    while( us > max && !_max.compare_exchange_weak( max, us ) )
+        ;
+}
+
+void edl_gap_stats::get(vlc_player_gap_stats& stats) const
+{
+    stats.count = _count;
+    stats.last_us = _last;
+    stats.max_us = _max;
+    stats.mean_us = stats.count ? _total / stats.count : 0;
+}
+
+void edl_gap_stats::reset()
+{
+    _count = 0;
+    _total = 0;
+    _last = 0;
+    _max = 0;
+}
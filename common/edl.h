@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * edl.h: edit decision list segments and the gaps between items
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _EDL_H_
+#define _EDL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+// one range of an edit decision list, stop_ms <= 0 plays to the end
+struct vlc_edl_segment
+{
+    std::string mrl;
+    int64_t     start_ms;
+    int64_t     stop_ms;
+};
+
+/* writes the start-time and stop-time options playing the range of seg,
+ * in seconds without the locale decimal point; a start at 0 and a stop
+ * not after the start are left out. Returns how many were written */
+unsigned edl_segment_options(const vlc_edl_segment& seg, std::string options[2]);
+
+// whether one of the options sets start-time or stop-time
+bool edl_sets_time_range(size_t optc, const char * const *optv);
+
+// time from the end of an item to the next one playing, in microseconds
+struct vlc_player_gap_stats
+{
+    uint64_t count;
+    uint64_t last_us;
+    uint64_t mean_us;
+    uint64_t max_us;
+};
+
+/*
+ * Accumulates the gaps between items, recorded from libvlc's event thread
+ * and read from any other one without a lock.
+ */
+class edl_gap_stats
+{
+public:
+    edl_gap_stats()
+        : _count(0), _total(0), _last(0), _max(0)
+    {
+    }
+
+    void record(uint64_t us);
+    void get(vlc_player_gap_stats& stats) const;
+    void reset();
+
+private:
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _total;
+    std::atomic<uint64_t> _last;
+    std::atomic<uint64_t> _max;
+};
+
+#endif //_EDL_H_
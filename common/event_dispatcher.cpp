@@ -0,0 +1,272 @@
+/*****************************************************************************
+ * event_dispatcher.cpp: runs deferred work on the thread owning the controls
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if !defined(_WIN32)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <unistd.h>
+#  if defined(__linux__)
+#    include <sys/eventfd.h>
+#  endif
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#include "event_dispatcher.h"
+
+#if defined(_WIN32)
+
+enum
+{
+    WM_DISPATCHER_WAKEUP = WM_USER + 1
+};
+
+static LPCTSTR dispatcher_class_name = TEXT("VLC Plugin Event Dispatcher");
+static std::atomic<int> live_dispatchers(0);
+
+static HINSTANCE dispatcher_module()
+{
+    HMODULE module = NULL;
+    GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS
+                    | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                      reinterpret_cast<LPCTSTR>(&dispatcher_module), &module);
+    return module;
+}
+
+static LRESULT CALLBACK dispatcher_window_proc(HWND hWnd, UINT uMsg,
+                                               WPARAM wParam, LPARAM lParam)
+{
+    if( uMsg == WM_DISPATCHER_WAKEUP )
+    {
+        event_dispatcher *d = reinterpret_cast<event_dispatcher*>(
+                                    GetWindowLongPtr(hWnd, GWLP_USERDATA));
+        if( d )
+            d->drain();
+        return 0;
+    }
+    return DefWindowProc(hWnd, uMsg, wParam, lParam);
+}
+
+event_dispatcher::event_dispatcher()
+    : _signaled(false), _hwnd(NULL)
+{
+    InitializeCriticalSection(&_cs);
+
+    HINSTANCE module = dispatcher_module();
+    WNDCLASS wClass;
+    if( ! GetClassInfo(module, dispatcher_class_name, &wClass) )
+    {
+        memset(&wClass, 0, sizeof(WNDCLASS));
+        wClass.lpfnWndProc    = dispatcher_window_proc;
+        wClass.hInstance      = module;
+        wClass.lpszClassName  = dispatcher_class_name;
+        RegisterClass(&wClass);
+    }
+    ++live_dispatchers;
+
+    // message only window, never shown and not enumerated
+    _hwnd = CreateWindow(dispatcher_class_name, 0, 0, 0, 0, 0, 0,
+                         HWND_MESSAGE, 0, module, 0);
+    if( _hwnd )
+        SetWindowLongPtr(_hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+}
+
+event_dispatcher::~event_dispatcher()
+{
+    if( _hwnd )
+        DestroyWindow(_hwnd);
+    if( --live_dispatchers == 0 )
+        UnregisterClass(dispatcher_class_name, dispatcher_module());
+    DeleteCriticalSection(&_cs);
+}
+
+bool event_dispatcher::wake()
+{
+    return _hwnd && PostMessage(_hwnd, WM_DISPATCHER_WAKEUP, 0, 0);
+}
+
+void event_dispatcher::clear_wakeup()
+{
+    // posted messages are consumed by the pump
+}
+
+void event_dispatcher::lock()
+{
+    EnterCriticalSection(&_cs);
+}
+
+void event_dispatcher::unlock()
+{
+    LeaveCriticalSection(&_cs);
+}
+
+#else
+
+event_dispatcher::event_dispatcher()
+    : _signaled(false), _fd(-1), _wfd(-1)
+{
+#if defined(__linux__)
+    _fd = _wfd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+#else
+    int fds[2];
+    if( pipe(fds) == 0 )
+    {
+        for( int i = 0; i < 2; ++i )
+        {
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        }
+        _fd = fds[0];
+        _wfd = fds[1];
+    }
+#endif
+}
+
+event_dispatcher::~event_dispatcher()
+{
+    if( _wfd >= 0 && _wfd != _fd )
+        close(_wfd);
+    if( _fd >= 0 )
+        close(_fd);
+}
+
+bool event_dispatcher::wake()
+{
+    if( _wfd < 0 )
+        return false;
+#if defined(__linux__)
+    uint64_t one = 1;
+    return write(_wfd, &one, sizeof(one)) == sizeof(one);
+#else
+    char one = 1;
+    return write(_wfd, &one, 1) == 1;
+#endif
+}
+
+void event_dispatcher::clear_wakeup()
+{
+    // an eventfd is reset by a single read, a pipe may need a few
+    char buf[64];
+    while( _fd >= 0 && read(_fd, buf, sizeof(buf)) > 0 )
+        ;
+}
+
+bool event_dispatcher::wait_and_drain(int timeout_ms)
+{
+    if( _fd < 0 )
+        return false;
+
+    struct pollfd pfd = { _fd, POLLIN, 0 };
+    int n;
+    do
+        n = poll(&pfd, 1, timeout_ms);
+    while( n < 0 && errno == EINTR );
+    if( n <= 0 )
+        return false;
+
+    drain();
+    return true;
+}
+
+void event_dispatcher::lock()
+{
+    _mutex.lock();
+}
+
+void event_dispatcher::unlock()
+{
+    _mutex.unlock();
+}
+
+#endif
+
+std::shared_ptr<event_dispatcher> event_dispatcher::current()
+{
+    static thread_local std::weak_ptr<event_dispatcher> thread_dispatcher;
+
+    std::shared_ptr<event_dispatcher> d = thread_dispatcher.lock();
+    if( !d )
+    {
+        d.reset(new event_dispatcher);
+        thread_dispatcher = d;
+    }
+    return d;
+}
+
+bool event_dispatcher::post(const void *owner, task fn)
+{
+    bool b_ok = true;
+    lock();
+    pending p = { owner, std::move(fn) };
+    _tasks.push_back(std::move(p));
+    if( !_signaled )
+    {
+        _signaled = wake();
+        b_ok = _signaled;
+    }
+    unlock();
+    return b_ok;
+}
+
+void event_dispatcher::cancel(const void *owner)
+{
+    lock();
+    for( auto it = _tasks.begin(); it != _tasks.end(); )
+    {
+        if( it->owner == owner )
+            it = _tasks.erase(it);
+        else
+            ++it;
+    }
+    unlock();
+}
+
+void event_dispatcher::drain()
+{
+    // a task may release the last control of the thread, and with it the
+    // last reference to the dispatcher
+    std::shared_ptr<event_dispatcher> self = shared_from_this();
+
+    clear_wakeup();
+    for( ;; )
+    {
+        // tasks are taken one at a time, so a task canceling another
+        // owner's work (or destroying it) is honored right away
+        lock();
+        if( _tasks.empty() )
+        {
+            _signaled = false;
+            unlock();
+            break;
+        }
+        task fn = std::move(_tasks.front().fn);
+        _tasks.pop_front();
+        unlock();
+
+        fn();
+    }
+}
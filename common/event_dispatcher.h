@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * event_dispatcher.h: runs deferred work on the thread owning the controls
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _EVENT_DISPATCHER_H_
+#define _EVENT_DISPATCHER_H_
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <mutex>
+#endif
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+/*
+ * One dispatcher exists per UI thread and is shared by every control living
+ * on it. Tasks may be posted from any thread, they run on the UI thread in
+ * posting order. The thread is only woken up when the queue goes from empty
+ * to non empty, so a burst of posts from several controls costs a single
+ * wakeup.
+ *
+ * The wakeup goes through a message only window on Windows. Elsewhere the
+ * dispatcher exposes a file descriptor (an eventfd on Linux) a host event
+ * loop can watch for reading before calling drain(), or the host simply
+ * calls wait_and_drain() from its loop.
+ */
+class event_dispatcher : public std::enable_shared_from_this<event_dispatcher>
+{
+public:
+    typedef std::function<void()> task;
+
+    ~event_dispatcher();
+    event_dispatcher(const event_dispatcher&) = delete;
+    event_dispatcher& operator=(const event_dispatcher&) = delete;
+
+    // dispatcher of the calling thread, created on first use and
+    // destroyed once the last control of the thread lets it go
+    static std::shared_ptr<event_dispatcher> current();
+
+    // queues fn on behalf of owner, allowed from any thread,
+    // returns false if the wakeup backend could not be set up
+    bool post(const void *owner, task fn);
+
+    // drops the tasks owner still has pending, a task already
+    // running is not interrupted
+    void cancel(const void *owner);
+
+    // runs pending tasks, including the ones they post themselves,
+    // must be called on the dispatcher thread
+    void drain();
+
+#if !defined(_WIN32)
+    int wakeup_fd() const
+        { return _fd; }
+
+    // waits up to timeout_ms (-1 for ever) for posted tasks and runs them,
+    // must be called on the dispatcher thread, returns false on timeout
+    bool wait_and_drain(int timeout_ms);
+#endif
+
+private:
+    event_dispatcher();
+
+    bool wake();
+    void clear_wakeup();
+    void lock();
+    void unlock();
+
+    struct pending
+    {
+        const void *owner;
+        task        fn;
+    };
+
+    std::deque<pending> _tasks;
+    bool                _signaled;
+#if defined(_WIN32)
+    CRITICAL_SECTION    _cs;
+    HWND                _hwnd;
+#else
+    std::mutex          _mutex;
+    int                 _fd;
+    int                 _wfd;
+#endif
+};
+
+#endif //_EVENT_DISPATCHER_H_
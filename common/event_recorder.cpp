@@ -0,0 +1,294 @@
+/*****************************************************************************
+ * event_recorder.cpp: flight recorder for plugin events and commands
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  include <time.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "event_recorder.h"
+#include "monotonic_clock.h"
+
+static const char recorder_magic[8] = { 'V','L','C','E','V','R','E','C' };
+static const uint32_t recorder_version = 1;
+
+struct event_recorder::file_header
+{
+    char                  magic[8];
+    uint32_t              version;
+    uint32_t              capacity;
+    std::atomic<uint32_t> write_index;
+    uint32_t              reserved[3];
+};
+
+static uint32_t round_capacity(unsigned capacity)
+{
+    uint32_t c = 64;
+    while( c < capacity && c < (1u << 24) )
+        c <<= 1;
+    return c;
+}
+
+event_recorder::event_recorder()
+    : _header(nullptr), _records(nullptr), _mask(0), _map_size(0)
+#if defined(_WIN32)
+    , _h_file(INVALID_HANDLE_VALUE), _h_mapping(nullptr)
+#else
+    , _fd(-1)
+#endif
+{
+}
+
+event_recorder::~event_recorder()
+{
+    close();
+}
+
+bool event_recorder::open(const char *path, unsigned capacity)
+{
+    close();
+    if( !path || !*path )
+        return false;
+
+    uint32_t cap = round_capacity(capacity);
+    size_t size = sizeof(file_header) + cap * sizeof(event_record);
+    void *p;
+
+#if defined(_WIN32)
+    _h_file = CreateFileA(path, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ,
+                          NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if( _h_file == INVALID_HANDLE_VALUE )
+        return false;
+    _h_mapping = CreateFileMapping(_h_file, NULL, PAGE_READWRITE,
+                                   0, (DWORD)size, NULL);
+    if( !_h_mapping )
+    {
+        close();
+        return false;
+    }
+    p = MapViewOfFile(_h_mapping, FILE_MAP_WRITE, 0, 0, size);
+    if( !p )
+    {
+        close();
+        return false;
+    }
+#else
+    _fd = ::open(path, O_RDWR|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if( _fd < 0 )
+        return false;
+    if( ftruncate(_fd, size) != 0 )
+    {
+        close();
+        return false;
+    }
+    p = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, _fd, 0);
+    if( p == MAP_FAILED )
+    {
+        close();
+        return false;
+    }
+#endif
+
+    _map_size = size;
+    _header = new (p) file_header;
+    memcpy(_header->magic, recorder_magic, sizeof(recorder_magic));
+    _header->version = recorder_version;
+    _header->capacity = cap;
+    _header->write_index = 0;
+    memset(_header->reserved, 0, sizeof(_header->reserved));
+    _records = reinterpret_cast<event_record*>(_header + 1);
+    _mask = cap - 1;
+    return true;
+}
+
+void event_recorder::close()
+{
+#if defined(_WIN32)
+    if( _header )
+        UnmapViewOfFile(_header);
+    if( _h_mapping )
+        CloseHandle(_h_mapping);
+    if( _h_file != INVALID_HANDLE_VALUE )
+        CloseHandle(_h_file);
+    _h_mapping = nullptr;
+    _h_file = INVALID_HANDLE_VALUE;
+#else
+    if( _header )
+        munmap(_header, _map_size);
+    if( _fd >= 0 )
+        ::close(_fd);
+    _fd = -1;
+#endif
+    _header = nullptr;
+    _records = nullptr;
+    _map_size = 0;
+}
+
+void event_recorder::append(const event_record& rec)
+{
+    uint32_t idx = _header->write_index.fetch_add(1, std::memory_order_relaxed);
+    _records[idx & _mask] = rec;
+}
+
+void event_recorder::record(event_record_kind kind, int32_t id)
+{
+    if( !is_open() )
+        return;
+    event_record rec;
+    rec.timestamp_us = monotonic_now_us();
+    rec.id = id;
+    rec.kind = kind;
+    rec.arg_type = era_none;
+    rec.reserved = 0;
+    rec.arg.i = 0;
+    append(rec);
+}
+
+void event_recorder::record(event_record_kind kind, int32_t id, int64_t arg)
+{
+    if( !is_open() )
+        return;
+    event_record rec;
+    rec.timestamp_us = monotonic_now_us();
+    rec.id = id;
+    rec.kind = kind;
+    rec.arg_type = era_int;
+    rec.reserved = 0;
+    rec.arg.i = arg;
+    append(rec);
+}
+
+void event_recorder::record(event_record_kind kind, int32_t id, double arg)
+{
+    if( !is_open() )
+        return;
+    event_record rec;
+    rec.timestamp_us = monotonic_now_us();
+    rec.id = id;
+    rec.kind = kind;
+    rec.arg_type = era_float;
+    rec.reserved = 0;
+    rec.arg.f = arg;
+    append(rec);
+}
+
+namespace {
+
+class env_event_recorder : public event_recorder
+{
+public:
+    env_event_recorder()
+    {
+        const char *path = getenv("VLC_PLUGIN_RECORD");
+        if( path )
+            open(path);
+    }
+};
+
+}
+
+event_recorder& event_recorder::instance()
+{
+    static env_event_recorder recorder;
+    return recorder;
+}
+
+static void sleep_us(uint64_t us)
+{
+#if defined(_WIN32)
+    Sleep((DWORD)(us / 1000));
+#else
+    struct timespec ts;
+    ts.tv_sec = us / 1000000;
+    ts.tv_nsec = (us % 1000000) * 1000;
+    nanosleep(&ts, nullptr);
+#endif
+}
+
+long event_recorder::replay(const char *path, replay_mode mode,
+                            const std::function<void(const event_record&)>& sink)
+{
+    FILE *f = fopen(path, "rb");
+    if( !f )
+        return -1;
+
+    // only the index is atomic in the mapping, read the header field by field
+    char magic[8];
+    uint32_t fields[3];
+    if( fread(magic, sizeof(magic), 1, f) != 1
+     || fread(fields, sizeof(fields), 1, f) != 1
+     || memcmp(magic, recorder_magic, sizeof(magic)) != 0
+     || fields[0] != recorder_version
+     || fields[1] == 0 || (fields[1] & (fields[1] - 1)) != 0 )
+    {
+        fclose(f);
+        return -1;
+    }
+    uint32_t capacity = fields[1];
+    uint32_t write_index = fields[2];
+
+    std::vector<event_record> records(capacity);
+    if( fseek(f, sizeof(file_header), SEEK_SET) != 0
+     || fread(&records[0], sizeof(event_record), capacity, f) != capacity )
+    {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+
+    uint32_t count = write_index < capacity ? write_index : capacity;
+    uint32_t first = write_index - count;
+
+    uint64_t prev_ts = 0;
+    uint64_t prev_wall = 0;
+    long replayed = 0;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        const event_record& rec = records[(first + i) & (capacity - 1)];
+        if( mode == replay_realtime && replayed > 0 && rec.timestamp_us > prev_ts )
+        {
+            uint64_t target = prev_wall + (rec.timestamp_us - prev_ts);
+            uint64_t now = monotonic_now_us();
+            if( target > now )
+                sleep_us(target - now);
+        }
+        prev_ts = rec.timestamp_us;
+        prev_wall = monotonic_now_us();
+        sink(rec);
+        ++replayed;
+    }
+    return replayed;
+}
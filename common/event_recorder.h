@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * event_recorder.h: flight recorder for plugin events and commands
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _EVENT_RECORDER_H_
+#define _EVENT_RECORDER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+enum event_record_kind
+{
+    erk_event    = 1,   // libvlc event queued for the page
+    erk_command  = 2,   // scripting call received from the page
+    erk_dispatch = 3    // event delivered to the page
+};
+
+enum event_record_arg
+{
+    era_none  = 0,
+    era_int   = 1,
+    era_float = 2
+};
+
+// fixed 24 bytes record, stored as is in the ring file
+struct event_record
+{
+    uint64_t timestamp_us;
+    int32_t  id;
+    uint8_t  kind;
+    uint8_t  arg_type;
+    uint16_t reserved;
+    union {
+        int64_t i;
+        double  f;
+    } arg;
+};
+
+/*
+ * Appends records to a fixed size ring living in a memory mapped file, so
+ * the last few thousand events survive a crash or a hung page. Appending
+ * is lock free and may happen from any thread; nothing is ever flushed
+ * explicitly, the OS writes the pages back on its own.
+ */
+class event_recorder
+{
+public:
+    enum replay_mode
+    {
+        replay_fast,
+        replay_realtime
+    };
+
+    event_recorder();
+    ~event_recorder();
+    event_recorder(const event_recorder&) = delete;
+    event_recorder& operator=(const event_recorder&) = delete;
+
+    // capacity is rounded up to a power of two
+    bool open(const char *path, unsigned capacity = 16384);
+    void close();
+    bool is_open() const
+        { return _records != nullptr; }
+
+    void record(event_record_kind kind, int32_t id);
+    void record(event_record_kind kind, int32_t id, int64_t arg);
+    void record(event_record_kind kind, int32_t id, double arg);
+
+    // process wide recorder, opened on first use when the
+    // VLC_PLUGIN_RECORD environment variable names a file
+    static event_recorder& instance();
+
+    /*
+     * Feeds a recording to sink, oldest record first. In realtime mode the
+     * original spacing between records is reproduced, otherwise records are
+     * handed out as fast as the sink takes them. Returns the number of
+     * records replayed, or -1 if the file is not a valid recording.
+     */
+    static long replay(const char *path, replay_mode mode,
+                       const std::function<void(const event_record&)>& sink);
+
+private:
+    void append(const event_record& rec);
+
+    struct file_header;
+
+    file_header  *_header;
+    event_record *_records;
+    uint32_t      _mask;
+    size_t        _map_size;
+#if defined(_WIN32)
+    void         *_h_file;
+    void         *_h_mapping;
+#else
+    int           _fd;
+#endif
+};
+
+#endif //_EVENT_RECORDER_H_
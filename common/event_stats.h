@@ -0,0 +1,175 @@
+/*****************************************************************************
+ * event_stats.h: event delivery latency bookkeeping
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _EVENT_STATS_H_
+#define _EVENT_STATS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <map>
+#include <string>
+
+/*
+ * Log2 histogram of latencies in microseconds: bucket 0 holds values below
+ * 1us, bucket n values in [2^(n-1), 2^n), the last bucket everything above.
+ */
+struct latency_histogram
+{
+    enum { buckets = 32 };
+
+    uint64_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint64_t bucket[buckets];
+
+    latency_histogram()
+        { clear(); }
+
+    void clear()
+    {
+        count = total_us = max_us = 0;
+        memset(bucket, 0, sizeof(bucket));
+    }
+
+    void add(uint64_t us)
+    {
+        unsigned b = 0;
+        while( b < buckets - 1 && (us >> b) != 0 )
+            ++b;
+        ++bucket[b];
+        ++count;
+        total_us += us;
+        if( us > max_us )
+            max_us = us;
+    }
+
+    uint64_t mean_us() const
+        { return count ? total_us / count : 0; }
+
+    // upper bound of the bucket holding the given fraction of samples
+    uint64_t percentile_us(double fraction) const
+    {
+        if( !count )
+            return 0;
+        uint64_t wanted = (uint64_t)(fraction * count);
+        uint64_t seen = 0;
+        for( unsigned b = 0; b < buckets; ++b )
+        {
+            seen += bucket[b];
+            if( seen > wanted || seen == count )
+                return b < buckets - 1 ? (uint64_t)1 << b : max_us;
+        }
+        return max_us;
+    }
+};
+
+/*
+ * Delivery statistics of an event queue: per event id latency between the
+ * moment an event is queued and the moment it is handed to the sink, the
+ * delay between a wakeup request and the start of the drain, and how deep
+ * the queue grew.
+ *
+ * Not thread safe, callers serialize updates and snapshots themselves.
+ */
+class event_stats
+{
+public:
+    event_stats()
+        : _depth_high_water(0), _dropped(0)
+    {
+    }
+
+    void queued(size_t depth)
+    {
+        if( depth > _depth_high_water )
+            _depth_high_water = depth;
+    }
+
+    void dropped()
+        { ++_dropped; }
+
+    void delivered(int32_t id, uint64_t queued_us, uint64_t delivered_us)
+    {
+        _latency[id].add(delivered_us > queued_us ? delivered_us - queued_us : 0);
+    }
+
+    // time between posting a wakeup and the drain actually starting,
+    // a growing tail here means the message pump is busy elsewhere
+    void woken(uint64_t requested_us, uint64_t started_us)
+    {
+        _wakeup.add(started_us > requested_us ? started_us - requested_us : 0);
+    }
+
+    void reset()
+    {
+        _latency.clear();
+        _wakeup.clear();
+        _depth_high_water = 0;
+        _dropped = 0;
+    }
+
+    const std::map<int32_t, latency_histogram>& latencies() const
+        { return _latency; }
+    const latency_histogram& wakeup() const
+        { return _wakeup; }
+    size_t depth_high_water() const
+        { return _depth_high_water; }
+    uint64_t dropped_count() const
+        { return _dropped; }
+
+    // one line per event id, then the wakeup delay and the queue figures
+    std::string report() const
+    {
+        std::string out;
+        char line[160];
+        for( const auto& l : _latency )
+        {
+            format(line, sizeof(line), "event", l.first, l.second);
+            out += line;
+        }
+        format(line, sizeof(line), "wakeup", 0, _wakeup);
+        out += line;
+        snprintf(line, sizeof(line), "queue high water %lu, dropped %llu\n",
+                 (unsigned long)_depth_high_water, (unsigned long long)_dropped);
+        out += line;
+        return out;
+    }
+
+private:
+    static void format(char *line, size_t size, const char *what, int32_t id,
+                       const latency_histogram& h)
+    {
+        snprintf(line, size, "%s %ld: count %llu, mean %llu us, p50 < %llu us, "
+                 "p99 < %llu us, max %llu us\n", what, (long)id,
+                 (unsigned long long)h.count, (unsigned long long)h.mean_us(),
+                 (unsigned long long)h.percentile_us(0.5),
+                 (unsigned long long)h.percentile_us(0.99),
+                 (unsigned long long)h.max_us);
+    }
+
+    std::map<int32_t, latency_histogram> _latency;
+    latency_histogram _wakeup;
+    size_t   _depth_high_water;
+    uint64_t _dropped;
+};
+
+#endif //_EVENT_STATS_H_
@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * folded_name_map.h: map from case insensitive UTF-16 names
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _FOLDED_NAME_MAP_H_
+#define _FOLDED_NAME_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Map from UTF-16 names, compared regardless of ASCII case, to values of
+ * type V, iterated in insertion order. Entries sit in one vector indexed
+ * by an open addressing table; the hash of the folded name is computed
+ * once, when the entry is inserted, and lookups fold both names on the fly
+ * without allocating. Values are moved in, never copied.
+ */
+template <typename V>
+class folded_name_map
+{
+public:
+    struct entry
+    {
+        std::u16string name;    // as first inserted
+        size_t         hash;
+        V              value;
+    };
+    typedef typename std::vector<entry>::const_iterator const_iterator;
+
+    folded_name_map()
+        : _slots(16, 0)
+    {
+    }
+
+    V *find(const char16_t *name, size_t len)
+    {
+        return find(name, len, fold_hash(name, len));
+    }
+
+    // inserts value, or replaces the value of an existing name
+    V& assign(const char16_t *name, size_t len, V&& value)
+    {
+        size_t hash = fold_hash(name, len);
+        V *existing = find(name, len, hash);
+        if( existing )
+        {
+            *existing = std::move(value);
+            return *existing;
+        }
+
+        if( (_entries.size() + 1) * 4 > _slots.size() * 3 )
+            rehash(_slots.size() * 2);
+        else if( _entries.empty() )
+            _entries.reserve(_slots.size() * 3 / 4);
+
+        _entries.emplace_back();
+        entry& e = _entries.back();
+        e.name.assign(name, len);
+        e.hash = hash;
+        e.value = std::move(value);
+        insert_slot(_entries.size() - 1);
+        return e.value;
+    }
+
+    void clear()
+    {
+        _entries.clear();
+        _slots.assign(16, 0);
+    }
+
+    size_t size() const
+        { return _entries.size(); }
+    bool empty() const
+        { return _entries.empty(); }
+    const_iterator begin() const
+        { return _entries.begin(); }
+    const_iterator end() const
+        { return _entries.end(); }
+
+private:
+    static char16_t fold(char16_t c)
+    {
+        return c >= u'A' && c <= u'Z' ? char16_t(c - u'A' + u'a') : c;
+    }
+
+    // FNV-1a over the folded units
+    static size_t fold_hash(const char16_t *s, size_t len)
+    {
+        uint32_t h = 2166136261u;
+        for( size_t i = 0; i < len; ++i )
+            h = (h ^ fold(s[i])) * 16777619u;
+        return h ^ (h >> 16);
+    }
+
+    static bool same_name(const std::u16string& name, const char16_t *s, size_t len)
+    {
+        if( name.size() != len )
+            return false;
+        for( size_t i = 0; i < len; ++i )
+        {
+            if( fold(name[i]) != fold(s[i]) )
+                return false;
+        }
+        return true;
+    }
+
+    V *find(const char16_t *name, size_t len, size_t hash)
+    {
+        size_t mask = _slots.size() - 1;
+        for( size_t i = hash & mask; _slots[i] != 0; i = (i + 1) & mask )
+        {
+            entry& e = _entries[_slots[i] - 1];
+            if( e.hash == hash && same_name(e.name, name, len) )
+                return &e.value;
+        }
+        return nullptr;
+    }
+
+    void insert_slot(size_t index)
+    {
+        size_t mask = _slots.size() - 1;
+        size_t i = _entries[index].hash & mask;
+        while( _slots[i] != 0 )
+            i = (i + 1) & mask;
+        _slots[i] = uint32_t(index + 1);
+    }
+
+    void rehash(size_t slots)
+    {
+        _slots.assign(slots, 0);
+        for( size_t i = 0; i < _entries.size(); ++i )
+            insert_slot(i);
+    }
+
+    std::vector<entry>    _entries;
+    // index + 1 in _entries, 0 when free; the size is a power of two
+    std::vector<uint32_t> _slots;
+};
+
+#endif //_FOLDED_NAME_MAP_H_
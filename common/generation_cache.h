@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * generation_cache.h: cache emptied lazily after invalidations from any thread
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _GENERATION_CACHE_H_
+#define _GENERATION_CACHE_H_
+
+#include <atomic>
+#include <unordered_map>
+
+/*
+ * Map whose entries belong to a generation. invalidate() may be called
+ * from any thread, it only bumps the generation; the entries are dropped,
+ * through Release, by the next find(). A value inserted after an
+ * invalidation that find() did not see yet may describe the state before
+ * the change, so it is refused.
+ *
+ * find() and insert() must run on one thread.
+ */
+template <typename Key, typename Value, typename Release>
+class generation_cache
+{
+public:
+    generation_cache()
+        : _generation(0), _seen(0)
+    {
+    }
+
+    ~generation_cache()
+        { flush(); }
+
+    generation_cache(const generation_cache&) = delete;
+    generation_cache& operator=(const generation_cache&) = delete;
+
+    void invalidate()
+        { ++_generation; }
+
+    // cached value of k, NULL on a miss
+    const Value *find(const Key& k)
+    {
+        sync();
+        auto it = _entries.find(k);
+        return it == _entries.end() ? nullptr : &it->second;
+    }
+
+    /* takes ownership of v and returns true, unless the cache was
+     * invalidated since the last find(), then v stays the caller's */
+    bool insert(const Key& k, Value v)
+    {
+        if( _generation.load() != _seen )
+            return false;
+        auto r = _entries.insert(std::make_pair(k, v));
+        if( !r.second )
+        {
+            Release()(r.first->second);
+            r.first->second = v;
+        }
+        return true;
+    }
+
+    size_t size() const
+        { return _entries.size(); }
+
+private:
+    void flush()
+    {
+        for( auto& e : _entries )
+            Release()(e.second);
+        _entries.clear();
+    }
+
+    void sync()
+    {
+        unsigned generation = _generation.load();
+        if( generation != _seen )
+        {
+            flush();
+            _seen = generation;
+        }
+    }
+
+    std::unordered_map<Key, Value> _entries;
+    std::atomic<unsigned> _generation;
+    // generation of the entries in _entries
+    unsigned _seen;
+};
+
+#endif //_GENERATION_CACHE_H_
@@ -0,0 +1,220 @@
+/*****************************************************************************
+ * meta_index.cpp: word prefix search over playlist metadata
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+
+#include "meta_index.h"
+
+static inline bool is_word(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+        || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+static inline char fold(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// calls f with each folded word of s
+template <typename F>
+static void for_each_word(const char *s, size_t len, std::string& word, F f)
+{
+    size_t i = 0;
+    while( i < len )
+    {
+        while( i < len && !is_word(s[i]) )
+            ++i;
+        if( i == len )
+            break;
+        word.clear();
+        while( i < len && is_word(s[i]) )
+            word.push_back(fold(s[i++]));
+        f(word);
+    }
+}
+
+uint32_t meta_index::push_back()
+{
+    uint32_t id = _next_id++;
+    item& it = _items[id];
+    it.pos = (unsigned)_order.size();
+    _order.push_back(id);
+    return id;
+}
+
+int meta_index::position(uint32_t id) const
+{
+    auto it = _items.find(id);
+    return it == _items.end() ? -1 : (int)it->second.pos;
+}
+
+void meta_index::drop_terms(uint32_t id, item& it)
+{
+    for( auto t : it.terms )
+    {
+        std::vector<uint32_t>& ids = t->second;
+        auto at = std::lower_bound(ids.begin(), ids.end(), id);
+        if( at != ids.end() && *at == id )
+            ids.erase(at);
+        if( ids.empty() )
+            _terms.erase(t);
+    }
+    it.terms.clear();
+}
+
+void meta_index::erase(size_t pos)
+{
+    if( pos >= _order.size() )
+        return;
+    uint32_t id = _order[pos];
+    auto it = _items.find(id);
+    drop_terms(id, it->second);
+    _items.erase(it);
+    _order.erase(_order.begin() + pos);
+    for( size_t i = pos; i < _order.size(); ++i )
+        _items[_order[i]].pos = (unsigned)i;
+}
+
+void meta_index::reorder(const std::vector<int>& sources, std::vector<uint32_t>& ids)
+{
+    std::vector<bool> kept(_order.size(), false);
+    ids.resize(sources.size());
+    for( size_t i = 0; i < sources.size(); ++i )
+    {
+        if( sources[i] >= 0 )
+        {
+            kept[sources[i]] = true;
+            ids[i] = _order[sources[i]];
+        }
+        else
+        {
+            ids[i] = _next_id++;
+            _items[ids[i]];
+        }
+    }
+
+    for( size_t pos = 0; pos < _order.size(); ++pos )
+    {
+        if( kept[pos] )
+            continue;
+        auto it = _items.find(_order[pos]);
+        drop_terms(it->first, it->second);
+        _items.erase(it);
+    }
+
+    _order = ids;
+    for( size_t i = 0; i < _order.size(); ++i )
+        _items[_order[i]].pos = (unsigned)i;
+}
+
+void meta_index::clear()
+{
+    _terms.clear();
+    _items.clear();
+    _order.clear();
+}
+
+bool meta_index::set(uint32_t id, const char * const *fields, size_t count)
+{
+    auto found = _items.find(id);
+    if( found == _items.end() )
+        return false;
+    item& it = found->second;
+    drop_terms(id, it);
+
+    std::string word;
+    for( size_t f = 0; f < count; ++f )
+    {
+        if( !fields[f] )
+            continue;
+        for_each_word(fields[f], strlen(fields[f]), word, [&](const std::string& w) {
+            auto t = _terms.insert(term_map::value_type(w, std::vector<uint32_t>())).first;
+            std::vector<uint32_t>& ids = t->second;
+            // ids only grow, an item's first word usually goes at the end
+            auto at = std::lower_bound(ids.begin(), ids.end(), id);
+            if( at != ids.end() && *at == id )
+                return;
+            ids.insert(at, id);
+            it.terms.push_back(t);
+        });
+    }
+    return true;
+}
+
+void meta_index::query(const char *query, size_t len, std::vector<unsigned>& positions) const
+{
+    positions.clear();
+
+    std::vector<uint32_t> result, matches, merged;
+    // where each list of ids starts in matches
+    std::vector<size_t> runs;
+    bool first = true;
+    std::string word;
+    for_each_word(query, len, word, [&](const std::string& prefix) {
+        if( !first && result.empty() )
+            return;
+
+        // union of the ids of every word starting with prefix: the lists
+        // are sorted, merging them pairwise beats sorting their concatenation
+        matches.clear();
+        runs.clear();
+        for( auto t = _terms.lower_bound(prefix);
+             t != _terms.end() && t->first.compare(0, prefix.size(), prefix) == 0; ++t )
+        {
+            runs.push_back(matches.size());
+            matches.insert(matches.end(), t->second.begin(), t->second.end());
+        }
+        runs.push_back(matches.size());
+        for( size_t step = 1; step + 1 < runs.size(); step *= 2 )
+        {
+            for( size_t r = 0; r + step + 1 < runs.size(); r += 2 * step )
+            {
+                size_t last = std::min(r + 2 * step, runs.size() - 1);
+                std::inplace_merge(matches.begin() + runs[r], matches.begin() + runs[r + step],
+                                   matches.begin() + runs[last]);
+            }
+        }
+        matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+        if( first )
+            result.swap(matches);
+        else
+        {
+            merged.clear();
+            std::set_intersection(result.begin(), result.end(),
+                                  matches.begin(), matches.end(), std::back_inserter(merged));
+            result.swap(merged);
+        }
+        first = false;
+    });
+
+    positions.reserve(result.size());
+    for( uint32_t id : result )
+        positions.push_back(_items.find(id)->second.pos);
+    std::sort(positions.begin(), positions.end());
+}
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * meta_index.h: word prefix search over playlist metadata
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _META_INDEX_H_
+#define _META_INDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Inverted index from the words of the playlist items' metadata to the
+ * items, answering prefix queries without reading any item. Words are
+ * runs of letters and digits, ASCII is folded to lower case and any
+ * non-ASCII byte counts as a letter, so UTF-8 words stay whole.
+ *
+ * Items have an id that is stable while positions shift: the owner adds
+ * items at the end, updates their text by id as metadata comes in, and
+ * removes them by position like mrl_index, renumbering the ones after.
+ *
+ * Not thread safe, vlc_player only uses it with the playlist locked.
+ */
+class meta_index
+{
+public:
+    meta_index()
+        : _next_id(1)
+    {
+    }
+
+    // appends an item without text, returns its id
+    uint32_t push_back();
+    void erase(size_t pos);
+    void clear();
+
+    /* rearranges the items the way mrl_index::diff() describes: ids[i]
+     * gets the id of the item now at position i, kept or added without
+     * text where sources[i] is -1; the items left out are removed */
+    void reorder(const std::vector<int>& sources, std::vector<uint32_t>& ids);
+
+    size_t size() const
+        { return _order.size(); }
+
+    // position of an item, -1 once it was removed
+    int position(uint32_t id) const;
+
+    // replaces the indexed text of an item, fields may hold null or empty
+    // strings; returns false if id was removed
+    bool set(uint32_t id, const char * const *fields, size_t count);
+
+    /* positions, in ascending order, of the items where every word of
+     * query is the prefix of an indexed word; an empty query matches
+     * nothing */
+    void query(const char *query, size_t len, std::vector<unsigned>& positions) const;
+
+private:
+    // ids of the items having a word, in ascending order
+    typedef std::map<std::string, std::vector<uint32_t> > term_map;
+
+    struct item
+    {
+        unsigned                         pos;
+        std::vector<term_map::iterator>  terms;
+    };
+
+    void drop_terms(uint32_t id, item& it);
+
+    term_map                           _terms;
+    std::unordered_map<uint32_t, item> _items;
+    // ids in list order
+    std::vector<uint32_t>              _order;
+    uint32_t                           _next_id;
+};
+
+#endif //_META_INDEX_H_
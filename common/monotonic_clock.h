@@ -0,0 +1,35 @@
+/*****************************************************************************
+ * monotonic_clock.h: monotonic timestamps for event bookkeeping
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _MONOTONIC_CLOCK_H_
+#define _MONOTONIC_CLOCK_H_
+
+#include <stdint.h>
+#include <chrono>
+
+// microseconds on a clock that never goes backwards, origin unspecified
+static inline uint64_t monotonic_now_us()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(
+                steady_clock::now().time_since_epoch() ).count();
+}
+
+#endif //_MONOTONIC_CLOCK_H_
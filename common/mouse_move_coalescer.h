@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * mouse_move_coalescer.h: merges mouse move notifications awaiting delivery
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _MOUSE_MOVE_COALESCER_H_
+#define _MOUSE_MOVE_COALESCER_H_
+
+struct mouse_move_event
+{
+    short button;
+    short shift;
+    int   x;
+    int   y;
+};
+
+/*
+ * Keeps at most one mouse move pending delivery. Moves arriving while one
+ * is still queued are folded into it: the coordinates and shift state of
+ * the latest move win, the button states are OR'ed together so a button
+ * that was briefly held is still reported.
+ *
+ * Not thread safe, callers serialize push() and take() themselves.
+ */
+class mouse_move_coalescer
+{
+public:
+    mouse_move_coalescer()
+        : _pending(false), _merged(0)
+    {
+        _ev.button = _ev.shift = 0;
+        _ev.x = _ev.y = 0;
+    }
+
+    // returns true when the caller must queue a delivery for this move,
+    // false when it was merged into the one already pending
+    bool push(const mouse_move_event& ev)
+    {
+        if( !_pending )
+        {
+            _ev = ev;
+            _pending = true;
+            return true;
+        }
+        _ev.button |= ev.button;
+        _ev.shift   = ev.shift;
+        _ev.x       = ev.x;
+        _ev.y       = ev.y;
+        ++_merged;
+        return false;
+    }
+
+    // hands out the merged move and clears the pending state,
+    // returns false if nothing was pending
+    bool take(mouse_move_event& ev)
+    {
+        if( !_pending )
+            return false;
+        ev = _ev;
+        _pending = false;
+        return true;
+    }
+
+    void reset()
+        { _pending = false; }
+
+    bool pending() const
+        { return _pending; }
+
+    // number of moves folded into a pending one since creation
+    unsigned long merged_count() const
+        { return _merged; }
+
+private:
+    mouse_move_event _ev;
+    bool             _pending;
+    unsigned long    _merged;
+};
+
+#endif //_MOUSE_MOVE_COALESCER_H_
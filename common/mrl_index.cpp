@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * mrl_index.cpp: lookup of playlist items by MRL
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <string.h>
+
+#include "mrl_index.h"
+#include "url_resolver.h"
+
+void mrl_index::push_back(const char *mrl)
+{
+    url_resolver::normalize(mrl, strlen(mrl), _scratch);
+    auto& entry = *_positions.emplace(_scratch, std::vector<unsigned>()).first;
+    entry.second.push_back((unsigned)_items.size());
+    _items.push_back(&entry);
+}
+
+void mrl_index::erase(size_t pos)
+{
+    if( pos >= _items.size() )
+        return;
+
+    position_map::value_type *entry = _items[pos];
+    auto& positions = entry->second;
+    positions.erase(std::lower_bound(positions.begin(), positions.end(), (unsigned)pos));
+    if( positions.empty() )
+        _positions.erase(entry->first);
+    _items.erase(_items.begin() + pos);
+
+    // the items that followed move down by one, their lists stay sorted
+    for( size_t i = pos; i < _items.size(); ++i )
+    {
+        auto& p = _items[i]->second;
+        *std::lower_bound(p.begin(), p.end(), (unsigned)(i + 1)) = (unsigned)i;
+    }
+}
+
+void mrl_index::clear()
+{
+    _items.clear();
+    _positions.clear();
+}
+
+void mrl_index::diff(const char * const *mrls, size_t count, std::vector<int>& sources) const
+{
+    // pair each new MRL with the next unused item naming the same resource
+    std::vector<int> candidates(count, -1);
+    std::unordered_map<const position_map::value_type*, unsigned> used;
+    for( size_t i = 0; i < count; ++i )
+    {
+        url_resolver::normalize(mrls[i], strlen(mrls[i]), _scratch);
+        auto it = _positions.find(_scratch);
+        if( it == _positions.end() )
+            continue;
+        unsigned& n = used[&*it];
+        if( n < it->second.size() )
+            candidates[i] = (int)it->second[n++];
+    }
+
+    /* longest increasing run of paired positions (patience sorting):
+     * tails[k] is the entry ending the best run of length k + 1 */
+    std::vector<size_t> tails;
+    std::vector<size_t> previous(count, (size_t)-1);
+    for( size_t i = 0; i < count; ++i )
+    {
+        if( candidates[i] < 0 )
+            continue;
+        auto at = std::lower_bound(tails.begin(), tails.end(), candidates[i],
+            [&candidates](size_t entry, int pos) { return candidates[entry] < pos; });
+        if( at != tails.begin() )
+            previous[i] = *(at - 1);
+        if( at == tails.end() )
+            tails.push_back(i);
+        else
+            *at = i;
+    }
+
+    sources.assign(count, -1);
+    for( size_t i = tails.empty() ? (size_t)-1 : tails.back(); i != (size_t)-1; i = previous[i] )
+        sources[i] = candidates[i];
+}
+
+int mrl_index::find(const char *mrl) const
+{
+    url_resolver::normalize(mrl, strlen(mrl), _scratch);
+    auto it = _positions.find(_scratch);
+    if( it == _positions.end() )
+        return -1;
+    return (int)it->second.front();
+}
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * mrl_index.h: lookup of playlist items by MRL
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _MRL_INDEX_H_
+#define _MRL_INDEX_H_
+
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Positions of the playlist items by normalized MRL (see
+ * url_resolver::normalize), so finding an MRL costs one normalization and
+ * one hash lookup instead of a scan of the media list. The owner keeps it
+ * in step with the list; removing an item renumbers the ones after it.
+ *
+ * Not thread safe, vlc_player only uses it with the playlist locked.
+ */
+class mrl_index
+{
+public:
+    void push_back(const char *mrl);
+    void erase(size_t pos);
+    void clear();
+
+    size_t size() const
+        { return _items.size(); }
+
+    // lowest position of an item naming the same resource, -1 if none
+    int find(const char *mrl) const;
+
+    /* how to turn the indexed list into mrls while keeping as many items
+     * as possible: sources[i] is the position of the item kept as mrls[i],
+     * or -1 for an item to insert, items no entry refers to are removed.
+     * Kept positions are ascending. Repeated MRLs are paired in order of
+     * appearance, the longest run of pairs in order is then kept, which is
+     * the smallest edit script whenever the MRLs are distinct. */
+    void diff(const char * const *mrls, size_t count, std::vector<int>& sources) const;
+
+private:
+    // positions in ascending order
+    typedef std::unordered_map<std::string, std::vector<unsigned> > position_map;
+
+    position_map                           _positions;
+    // entry of each item in list order, elements of an unordered_map
+    // keep their address when it rehashes
+    std::vector<position_map::value_type*> _items;
+
+    mutable std::string                    _scratch;
+};
+
+#endif //_MRL_INDEX_H_
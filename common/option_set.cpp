@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * option_set.cpp: immutable media option lists shared between items
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "option_set.h"
+
+option_set::option_set(const char * const *opts, size_t count, size_t hash)
+    : _hash(hash)
+{
+    size_t chars = 0;
+    for( size_t i = 0; i < count; ++i )
+        chars += strlen(opts[i]) + 1;
+
+    _options.reserve(chars, count);
+    for( size_t i = 0; i < count; ++i )
+        _options.append(opts[i], strlen(opts[i]));
+
+    const char **argv = _options.argv();
+    _argv.assign(argv, argv + count);
+}
+
+bool option_set::same_options(const char * const *opts, size_t count) const
+{
+    if( count != _argv.size() )
+        return false;
+    for( size_t i = 0; i < count; ++i )
+    {
+        if( strcmp(opts[i], _argv[i]) )
+            return false;
+    }
+    return true;
+}
+
+// FNV-1a over the options, each one including its terminator
+static size_t hash_options(const char * const *opts, size_t count)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for( size_t i = 0; i < count; ++i )
+    {
+        const unsigned char *p = reinterpret_cast<const unsigned char*>(opts[i]);
+        do
+        {
+            h ^= *p;
+            h *= 1099511628211ULL;
+        } while( *p++ );
+    }
+    return static_cast<size_t>(h);
+}
+
+option_set_ptr option_set_table::intern(unsigned int optc, const char **optv)
+{
+    // validate: drop empty options and the ones already listed,
+    // lists are short so the quadratic lookup is cheaper than a set
+    _scratch.clear();
+    for( unsigned int i = 0; i < optc; ++i )
+    {
+        const char *opt = optv[i];
+        if( !opt || !*opt )
+            continue;
+        bool b_dup = false;
+        for( const char *seen : _scratch )
+        {
+            if( !strcmp(seen, opt) )
+            {
+                b_dup = true;
+                break;
+            }
+        }
+        if( !b_dup )
+            _scratch.push_back(opt);
+    }
+
+    const char * const *opts = _scratch.empty() ? nullptr : &_scratch[0];
+    size_t hash = hash_options(opts, _scratch.size());
+
+    auto range = _sets.equal_range(hash);
+    for( auto it = range.first; it != range.second; ++it )
+    {
+        option_set_ptr set = it->second.lock();
+        if( set && set->same_options(opts, _scratch.size()) )
+        {
+            ++_hits;
+            return set;
+        }
+    }
+
+    option_set_ptr set = std::make_shared<const option_set>(opts, _scratch.size(), hash);
+    ++_misses;
+    if( _sets.size() >= _purge_at )
+        purge();
+    _sets.insert(std::make_pair(hash, std::weak_ptr<const option_set>(set)));
+    return set;
+}
+
+void option_set_table::purge()
+{
+    for( auto it = _sets.begin(); it != _sets.end(); )
+    {
+        if( it->second.expired() )
+            it = _sets.erase(it);
+        else
+            ++it;
+    }
+    _purge_at = _sets.size() * 2 < 64 ? 64 : _sets.size() * 2;
+}
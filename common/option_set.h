@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * option_set.h: immutable media option lists shared between items
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _OPTION_SET_H_
+#define _OPTION_SET_H_
+
+#include <stddef.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "option_tokenizer.h"
+
+/*
+ * Validated list of media options, never modified once built: empty
+ * options and repeated ones are dropped, the remaining options keep their
+ * order and live in a single arena. Sets are built by option_set_table.
+ */
+class option_set
+{
+public:
+    // opts must already be validated, see option_set_table
+    option_set(const char * const *opts, size_t count, size_t hash);
+
+    size_t size() const
+        { return _argv.size(); }
+    const char * const *argv() const
+        { return _argv.empty() ? nullptr : &_argv[0]; }
+    size_t hash() const
+        { return _hash; }
+
+    bool same_options(const char * const *opts, size_t count) const;
+
+private:
+    option_list               _options;
+    std::vector<const char *> _argv;
+    size_t                    _hash;
+};
+
+typedef std::shared_ptr<const option_set> option_set_ptr;
+
+/*
+ * Hands out one shared option_set per distinct option list. Sets are held
+ * weakly, they go away with the last media using them.
+ *
+ * Not thread safe, callers serialize intern() themselves.
+ */
+class option_set_table
+{
+public:
+    option_set_table()
+        : _hits(0), _misses(0), _purge_at(64)
+    {
+    }
+
+    option_set_ptr intern(unsigned int optc, const char **optv);
+
+    // number of lists resolved to an existing set, and of sets built
+    unsigned long hits() const
+        { return _hits; }
+    unsigned long misses() const
+        { return _misses; }
+
+private:
+    void purge();
+
+    std::unordered_multimap<size_t, std::weak_ptr<const option_set> > _sets;
+    // validated options of the list being interned, points into the caller's strings
+    std::vector<const char *> _scratch;
+    unsigned long _hits;
+    unsigned long _misses;
+    // expired entries are swept once the table reaches this size
+    size_t        _purge_at;
+};
+
+#endif //_OPTION_SET_H_
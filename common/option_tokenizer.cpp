@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * option_tokenizer.cpp: splits media option strings into a single arena
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "option_tokenizer.h"
+
+static inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+size_t option_list::parse(const char *s, size_t len)
+{
+    // the whole string is copied once, separators become terminators
+    size_t base = _arena.size();
+    _arena.append(s, len);
+    _arena.push_back('\0');
+
+    size_t count = 0;
+    size_t pos = base;
+    size_t end = base + len;
+    while( pos < end )
+    {
+        while( pos < end && is_blank(_arena[pos]) )
+            ++pos;
+
+        size_t start = pos;
+        while( pos < end && !is_blank(_arena[pos]) )
+        {
+            char c = _arena[pos++];
+            if( c == '\'' || c == '"' )
+            {
+                // an unterminated quote runs to the end of the string
+                const void *q = memchr(&_arena[pos], c, end - pos);
+                pos = q ? static_cast<const char*>(q) - _arena.data() + 1 : end;
+            }
+        }
+
+        if( pos == start )
+            break;
+        _arena[pos] = '\0';
+        _offsets.push_back(std::make_pair(start, pos - start));
+        ++count;
+        ++pos;
+    }
+    return count;
+}
+
+void option_list::append(const char *s, size_t len)
+{
+    _offsets.push_back(std::make_pair(_arena.size(), len));
+    _arena.append(s, len);
+    _arena.push_back('\0');
+}
+
+void option_list::clear()
+{
+    _offsets.clear();
+    _argv.clear();
+    _arena.clear();
+}
+
+void option_list::reserve(size_t chars, size_t count)
+{
+    _arena.reserve(chars);
+    _offsets.reserve(count);
+}
+
+option_view option_list::operator[](size_t i) const
+{
+    option_view v = { _arena.data() + _offsets[i].first, _offsets[i].second };
+    return v;
+}
+
+const char **option_list::argv()
+{
+    _argv.resize(_offsets.size());
+    for( size_t i = 0; i < _offsets.size(); ++i )
+        _argv[i] = _arena.data() + _offsets[i].first;
+    return _argv.empty() ? nullptr : &_argv[0];
+}
@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * option_tokenizer.h: splits media option strings into a single arena
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _OPTION_TOKENIZER_H_
+#define _OPTION_TOKENIZER_H_
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// points into the arena of an option_list, NUL terminated
+struct option_view
+{
+    const char *data;
+    size_t      size;
+};
+
+/*
+ * List of media options sharing one character arena. Every option is
+ * stored NUL terminated so views and argv() entries can be handed to
+ * libvlc as is; they stay valid until the list is modified.
+ */
+class option_list
+{
+public:
+    /*
+     * Splits s on blanks (spaces and tabs) and appends the options found.
+     * A single or double quote keeps blanks in the option up to the next
+     * matching quote, quotes are kept in the option. Returns the number of
+     * options appended.
+     */
+    size_t parse(const char *s, size_t len);
+    size_t parse(const std::string& s)
+        { return parse(s.data(), s.size()); }
+
+    // appends one option verbatim
+    void append(const char *s, size_t len);
+    void append(const std::string& s)
+        { append(s.data(), s.size()); }
+
+    void clear();
+    void reserve(size_t chars, size_t count);
+
+    size_t size() const
+        { return _offsets.size(); }
+    bool empty() const
+        { return _offsets.empty(); }
+
+    option_view operator[](size_t i) const;
+
+    // array of size() options for the APIs taking argc/argv
+    const char **argv();
+
+private:
+    // offset and length of each option in the arena
+    std::vector<std::pair<size_t, size_t> > _offsets;
+    std::vector<const char *> _argv;
+    std::string _arena;
+};
+
+#endif //_OPTION_TOKENIZER_H_
@@ -0,0 +1,311 @@
+/*****************************************************************************
+ * playlist_engine.h: play order, repeat and shuffle over the playlist
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _PLAYLIST_ENGINE_H_
+#define _PLAYLIST_ENGINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Playlist of items of type T in a deque, each with an id that stays the
+ * same while positions shift, and the order they play in: a permutation
+ * of the ids, the identity unless shuffled. The play cursor is a rank in
+ * that order so current(), next() and prev() are O(1) whatever the size;
+ * appending is O(1) too, inserting or erasing elsewhere renumbers the
+ * items after the change.
+ *
+ * In loop mode next() wraps at the end of the order, drawing a new
+ * permutation first when shuffled; in repeat mode next() and prev() stay
+ * on the current item, like libvlc_playback_mode_repeat. Erasing the
+ * current item leaves the cursor between its neighbours: there is no
+ * current item, next() goes on with the one that followed it.
+ *
+ * Not thread safe, vlc_player only uses it with the playlist locked.
+ */
+template <typename T>
+class playlist_engine
+{
+public:
+    enum mode_e
+    {
+        mode_default,
+        mode_loop,
+        mode_repeat
+    };
+
+    explicit playlist_engine(unsigned seed = 0)
+        : _next_id(1), _cursor(0), _on_item(false), _mode(mode_default),
+          _shuffle(false), _random(seed)
+    {
+    }
+
+    size_t size() const
+        { return _items.size(); }
+    bool empty() const
+        { return _items.empty(); }
+
+    T& operator[](size_t pos)
+        { return _items[pos].value; }
+    const T& operator[](size_t pos) const
+        { return _items[pos].value; }
+
+    uint32_t id_at(size_t pos) const
+        { return _items[pos].id; }
+    // position of an item, -1 once it was erased
+    int position(uint32_t id) const
+    {
+        auto it = _positions.find(id);
+        return it == _positions.end() ? -1 : int(it->second);
+    }
+
+    /* inserts value before pos, returns its id. Unshuffled, the item plays
+     * in list order; shuffled, it gets a random rank among the items not
+     * played yet in this pass */
+    uint32_t insert(size_t pos, T value)
+    {
+        uint32_t id = _next_id++;
+        if( _next_id == 0 )
+            _next_id = 1;
+
+        slot s;
+        s.value = std::move(value);
+        s.id = id;
+        s.rank = 0;     // set below, once the order has a place for it
+        _items.insert(_items.begin() + pos, std::move(s));
+        for( size_t i = pos; i < _items.size(); ++i )
+            _positions[_items[i].id] = uint32_t(i);
+
+        if( !_shuffle )
+        {
+            _order.insert(_order.begin() + pos, id);
+            for( size_t i = pos; i < _order.size(); ++i )
+                _items[i].rank = uint32_t(i);
+            if( pos < _cursor || (_on_item && pos == _cursor) )
+                ++_cursor;
+        }
+        else
+        {
+            // inside-out Fisher-Yates step over the unplayed ranks
+            size_t first = unplayed();
+            std::uniform_int_distribution<size_t> pick(first, _order.size());
+            size_t rank = pick(_random);
+            _order.push_back(id);
+            std::swap(_order[rank], _order.back());
+            slot_of(_order.back()).rank = uint32_t(_order.size() - 1);
+            _items[pos].rank = uint32_t(rank);
+        }
+        return id;
+    }
+
+    uint32_t push_back(T value)
+        { return insert(_items.size(), std::move(value)); }
+
+    void erase(size_t pos)
+    {
+        uint32_t id = _items[pos].id;
+        size_t rank = _items[pos].rank;
+        _positions.erase(id);
+        _items.erase(_items.begin() + pos);
+        for( size_t i = pos; i < _items.size(); ++i )
+            _positions[_items[i].id] = uint32_t(i);
+
+        _order.erase(_order.begin() + rank);
+        for( size_t r = rank; r < _order.size(); ++r )
+            slot_of(_order[r]).rank = uint32_t(r);
+
+        if( rank < _cursor )
+            --_cursor;
+        else if( rank == _cursor )
+            _on_item = false;
+    }
+
+    void clear()
+    {
+        _items.clear();
+        _positions.clear();
+        _order.clear();
+        _cursor = 0;
+        _on_item = false;
+    }
+
+    // position of the current item, -1 if there is none
+    int current() const
+        { return _on_item ? int(_positions.find(_order[_cursor])->second) : -1; }
+
+    void set_current(size_t pos)
+    {
+        _cursor = _items[pos].rank;
+        _on_item = true;
+    }
+
+    // no current item, next() starts the order over
+    void reset_current()
+    {
+        _cursor = 0;
+        _on_item = false;
+    }
+
+    // moves to the item to play after the current one and returns its
+    // position, or returns -1 and stays put at the end of the order
+    int next()
+    {
+        if( _on_item && _mode == mode_repeat )
+            return current();
+        size_t rank = _on_item ? _cursor + 1 : _cursor;
+        if( rank >= _order.size() )
+        {
+            if( _mode != mode_loop || _order.empty() )
+                return -1;
+            if( _shuffle )
+                draw(_on_item ? _order[_cursor] : 0);
+            rank = 0;
+        }
+        _cursor = rank;
+        _on_item = true;
+        return current();
+    }
+
+    int prev()
+    {
+        if( _on_item && _mode == mode_repeat )
+            return current();
+        if( _cursor == 0 )
+        {
+            if( _mode != mode_loop || _order.empty() )
+                return -1;
+            _cursor = _order.size();
+        }
+        --_cursor;
+        _on_item = true;
+        return current();
+    }
+
+    /* position next() would move to, for prefetching; -1 also when a
+     * shuffled loop wraps, the next pass being drawn only then */
+    int peek_next() const
+    {
+        if( _on_item && _mode == mode_repeat )
+            return current();
+        size_t rank = _on_item ? _cursor + 1 : _cursor;
+        if( rank >= _order.size() )
+        {
+            if( _mode != mode_loop || _order.empty() || _shuffle )
+                return -1;
+            rank = 0;
+        }
+        return int(_positions.find(_order[rank])->second);
+    }
+
+    void set_mode(mode_e mode)
+        { _mode = mode; }
+    mode_e mode() const
+        { return _mode; }
+
+    /* shuffling draws a new order starting with the current item, the
+     * others follow at random; unshuffling goes back to list order from
+     * the current item */
+    void set_shuffle(bool shuffle)
+    {
+        if( shuffle == _shuffle )
+            return;
+        _shuffle = shuffle;
+        if( shuffle )
+        {
+            uint32_t current = _on_item ? _order[_cursor] : 0;
+            draw(0);
+            if( current )
+            {
+                size_t rank = slot_of(current).rank;
+                std::swap(_order[0], _order[rank]);
+                slot_of(_order[rank]).rank = uint32_t(rank);
+                slot_of(current).rank = 0;
+            }
+            _cursor = 0;
+            return;
+        }
+
+        // the cursor keeps to the item it was on, or was about to play
+        size_t cursor = _cursor < _order.size() ? _positions[_order[_cursor]]
+                                                : _order.size();
+        for( size_t i = 0; i < _items.size(); ++i )
+        {
+            _order[i] = _items[i].id;
+            _items[i].rank = uint32_t(i);
+        }
+        _cursor = cursor;
+    }
+    bool shuffle() const
+        { return _shuffle; }
+
+private:
+    struct slot
+    {
+        T        value;
+        uint32_t id;
+        uint32_t rank;
+    };
+
+    slot& slot_of(uint32_t id)
+        { return _items[_positions[id]]; }
+
+    // first rank not played yet in this pass
+    size_t unplayed() const
+        { return _on_item ? _cursor + 1 : _cursor; }
+
+    /* new random order for a pass; last, the item that just played, does
+     * not come first again unless it is alone */
+    void draw(uint32_t last)
+    {
+        for( size_t i = _order.size(); i > 1; --i )
+        {
+            std::uniform_int_distribution<size_t> pick(0, i - 1);
+            std::swap(_order[i - 1], _order[pick(_random)]);
+        }
+        if( last && _order.size() > 1 && _order[0] == last )
+        {
+            std::uniform_int_distribution<size_t> pick(1, _order.size() - 1);
+            std::swap(_order[0], _order[pick(_random)]);
+        }
+        for( size_t r = 0; r < _order.size(); ++r )
+            slot_of(_order[r]).rank = uint32_t(r);
+    }
+
+    std::deque<slot>                       _items;
+    std::unordered_map<uint32_t, uint32_t> _positions;
+    // ids in play order, the rank of each is kept in its slot
+    std::vector<uint32_t>                  _order;
+    uint32_t                               _next_id;
+    /* rank of the current item, or when there is none, of the item
+     * next() plays */
+    size_t                                 _cursor;
+    bool                                   _on_item;
+    mode_e                                 _mode;
+    bool                                   _shuffle;
+    std::minstd_rand                       _random;
+};
+
+#endif //_PLAYLIST_ENGINE_H_
@@ -0,0 +1,472 @@
+/*****************************************************************************
+ * playlist_importer.cpp: streaming M3U and XSPF playlist parser
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define IMPORTER_HAVE_SSE2 1
+#  include <emmintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#endif
+
+#include "playlist_importer.h"
+
+// first '\n' in [p, end), end if there is none
+static const char *find_eol(const char *p, const char *end)
+{
+#if defined(IMPORTER_HAVE_SSE2)
+    const __m128i nl = _mm_set1_epi8('\n');
+    for( ; end - p >= 16; p += 16 )
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+        if( mask )
+        {
+#  if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return p + bit;
+#  else
+            return p + __builtin_ctz(mask);
+#  endif
+        }
+    }
+#endif
+    const void *found = memchr(p, '\n', end - p);
+    return found ? static_cast<const char*>(found) : end;
+}
+
+static inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void trim(const char *&s, size_t& len)
+{
+    while( len > 0 && is_blank(*s) )
+    {
+        ++s;
+        --len;
+    }
+    while( len > 0 && is_blank(s[len - 1]) )
+        --len;
+}
+
+static bool starts_with(const char *s, size_t len, const char *prefix)
+{
+    size_t n = strlen(prefix);
+    return len >= n && memcmp(s, prefix, n) == 0;
+}
+
+static void append_utf8(std::string& out, uint32_t c)
+{
+    if( c < 0x80 )
+        out.push_back((char)c);
+    else if( c < 0x800 )
+    {
+        out.push_back((char)(0xC0 | (c >> 6)));
+        out.push_back((char)(0x80 | (c & 0x3F)));
+    }
+    else if( c < 0x10000 )
+    {
+        out.push_back((char)(0xE0 | (c >> 12)));
+        out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (c & 0x3F)));
+    }
+    else
+    {
+        out.push_back((char)(0xF0 | (c >> 18)));
+        out.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+        out.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (c & 0x3F)));
+    }
+}
+
+// appends XML text to out with its entity and character references
+// replaced, unknown references are kept as they are
+static void append_xml_text(std::string& out, const char *s, size_t len)
+{
+    static const struct { const char *name; char c; } entities[] = {
+        { "amp;", '&' }, { "lt;", '<' }, { "gt;", '>' },
+        { "quot;", '"' }, { "apos;", '\'' },
+    };
+
+    size_t i = 0;
+    while( i < len )
+    {
+        const void *amp = memchr(s + i, '&', len - i);
+        size_t end = amp ? static_cast<const char*>(amp) - s : len;
+        out.append(s + i, end - i);
+        if( end == len )
+            break;
+
+        const char *ref = s + end + 1;
+        size_t left = len - end - 1;
+        size_t used = 0;
+        if( left > 1 && ref[0] == '#' )
+        {
+            bool hex = ref[1] == 'x' || ref[1] == 'X';
+            uint32_t c = 0;
+            size_t k = hex ? 2 : 1;
+            size_t digits = 0;
+            for( ; k < left && ref[k] != ';' && digits < 8; ++k, ++digits )
+            {
+                char d = ref[k];
+                int v = d >= '0' && d <= '9' ? d - '0'
+                      : hex && d >= 'a' && d <= 'f' ? d - 'a' + 10
+                      : hex && d >= 'A' && d <= 'F' ? d - 'A' + 10 : -1;
+                if( v < 0 )
+                    break;
+                c = c * (hex ? 16 : 10) + v;
+            }
+            if( digits > 0 && k < left && ref[k] == ';' && c > 0 && c <= 0x10FFFF
+             && (c < 0xD800 || c > 0xDFFF) )
+            {
+                append_utf8(out, c);
+                used = k + 1;
+            }
+        }
+        else
+        {
+            for( const auto& e : entities )
+            {
+                if( starts_with(ref, left, e.name) )
+                {
+                    out.push_back(e.c);
+                    used = strlen(e.name);
+                    break;
+                }
+            }
+        }
+        if( !used )
+            out.push_back('&');
+        i = end + 1 + used;
+    }
+}
+
+playlist_importer::playlist_importer(batch_cb cb, size_t batch_size)
+    : _cb(cb), _batch_size(batch_size ? batch_size : 1), _count(0),
+      _format(format_unknown), _bom_checked(false), _pending_pos(0),
+      _in_track(false), _field(field_none)
+{
+    _batch.reserve(_batch_size);
+}
+
+void playlist_importer::feed(const char *data, size_t len)
+{
+    if( _format == format_unknown )
+    {
+        detect(data, len);
+        return;
+    }
+    if( _format == format_m3u )
+        feed_m3u(data, len);
+    else
+    {
+        _pending.append(data, len);
+        parse_xspf(false);
+    }
+}
+
+void playlist_importer::detect(const char *data, size_t len)
+{
+    // the format is known from the first non blank character
+    _pending.append(data, len);
+    size_t i = 0;
+    if( !_bom_checked )
+    {
+        if( _pending.size() < 3 && _pending.compare(0, _pending.size(), "\xEF\xBB\xBF", _pending.size()) == 0 )
+            return;
+        _bom_checked = true;
+        if( _pending.compare(0, 3, "\xEF\xBB\xBF") == 0 )
+            _pending.erase(0, 3);
+    }
+    while( i < _pending.size() && is_blank(_pending[i]) )
+        ++i;
+    if( i == _pending.size() )
+        return;
+
+    std::string head;
+    head.swap(_pending);
+    _format = head[i] == '<' ? format_xspf : format_m3u;
+    feed(head.data(), head.size());
+}
+
+void playlist_importer::feed_m3u(const char *data, size_t len)
+{
+    const char *p = data;
+    const char *end = data + len;
+
+    // complete the line left over from the previous chunk
+    if( !_pending.empty() )
+    {
+        const char *eol = find_eol(p, end);
+        _pending.append(p, eol - p);
+        if( eol == end )
+            return;
+        m3u_line(_pending.data(), _pending.size());
+        _pending.clear();
+        p = eol + 1;
+    }
+
+    // whole lines are parsed in place
+    for( ;; )
+    {
+        const char *eol = find_eol(p, end);
+        if( eol == end )
+            break;
+        m3u_line(p, eol - p);
+        p = eol + 1;
+    }
+    _pending.assign(p, end - p);
+}
+
+void playlist_importer::m3u_line(const char *s, size_t len)
+{
+    trim(s, len);
+    if( len == 0 )
+        return;
+
+    if( s[0] != '#' )
+    {
+        emit(s, len);
+        return;
+    }
+
+    if( starts_with(s, len, "#EXTINF:") )
+    {
+        // #EXTINF:duration attributes,name where quoted attribute values
+        // may hold commas
+        bool quoted = false;
+        for( size_t i = 8; i < len; ++i )
+        {
+            if( s[i] == '"' )
+                quoted = !quoted;
+            else if( s[i] == ',' && !quoted )
+            {
+                const char *name = s + i + 1;
+                size_t name_len = len - i - 1;
+                trim(name, name_len);
+                _entry.name.assign(name, name_len);
+                break;
+            }
+        }
+    }
+    else if( starts_with(s, len, "#EXTVLCOPT:") )
+    {
+        const char *opt = s + 11;
+        size_t opt_len = len - 11;
+        trim(opt, opt_len);
+        if( opt_len > 0 )
+            _entry.options.emplace_back(opt, opt_len);
+    }
+}
+
+void playlist_importer::parse_xspf(bool last)
+{
+    const char *s = _pending.data();
+    const size_t len = _pending.size();
+    size_t pos = _pending_pos;
+
+    while( pos < len )
+    {
+        const void *lt = memchr(s + pos, '<', len - pos);
+        size_t text_end = lt ? static_cast<const char*>(lt) - s : len;
+        if( _field != field_none )
+            _text.append(s + pos, text_end - pos);
+        pos = text_end;
+        if( !lt )
+            break;
+
+        // markup, possibly cut by the end of the chunk
+        const char *m = s + pos;
+        size_t left = len - pos;
+        const char *close;
+        size_t skip;
+        if( starts_with(m, left, "<!--") )
+            close = "-->", skip = 4;
+        else if( starts_with(m, left, "<![CDATA[") )
+            close = "]]>", skip = 9;
+        else if( left < 9 && !last && (memcmp(m, "<!--", left < 4 ? left : 4) == 0
+              || memcmp(m, "<![CDATA[", left) == 0) )
+            break;
+        else
+            close = ">", skip = 1;
+
+        const char *found = nullptr;
+        size_t close_len = strlen(close);
+        for( size_t k = skip; k + close_len <= left; ++k )
+        {
+            const void *c = memchr(m + k, close[0], left - k);
+            if( !c )
+                break;
+            k = static_cast<const char*>(c) - m;
+            if( k + close_len <= left && memcmp(m + k, close, close_len) == 0 )
+            {
+                found = m + k;
+                break;
+            }
+        }
+        if( !found )
+            break;
+
+        if( skip == 9 )
+        {
+            if( _field != field_none )
+                _text.append(m + skip, found - m - skip);
+        }
+        else if( skip == 1 )
+            xspf_tag(m + 1, found - m - 1);
+        pos = found - s + close_len;
+    }
+
+    // keep the unparsed tail, compacting once most of the buffer is stale
+    _pending_pos = pos;
+    if( _pending_pos == _pending.size() )
+    {
+        _pending.clear();
+        _pending_pos = 0;
+    }
+    else if( _pending_pos > _pending.size() / 2 )
+    {
+        _pending.erase(0, _pending_pos);
+        _pending_pos = 0;
+    }
+}
+
+void playlist_importer::xspf_tag(const char *s, size_t len)
+{
+    if( len == 0 || s[0] == '?' || s[0] == '!' )
+        return;
+
+    bool closing = s[0] == '/';
+    if( closing )
+    {
+        ++s;
+        --len;
+    }
+    bool empty = len > 0 && s[len - 1] == '/';
+
+    size_t name_len = 0;
+    while( name_len < len && !is_blank(s[name_len]) && s[name_len] != '/' )
+        ++name_len;
+    // elements are told by their local name, namespaces are ignored
+    const char *colon = static_cast<const char*>(memchr(s, ':', name_len));
+    std::string name = colon ? std::string(colon + 1, s + name_len)
+                             : std::string(s, name_len);
+
+    if( name == "track" )
+    {
+        if( closing )
+        {
+            if( _in_track && !_entry.mrl.empty() )
+            {
+                std::string mrl;
+                mrl.swap(_entry.mrl);
+                emit(mrl.data(), mrl.size());
+            }
+            _entry = playlist_entry();
+            _in_track = false;
+            _field = field_none;
+        }
+        else if( !empty )
+        {
+            _entry = playlist_entry();
+            _in_track = true;
+        }
+        return;
+    }
+    if( !_in_track )
+        return;
+
+    field f = name == "location" ? field_location
+            : name == "title" ? field_title
+            : name == "option" ? field_option : field_none;
+    if( f == field_none || empty )
+        return;
+
+    if( !closing )
+    {
+        _field = f;
+        _text.clear();
+        return;
+    }
+    if( f != _field )
+        return;
+
+    std::string value;
+    const char *t = _text.data();
+    size_t t_len = _text.size();
+    trim(t, t_len);
+    append_xml_text(value, t, t_len);
+    if( f == field_location )
+        _entry.mrl.swap(value);
+    else if( f == field_title )
+        _entry.name.swap(value);
+    else if( !value.empty() )
+        _entry.options.push_back(std::move(value));
+    _field = field_none;
+}
+
+void playlist_importer::emit(const char *mrl, size_t len)
+{
+    _batch.emplace_back();
+    playlist_entry& e = _batch.back();
+    if( _resolver.has_base() && _resolver.resolve(mrl, len, _resolved) )
+        e.mrl = _resolved;
+    else
+        e.mrl.assign(mrl, len);
+    e.name.swap(_entry.name);
+    e.options.swap(_entry.options);
+    _entry.name.clear();
+    _entry.options.clear();
+    ++_count;
+
+    if( _batch.size() >= _batch_size )
+        flush();
+}
+
+void playlist_importer::flush()
+{
+    if( _batch.empty() )
+        return;
+    _cb(_batch);
+    _batch.clear();
+}
+
+void playlist_importer::finish()
+{
+    if( _format == format_m3u && !_pending.empty() )
+    {
+        m3u_line(_pending.data(), _pending.size());
+        _pending.clear();
+    }
+    else if( _format == format_xspf )
+        parse_xspf(true);
+    flush();
+}
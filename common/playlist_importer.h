@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * playlist_importer.h: streaming M3U and XSPF playlist parser
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _PLAYLIST_IMPORTER_H_
+#define _PLAYLIST_IMPORTER_H_
+
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "url_resolver.h"
+
+struct playlist_entry
+{
+    std::string              mrl;
+    std::string              name;      // empty when the playlist has none
+    std::vector<std::string> options;
+};
+
+/*
+ * Parses an M3U/M3U8 or XSPF playlist handed over in chunks of any size,
+ * so a large file is never held in memory as a whole. The format is told
+ * from the first non blank character, '<' meaning XSPF. Text is taken as
+ * UTF-8, a byte order mark is skipped.
+ *
+ * M3U: #EXTINF gives the name and #EXTVLCOPT an option of the location
+ * that follows, other comments are ignored. XSPF: the location and title
+ * of each track, and the vlc:option elements of its extension.
+ *
+ * Entries are handed to the batch callback, batch_size at a time and the
+ * rest on finish(); the callback may take the strings out of the batch.
+ * Relative locations are resolved against the base, if one is set.
+ */
+class playlist_importer
+{
+public:
+    typedef std::function<void(std::vector<playlist_entry>&)> batch_cb;
+
+    explicit playlist_importer(batch_cb cb, size_t batch_size = 256);
+
+    // returns false, and keeps locations as they are, if base is not absolute
+    bool set_base(const char *base, size_t len)
+        { return _resolver.set_base(base, len); }
+
+    void feed(const char *data, size_t len);
+    void finish();
+
+    // entries handed out so far
+    unsigned long count() const
+        { return _count; }
+
+private:
+    enum format
+    {
+        format_unknown,
+        format_m3u,
+        format_xspf
+    };
+
+    // xspf element whose text is being collected
+    enum field
+    {
+        field_none,
+        field_location,
+        field_title,
+        field_option
+    };
+
+    void detect(const char *data, size_t len);
+    void feed_m3u(const char *data, size_t len);
+    void m3u_line(const char *s, size_t len);
+    // parses what is complete from _text_pos on, everything if last
+    void parse_xspf(bool last);
+    void xspf_tag(const char *s, size_t len);
+    void emit(const char *mrl, size_t len);
+    void flush();
+
+    batch_cb                    _cb;
+    size_t                      _batch_size;
+    std::vector<playlist_entry> _batch;
+    unsigned long               _count;
+    url_resolver                _resolver;
+    std::string                 _resolved;
+
+    format                      _format;
+    bool                        _bom_checked;
+    // unparsed input: the partial last line for M3U, the document tail
+    // from _pending_pos on for XSPF
+    std::string                 _pending;
+    size_t                      _pending_pos;
+
+    // name and options given ahead of the next location
+    playlist_entry              _entry;
+    bool                        _in_track;
+    field                       _field;
+    std::string                 _text;
+};
+
+#endif //_PLAYLIST_IMPORTER_H_
@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * playlist_snapshot.h: immutable playlist copies read without locking
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _PLAYLIST_SNAPSHOT_H_
+#define _PLAYLIST_SNAPSHOT_H_
+
+#include <stddef.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/*
+ * Immutable copy of the playlist items and of the current position.
+ * Items are stored in chunks shared between successive snapshots, so a
+ * new snapshot only copies the chunks from the first changed position on,
+ * and the chunk table.
+ */
+template <typename T>
+class playlist_snapshot
+{
+public:
+    static const size_t chunk_size = 256;
+
+    playlist_snapshot()
+        : _size(0), _current(-1)
+    {
+    }
+
+    size_t size() const
+        { return _size; }
+    const T& operator[](size_t pos) const
+        { return (*_chunks[pos / chunk_size])[pos % chunk_size]; }
+    // -1 if there is no current item
+    int current() const
+        { return _current; }
+
+private:
+    template <typename> friend class snapshot_publisher;
+
+    std::vector<std::shared_ptr<const std::vector<T> > > _chunks;
+    size_t _size;
+    int    _current;
+};
+
+/*
+ * Holds the latest snapshot. Readers load it with an atomic pointer copy
+ * and keep it for as long as they need, whatever the writers do in the
+ * meantime; writers, serialized by their own lock, build the next one and
+ * swap it in.
+ */
+template <typename T>
+class snapshot_publisher
+{
+public:
+    typedef std::shared_ptr<const playlist_snapshot<T> > pointer;
+
+    snapshot_publisher()
+        : _snapshot(std::make_shared<playlist_snapshot<T> >())
+    {
+    }
+
+    pointer load() const
+        { return std::atomic_load(&_snapshot); }
+
+    /* publishes size items, get(pos) returning the one at pos, the items
+     * before from being those of the previous snapshot; from == size
+     * publishes a new current position only */
+    template <typename Get>
+    void publish(size_t size, size_t from, int current, Get get)
+    {
+        const size_t chunk_size = playlist_snapshot<T>::chunk_size;
+        pointer prev = load();
+        std::shared_ptr<playlist_snapshot<T> > next = std::make_shared<playlist_snapshot<T> >();
+
+        size_t kept;
+        if( from >= size && size == prev->_size )
+            kept = prev->_chunks.size();
+        else
+            kept = std::min(from, std::min(size, prev->_size)) / chunk_size;
+        next->_chunks.reserve((size + chunk_size - 1) / chunk_size);
+        next->_chunks.assign(prev->_chunks.begin(), prev->_chunks.begin() + kept);
+        for( size_t pos = kept * chunk_size; pos < size; pos += chunk_size )
+        {
+            std::shared_ptr<std::vector<T> > chunk = std::make_shared<std::vector<T> >();
+            size_t end = std::min(size, pos + chunk_size);
+            chunk->reserve(end - pos);
+            for( size_t i = pos; i < end; ++i )
+                chunk->push_back(get(i));
+            next->_chunks.push_back(std::move(chunk));
+        }
+        next->_size = size;
+        next->_current = current;
+        std::atomic_store(&_snapshot, pointer(std::move(next)));
+    }
+
+private:
+    pointer _snapshot;
+};
+
+#endif //_PLAYLIST_SNAPSHOT_H_
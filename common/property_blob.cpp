@@ -0,0 +1,351 @@
+/*****************************************************************************
+ * property_blob.cpp: persisted property stream codec
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "blob_cursor.h"
+#include "property_blob.h"
+#include "utf_transcoder.h"
+
+static_assert(pp_count <= 32, "one presence bit per scalar");
+
+static const char     blob_magic[4] = { 'V', 'L', 'C', 'p' };
+static const uint16_t blob_version = 2;
+// magic, version, scalar count, presence bits, size, checksum last
+static const size_t   header_size = 4 + 2 + 2 + 4 + 4 + 4;
+
+// CRC-32 of the blob, computed with the checksum field zeroed
+static uint32_t blob_checksum(const unsigned char *blob, size_t size)
+{
+    static const unsigned char zero[4] = { 0, 0, 0, 0 };
+    const size_t field = header_size - sizeof(zero);
+
+    uint32_t crc = 0xFFFFFFFFu;
+    crc = crc32_update(crc, blob, field);
+    crc = crc32_update(crc, zero, sizeof(zero));
+    crc = crc32_update(crc, blob + header_size, size - header_size);
+    return ~crc;
+}
+
+static bool is_saved_name(const char16_t *name, size_t len, const char *saved)
+{
+    for( size_t i = 0; i < len; ++i )
+    {
+        char16_t a = name[i], b = (unsigned char)saved[i];
+        if( b == 0 )
+            return false;
+        if( a >= u'A' && a <= u'Z' )
+            a = a - u'A' + u'a';
+        if( b >= u'A' && b <= u'Z' )
+            b = b - u'A' + u'a';
+        if( a != b )
+            return false;
+    }
+    return saved[len] == '\0';
+}
+
+property_blob_writer::property_blob_writer()
+    : _present(0), _count(0)
+{
+    memset(_scalars, 0, sizeof(_scalars));
+}
+
+void property_blob_writer::put(const void *p, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>(p);
+    _records.insert(_records.end(), bytes, bytes + size);
+}
+
+void property_blob_writer::put_utf8(const char16_t *s, size_t len)
+{
+    size_t at = _records.size();
+    _records.resize(at + utf16_to_utf8_length(s, len));
+    if( len > 0 )
+        utf16_to_utf8(s, len, reinterpret_cast<char*>(&_records[at]));
+}
+
+bool property_blob_writer::add_scalar(const char16_t *name, size_t len,
+                                      vlc_property_type_e type, int32_t value)
+{
+    const vlc_property_name *prop = find_property(name, len);
+    if( !prop )
+        return false;
+    const vlc_property_info& info = property_schema[prop->id];
+    if( info.type != type || !info.saved_name || !is_saved_name(name, len, info.saved_name) )
+        return false;
+    _scalars[prop->id] = value;
+    _present |= 1u << prop->id;
+    return true;
+}
+
+bool property_blob_writer::begin_record(const char16_t *name, size_t len,
+                                        property_record_type_e type)
+{
+    if( len == 0 )
+        return false;
+    size_t at = _records.size();
+    uint16_t n = 0;
+    put(&n, sizeof(n));
+    put_utf8(name, len);
+    // names longer than a uint16 are cut, they are never that long
+    size_t bytes = _records.size() - at - sizeof(n);
+    if( bytes > 0xFFFF )
+    {
+        _records.resize(at + sizeof(n) + 0xFFFF);
+        bytes = 0xFFFF;
+    }
+    n = (uint16_t)bytes;
+    memcpy(&_records[at], &n, sizeof(n));
+    uint8_t t = (uint8_t)type;
+    put(&t, sizeof(t));
+    ++_count;
+    return true;
+}
+
+bool property_blob_writer::add_bool(const char16_t *name, size_t len, bool value)
+{
+    if( add_scalar(name, len, pt_bool, value) )
+        return true;
+    if( !begin_record(name, len, prt_bool) )
+        return false;
+    uint8_t v = value;
+    put(&v, sizeof(v));
+    return true;
+}
+
+bool property_blob_writer::add_int(const char16_t *name, size_t len, int32_t value)
+{
+    if( add_scalar(name, len, pt_int, value) )
+        return true;
+    if( !begin_record(name, len, prt_int) )
+        return false;
+    put(&value, sizeof(value));
+    return true;
+}
+
+bool property_blob_writer::add_string(const char16_t *name, size_t len,
+                                      const char16_t *s, size_t slen)
+{
+    if( !begin_record(name, len, prt_string) )
+        return false;
+    size_t at = _records.size();
+    uint32_t n = 0;
+    put(&n, sizeof(n));
+    put_utf8(s, slen);
+    n = (uint32_t)(_records.size() - at - sizeof(n));
+    memcpy(&_records[at], &n, sizeof(n));
+    return true;
+}
+
+bool property_blob_writer::add_empty(const char16_t *name, size_t len)
+{
+    return begin_record(name, len, prt_empty);
+}
+
+void property_blob_writer::finish()
+{
+    uint16_t scalars = pp_count;
+    uint32_t size = (uint32_t)(sizeof(_scalars) + sizeof(_count) + _records.size());
+
+    _blob.clear();
+    _blob.reserve(header_size + size);
+    auto append = [this](const void *p, size_t n) {
+        const unsigned char *bytes = static_cast<const unsigned char*>(p);
+        _blob.insert(_blob.end(), bytes, bytes + n);
+    };
+    append(blob_magic, sizeof(blob_magic));
+    append(&blob_version, sizeof(blob_version));
+    append(&scalars, sizeof(scalars));
+    append(&_present, sizeof(_present));
+    append(&size, sizeof(size));
+    uint32_t checksum = 0;
+    append(&checksum, sizeof(checksum));
+    append(_scalars, sizeof(_scalars));
+    append(&_count, sizeof(_count));
+    if( !_records.empty() )
+        append(&_records[0], _records.size());
+
+    checksum = blob_checksum(&_blob[0], _blob.size());
+    memcpy(&_blob[header_size - sizeof(checksum)], &checksum, sizeof(checksum));
+}
+
+namespace {
+
+bool read_v1_record(blob_cursor& in, property_record& r)
+{
+    uint32_t len;
+    uint16_t type;
+    if( !in.get(&len, sizeof(len)) || len == 0 || !in.get_utf16(r.name, len)
+     || !in.get(&type, sizeof(type)) )
+        return false;
+
+    r.int_value = 0;
+    r.string_value.clear();
+    switch( type )
+    {
+    case prt_bool:
+    {
+        int16_t v;
+        if( !in.get(&v, sizeof(v)) )
+            return false;
+        r.int_value = v != 0;
+        break;
+    }
+    case prt_int:
+        if( !in.get(&r.int_value, sizeof(r.int_value)) )
+            return false;
+        break;
+    case prt_string:
+        if( !in.get(&len, sizeof(len)) || !in.get_utf16(r.string_value, len) )
+            return false;
+        break;
+    default:
+        // anything else was saved without a value
+        type = prt_empty;
+        break;
+    }
+    r.type = property_record_type_e(type);
+    return true;
+}
+
+bool read_v1(const unsigned char *data, size_t size,
+             std::vector<property_record>& records, size_t& consumed)
+{
+    static const char16_t count_name[] = u"(Count)";
+
+    blob_cursor in(data, size);
+    property_record r;
+    if( !read_v1_record(in, r) || r.type != prt_int || r.name != count_name )
+        return true;
+
+    for( uint32_t count = (uint32_t)r.int_value; count > 0; --count )
+    {
+        if( !read_v1_record(in, r) )
+            return false;
+        records.push_back(std::move(r));
+    }
+    consumed = in.pos();
+    return true;
+}
+
+bool read_v2_record(blob_cursor& in, property_record& r)
+{
+    uint16_t len;
+    uint8_t type;
+    if( !in.get(&len, sizeof(len)) || len == 0 || !in.get_utf8(r.name, len)
+     || !in.get(&type, sizeof(type)) )
+        return false;
+
+    r.int_value = 0;
+    r.string_value.clear();
+    switch( type )
+    {
+    case prt_bool:
+    {
+        uint8_t v;
+        if( !in.get(&v, sizeof(v)) )
+            return false;
+        r.int_value = v != 0;
+        break;
+    }
+    case prt_int:
+        if( !in.get(&r.int_value, sizeof(r.int_value)) )
+            return false;
+        break;
+    case prt_string:
+    {
+        uint32_t size;
+        if( !in.get(&size, sizeof(size)) || !in.get_utf8(r.string_value, size) )
+            return false;
+        break;
+    }
+    case prt_empty:
+        break;
+    default:
+        return false;
+    }
+    r.type = property_record_type_e(type);
+    return true;
+}
+
+bool read_v2(const unsigned char *data, size_t size,
+             std::vector<property_record>& records, size_t& consumed)
+{
+    blob_cursor in(data, size);
+    char magic[4];
+    uint16_t version, scalars;
+    uint32_t present, body, checksum;
+    if( !in.get(magic, sizeof(magic)) || !in.get(&version, sizeof(version))
+     || !in.get(&scalars, sizeof(scalars)) || !in.get(&present, sizeof(present))
+     || !in.get(&body, sizeof(body)) || !in.get(&checksum, sizeof(checksum)) )
+        return false;
+    if( version != blob_version || in.left() < body
+     || blob_checksum(data, header_size + body) != checksum )
+        return false;
+
+    blob_cursor content(in.at(), body);
+    // a newer writer may know more scalars, an older one fewer
+    for( uint16_t id = 0; id < scalars; ++id )
+    {
+        int32_t value;
+        if( !content.get(&value, sizeof(value)) )
+            return false;
+        if( id >= pp_count || !(present & (1u << id)) )
+            continue;
+
+        const vlc_property_info& info = property_schema[id];
+        if( !info.saved_name || (info.type != pt_bool && info.type != pt_int) )
+            continue;
+        property_record r;
+        r.name.assign(info.saved_name, info.saved_name + strlen(info.saved_name));
+        r.type = info.type == pt_bool ? prt_bool : prt_int;
+        r.int_value = info.type == pt_bool ? value != 0 : value;
+        records.push_back(std::move(r));
+    }
+
+    uint32_t count;
+    if( !content.get(&count, sizeof(count)) )
+        return false;
+    property_record r;
+    while( count-- )
+    {
+        if( !read_v2_record(content, r) )
+            return false;
+        records.push_back(std::move(r));
+    }
+    consumed = header_size + body;
+    return true;
+}
+
+}
+
+bool read_property_blob(const unsigned char *data, size_t size,
+                        std::vector<property_record>& records, size_t& consumed)
+{
+    consumed = 0;
+    if( size >= sizeof(blob_magic) && memcmp(data, blob_magic, sizeof(blob_magic)) == 0 )
+        return read_v2(data, size, records, consumed);
+    return read_v1(data, size, records, consumed);
+}
@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * property_blob.h: persisted property stream codec
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _PROPERTY_BLOB_H_
+#define _PROPERTY_BLOB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "property_schema.h"
+
+/*
+ * The property stream of the ActiveX control, built and parsed in memory
+ * so that saving is one write and loading one read. Multi-byte fields are
+ * in host byte order.
+ *
+ * Version 2, written by property_blob_writer:
+ *
+ *   header   "VLCp", uint16 version, uint16 scalar count, uint32 bit per
+ *            scalar present, uint32 size of what follows, and the CRC-32
+ *            of the whole blob taken with this last field zeroed
+ *   scalars  one int32 per property_schema entry, by vlc_property_e, for
+ *            the boolean and integer properties saved under their
+ *            canonical name; loading them is a copy
+ *   records  uint32 count, then for each one a uint16 name size, UTF-8
+ *            name, uint8 type and the value: uint8 for booleans, int32
+ *            for integers, uint32 size and UTF-8 bytes for strings
+ *
+ * Version 1, still read: a "(Count)" record holding the number of
+ * records that follow, each being a uint32 name length, UTF-16 name,
+ * uint16 type and the value: int16 for booleans, int32 for integers,
+ * uint32 length and UTF-16 units for strings.
+ *
+ * Type values are those of VT_EMPTY, VT_I4, VT_BSTR and VT_BOOL.
+ */
+enum property_record_type_e
+{
+    prt_empty  = 0,
+    prt_int    = 3,
+    prt_string = 8,
+    prt_bool   = 11
+};
+
+struct property_record
+{
+    std::u16string          name;
+    property_record_type_e  type;
+    int32_t                 int_value;  // also holds booleans, 0 or 1
+    std::u16string          string_value;
+};
+
+class property_blob_writer
+{
+public:
+    property_blob_writer();
+
+    // all return false, and write nothing, for an empty name
+    bool add_bool(const char16_t *name, size_t len, bool value);
+    bool add_int(const char16_t *name, size_t len, int32_t value);
+    bool add_string(const char16_t *name, size_t len, const char16_t *s, size_t slen);
+    bool add_empty(const char16_t *name, size_t len);
+
+    // completes the blob, data() and size() are only valid afterwards
+    void finish();
+
+    const unsigned char *data() const
+        { return _blob.empty() ? nullptr : &_blob[0]; }
+    size_t size() const
+        { return _blob.size(); }
+
+private:
+    bool add_scalar(const char16_t *name, size_t len, vlc_property_type_e type, int32_t value);
+    bool begin_record(const char16_t *name, size_t len, property_record_type_e type);
+    void put_utf8(const char16_t *s, size_t len);
+    void put(const void *p, size_t size);
+
+    int32_t                    _scalars[pp_count];
+    uint32_t                   _present;
+    uint32_t                   _count;
+    std::vector<unsigned char> _records;
+    std::vector<unsigned char> _blob;
+};
+
+/* appends the properties of a blob of either version to records and
+ * sets consumed to its size; data that is no property blob at all loads
+ * as no property. Returns false on a corrupt blob. */
+bool read_property_blob(const unsigned char *data, size_t size,
+                        std::vector<property_record>& records, size_t& consumed);
+
+#endif //_PROPERTY_BLOB_H_
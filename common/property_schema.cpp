@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * property_schema.cpp: persisted properties of the player controls
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#include "property_schema.h"
+
+const vlc_property_info property_schema[pp_count] = {
+    /* pp_mrl                */ { "MRL",               pt_string, 0   },
+    /* pp_autoplay           */ { "AutoPlay",          pt_bool,   1   },
+    /* pp_toolbar            */ { "Toolbar",           pt_bool,   1   },
+    /* pp_extent_width       */ { "ExtentWidth",       pt_int,    320 },
+    /* pp_extent_height      */ { "ExtentHeight",      pt_int,    240 },
+    /* pp_autoloop           */ { "AutoLoop",          pt_bool,   0   },
+    /* pp_mute               */ { nullptr,             pt_bool,   0   },
+    /* pp_visible            */ { "Visible",           pt_bool,   1   },
+    /* pp_volume             */ { "Volume",            pt_int,    100 },
+    /* pp_start_time         */ { "StartTime",         pt_int,    0   },
+    /* pp_base_url           */ { "BaseURL",           pt_string, 0   },
+    /* pp_back_color         */ { "BackColor",         pt_int,    0   },
+    /* pp_fullscreen_enabled */ { "FullscreenEnabled", pt_bool,   1   },
+    /* pp_branding           */ { "Branding",          pt_bool,   1   },
+    /* pp_resume_playback    */ { "ResumePlayback",    pt_bool,   0   },
+};
+
+const vlc_property_name property_names[] = {
+    { "mrl",               pp_mrl,                pt_string     },
+    { "src",               pp_mrl,                pt_string     },
+    { "filename",          pp_mrl,                pt_string     },
+    { "target",            pp_mrl,                pt_string     },
+    { "autoplay",          pp_autoplay,           pt_bool       },
+    { "autostart",         pp_autoplay,           pt_bool       },
+    { "toolbar",           pp_toolbar,            pt_bool       },
+    { "controls",          pp_toolbar,            pt_bool       },
+    { "extentwidth",       pp_extent_width,       pt_int        },
+    { "extentheight",      pp_extent_height,      pt_int        },
+    { "autoloop",          pp_autoloop,           pt_bool       },
+    { "loop",              pp_autoloop,           pt_bool       },
+    { "mute",              pp_mute,               pt_bool       },
+    { "visible",           pp_visible,            pt_bool       },
+    { "showdisplay",       pp_visible,            pt_bool       },
+    { "volume",            pp_volume,             pt_int        },
+    { "starttime",         pp_start_time,         pt_int        },
+    { "baseurl",           pp_base_url,           pt_string     },
+    { "backcolor",         pp_back_color,         pt_int        },
+    { "bgcolor",           pp_back_color,         pt_html_color },
+    { "fullscreenenabled", pp_fullscreen_enabled, pt_bool       },
+    { "allowfullscreen",   pp_fullscreen_enabled, pt_bool       },
+    { "fullscreen",        pp_fullscreen_enabled, pt_bool       },
+    { "branding",          pp_branding,           pt_bool       },
+    { "resumeplayback",    pp_resume_playback,    pt_bool       },
+};
+
+const size_t property_names_count = sizeof(property_names) / sizeof(property_names[0]);
+
+namespace {
+
+inline unsigned char fold(char c)
+{
+    return (unsigned char)(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+}
+
+// FNV-1a of the lowercased name, perturbed by seed
+uint32_t hash_name(const char *s, size_t len, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ seed;
+    for( size_t i = 0; i < len; ++i )
+    {
+        h ^= fold(s[i]);
+        h *= 16777619u;
+    }
+    // the low bits of FNV only depend on the low bits of its input
+    return h ^ (h >> 16);
+}
+
+bool same_name(const char *a, size_t len, const char *b)
+{
+    for( size_t i = 0; i < len; ++i )
+    {
+        if( fold(a[i]) != (unsigned char)b[i] )
+            return false;
+    }
+    return b[len] == '\0';
+}
+
+/* slot of every name, searched once for the first seed that puts each
+ * name in a slot of its own, so a lookup is one hash and one compare */
+class name_table
+{
+public:
+    static const size_t size = 64;
+
+    name_table()
+    {
+        for( _seed = 0; !fill(); ++_seed )
+            ;
+    }
+
+    const vlc_property_name *find(const char *name, size_t len) const
+    {
+        unsigned char slot = _slots[hash_name(name, len, _seed) % size];
+        if( slot == 0 )
+            return nullptr;
+        const vlc_property_name *p = &property_names[slot - 1];
+        return same_name(name, len, p->name) ? p : nullptr;
+    }
+
+private:
+    bool fill()
+    {
+        memset(_slots, 0, sizeof(_slots));
+        for( size_t i = 0; i < property_names_count; ++i )
+        {
+            const char *name = property_names[i].name;
+            unsigned char& slot = _slots[hash_name(name, strlen(name), _seed) % size];
+            if( slot != 0 )
+                return false;
+            slot = (unsigned char)(i + 1);
+        }
+        return true;
+    }
+
+    uint32_t      _seed;
+    // index + 1 in property_names, 0 when free
+    unsigned char _slots[size];
+};
+
+}
+
+const vlc_property_name *find_property(const char *name, size_t len)
+{
+    static const name_table table;
+    return table.find(name, len);
+}
@@ -0,0 +1,104 @@
+/*****************************************************************************
+ * property_schema.h: persisted properties of the player controls
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _PROPERTY_SCHEMA_H_
+#define _PROPERTY_SCHEMA_H_
+
+#include <stddef.h>
+
+/*
+ * The persisted properties, in the order they are loaded. Loading, saving
+ * and resetting the control all walk these tables instead of naming every
+ * property by hand.
+ */
+enum vlc_property_e
+{
+    pp_mrl,
+    pp_autoplay,
+    pp_toolbar,
+    pp_extent_width,
+    pp_extent_height,
+    pp_autoloop,
+    pp_mute,
+    pp_visible,
+    pp_volume,
+    pp_start_time,
+    pp_base_url,
+    pp_back_color,
+    pp_fullscreen_enabled,
+    pp_branding,
+    pp_resume_playback,
+    pp_count
+};
+
+enum vlc_property_type_e
+{
+    pt_bool,
+    pt_int,
+    pt_string,
+    // "#RRGGBB" string standing for an int property
+    pt_html_color
+};
+
+struct vlc_property_info
+{
+    // name written on save, nullptr for properties that are only loaded
+    const char          *saved_name;
+    vlc_property_type_e  type;
+    // extents are in pixels, strings default to empty
+    int                  default_value;
+};
+
+// a name accepted on load, the canonical one or an alias
+struct vlc_property_name
+{
+    const char          *name;
+    vlc_property_e       id;
+    vlc_property_type_e  type;
+};
+
+extern const vlc_property_info property_schema[pp_count];
+
+// grouped by property in load order, the first name found wins
+extern const vlc_property_name property_names[];
+extern const size_t property_names_count;
+
+// case insensitive lookup of a load name, through a perfect hash of all
+// the names; nullptr when unknown
+const vlc_property_name *find_property(const char *name, size_t len);
+
+// same for wide names, anything outside ASCII is unknown
+template <typename C>
+const vlc_property_name *find_property(const C *name, size_t len)
+{
+    char ascii[32];
+    if( len >= sizeof(ascii) )
+        return nullptr;
+    for( size_t i = 0; i < len; ++i )
+    {
+        if( name[i] <= 0 || name[i] >= 0x80 )
+            return nullptr;
+        ascii[i] = (char)name[i];
+    }
+    return find_property(ascii, len);
+}
+
+#endif //_PROPERTY_SCHEMA_H_
@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * resume_store.cpp: last playback position of each MRL, kept on disk
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <cstring>
+
+#include "resume_store.h"
+#include "url_resolver.h"
+
+static const char resume_magic[8] = { 'V','L','C','R','E','S','U','M' };
+static const uint32_t resume_version = 1;
+// slots an MRL may take, starting from its home slot
+static const uint32_t probe_window = 8;
+
+struct resume_store::file_header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t slot_count;
+    // bumped on each store and lookup hit, stamps the slots for eviction
+    uint32_t clock;
+    uint32_t reserved[3];
+};
+
+// fixed 40 bytes slot, key 0 marks a free one
+struct resume_store::slot
+{
+    uint64_t key;
+    uint32_t stamp;
+    uint32_t check;
+    int64_t  time;
+    int32_t  audio_track;
+    int32_t  subtitle_track;
+    int32_t  video_track;
+    uint32_t reserved;
+};
+
+static uint64_t fnv1a(const void *p, size_t size, uint64_t h = 14695981039346656037ULL)
+{
+    const unsigned char *b = static_cast<const unsigned char*>(p);
+    for( size_t i = 0; i < size; ++i )
+        h = (h ^ b[i]) * 1099511628211ULL;
+    return h;
+}
+
+static uint32_t slot_check(uint64_t key, const resume_entry& e)
+{
+    uint64_t h = fnv1a(&key, sizeof(key));
+    h = fnv1a(&e.time, sizeof(e.time), h);
+    h = fnv1a(&e.audio_track, sizeof(e.audio_track), h);
+    h = fnv1a(&e.subtitle_track, sizeof(e.subtitle_track), h);
+    h = fnv1a(&e.video_track, sizeof(e.video_track), h);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static uint32_t round_slots(unsigned slots)
+{
+    uint32_t n = 64;
+    while( n < slots && n < (1u << 20) )
+        n <<= 1;
+    return n;
+}
+
+resume_store::resume_store()
+    : _header(nullptr), _slots(nullptr), _mask(0), _map_size(0)
+#if defined(_WIN32)
+    , _h_file(INVALID_HANDLE_VALUE), _h_mapping(nullptr)
+#else
+    , _fd(-1)
+#endif
+{
+}
+
+resume_store::~resume_store()
+{
+    close();
+}
+
+bool resume_store::open(const char *path, unsigned slots)
+{
+    close();
+    if( !path || !*path )
+        return false;
+
+    uint32_t count = round_slots(slots);
+    size_t size = sizeof(file_header) + count * sizeof(slot);
+    void *p;
+
+#if defined(_WIN32)
+    _h_file = CreateFileA(path, GENERIC_READ|GENERIC_WRITE,
+                          FILE_SHARE_READ|FILE_SHARE_WRITE,
+                          NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if( _h_file == INVALID_HANDLE_VALUE )
+        return false;
+    // grows a shorter file, a longer one is only mapped in part
+    _h_mapping = CreateFileMapping(_h_file, NULL, PAGE_READWRITE,
+                                   0, (DWORD)size, NULL);
+    if( !_h_mapping )
+    {
+        close();
+        return false;
+    }
+    p = MapViewOfFile(_h_mapping, FILE_MAP_WRITE, 0, 0, size);
+    if( !p )
+    {
+        close();
+        return false;
+    }
+#else
+    _fd = ::open(path, O_RDWR|O_CREAT|O_CLOEXEC, 0644);
+    if( _fd < 0 )
+        return false;
+    struct stat st;
+    if( fstat(_fd, &st) != 0
+     || ((size_t)st.st_size < size && ftruncate(_fd, size) != 0) )
+    {
+        close();
+        return false;
+    }
+    p = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, _fd, 0);
+    if( p == MAP_FAILED )
+    {
+        close();
+        return false;
+    }
+#endif
+
+    _map_size = size;
+    _header = static_cast<file_header*>(p);
+    _slots = reinterpret_cast<slot*>(_header + 1);
+    _mask = count - 1;
+
+    if( memcmp(_header->magic, resume_magic, sizeof(resume_magic)) != 0
+     || _header->version != resume_version || _header->slot_count != count )
+    {
+        memset(p, 0, size);
+        memcpy(_header->magic, resume_magic, sizeof(resume_magic));
+        _header->version = resume_version;
+        _header->slot_count = count;
+    }
+    return true;
+}
+
+void resume_store::close()
+{
+#if defined(_WIN32)
+    if( _header )
+        UnmapViewOfFile(_header);
+    if( _h_mapping )
+        CloseHandle(_h_mapping);
+    if( _h_file != INVALID_HANDLE_VALUE )
+        CloseHandle(_h_file);
+    _h_mapping = nullptr;
+    _h_file = INVALID_HANDLE_VALUE;
+#else
+    if( _header )
+        munmap(_header, _map_size);
+    if( _fd >= 0 )
+        ::close(_fd);
+    _fd = -1;
+#endif
+    _header = nullptr;
+    _slots = nullptr;
+    _map_size = 0;
+}
+
+uint64_t resume_store::key(const char *mrl, size_t len)
+{
+    url_resolver::normalize(mrl, len, _scratch);
+    uint64_t k = fnv1a(_scratch.data(), _scratch.size());
+    return k ? k : 1;
+}
+
+resume_store::slot *resume_store::find(uint64_t key, resume_entry *entry)
+{
+    for( uint32_t i = 0; i < probe_window; ++i )
+    {
+        slot *s = &_slots[(key + i) & _mask];
+        if( s->key != key )
+            continue;
+        resume_entry e;
+        e.time = s->time;
+        e.audio_track = s->audio_track;
+        e.subtitle_track = s->subtitle_track;
+        e.video_track = s->video_track;
+        if( s->check != slot_check(key, e) )
+            continue;
+        if( entry )
+            *entry = e;
+        return s;
+    }
+    return nullptr;
+}
+
+bool resume_store::lookup(const char *mrl, size_t len, resume_entry& entry)
+{
+    if( !is_open() )
+        return false;
+    slot *s = find(key(mrl, len), &entry);
+    if( !s )
+        return false;
+    // the stamp is outside the check, refreshing it cannot tear the slot
+    s->stamp = ++_header->clock;
+    return true;
+}
+
+void resume_store::store(const char *mrl, size_t len, const resume_entry& entry)
+{
+    if( !is_open() )
+        return;
+
+    uint64_t k = key(mrl, len);
+    slot *s = find(k, nullptr);
+    if( !s )
+    {
+        // a free slot, or the one used the longest ago
+        uint32_t now = _header->clock;
+        for( uint32_t i = 0; i < probe_window; ++i )
+        {
+            slot *candidate = &_slots[(k + i) & _mask];
+            if( candidate->key == 0 )
+            {
+                s = candidate;
+                break;
+            }
+            if( !s || now - candidate->stamp > now - s->stamp )
+                s = candidate;
+        }
+    }
+
+    s->key = k;
+    s->stamp = ++_header->clock;
+    s->time = entry.time;
+    s->audio_track = entry.audio_track;
+    s->subtitle_track = entry.subtitle_track;
+    s->video_track = entry.video_track;
+    s->check = slot_check(k, entry);
+}
+
+void resume_store::erase(const char *mrl, size_t len)
+{
+    if( !is_open() )
+        return;
+    // lookups scan the whole window, a slot can be freed in place
+    slot *s = find(key(mrl, len), nullptr);
+    if( s )
+        memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * resume_store.h: last playback position of each MRL, kept on disk
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _RESUME_STORE_H_
+#define _RESUME_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+struct resume_entry
+{
+    int64_t time;           // in ms
+    // libvlc track ids, -1 for none
+    int32_t audio_track;
+    int32_t subtitle_track;
+    int32_t video_track;
+};
+
+/*
+ * Maps MRLs, normalized with url_resolver::normalize, to where their
+ * playback stopped. The table has a fixed number of slots and lives in a
+ * memory mapped file shared by every player: an MRL may only sit in the
+ * few slots following its home slot, and when they are all taken the
+ * least recently used one, stored or looked up, is reused. Nothing is ever flushed
+ * explicitly, the OS writes the pages back on its own.
+ *
+ * Writers do not lock each other out. Each slot carries a check value, a
+ * slot torn by two concurrent writers reads as missing instead of as a
+ * wrong position.
+ */
+class resume_store
+{
+public:
+    resume_store();
+    ~resume_store();
+    resume_store(const resume_store&) = delete;
+    resume_store& operator=(const resume_store&) = delete;
+
+    // a file of another size or version is reset, slots is rounded up to
+    // a power of two
+    bool open(const char *path, unsigned slots = 4096);
+    void close();
+    bool is_open() const
+        { return _slots != nullptr; }
+
+    bool lookup(const char *mrl, size_t len, resume_entry& entry);
+    void store(const char *mrl, size_t len, const resume_entry& entry);
+    void erase(const char *mrl, size_t len);
+
+private:
+    struct file_header;
+    struct slot;
+
+    uint64_t key(const char *mrl, size_t len);
+    // slot holding key, nullptr if none does
+    slot *find(uint64_t key, resume_entry *entry);
+
+    file_header *_header;
+    slot        *_slots;
+    uint32_t     _mask;
+    size_t       _map_size;
+#if defined(_WIN32)
+    void        *_h_file;
+    void        *_h_mapping;
+#else
+    int          _fd;
+#endif
+    std::string  _scratch;
+};
+
+#endif //_RESUME_STORE_H_
@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * session_blob.cpp: playback session snapshot codec
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <algorithm>
+
+#include "blob_cursor.h"
+#include "session_blob.h"
+
+static const char     session_magic[4] = { 'V', 'L', 'C', 's' };
+static const uint16_t session_version = 1;
+// magic, version, padding, body size, body checksum
+static const size_t   header_size = 4 + 2 + 2 + 4 + 4;
+
+namespace {
+
+class session_writer
+{
+public:
+    explicit session_writer(std::vector<unsigned char>& out)
+        : _out(out)
+    {
+    }
+
+    void put(const void *p, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char*>(p);
+        _out.insert(_out.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void put_value(T v)
+        { put(&v, sizeof(v)); }
+
+    void put_string(const std::string& s)
+    {
+        put_value((uint32_t)s.size());
+        put(s.data(), s.size());
+    }
+
+private:
+    std::vector<unsigned char>& _out;
+};
+
+bool get_string(blob_cursor& in, std::string& s)
+{
+    uint32_t size;
+    return in.get(&size, sizeof(size)) && in.get_bytes(s, size);
+}
+
+bool read_item(blob_cursor& in, vlc_session_item& item)
+{
+    uint16_t options;
+    if( !get_string(in, item.mrl) || !in.get(&options, sizeof(options)) )
+        return false;
+    item.options.resize(options);
+    for( auto& o : item.options )
+    {
+        if( !get_string(in, o) )
+            return false;
+    }
+
+    uint8_t meta;
+    if( !in.get(&meta, sizeof(meta)) )
+        return false;
+    item.meta.resize(meta);
+    for( auto& m : item.meta )
+    {
+        uint8_t kind;
+        if( !in.get(&kind, sizeof(kind)) || !get_string(in, m.second) )
+            return false;
+        m.first = kind;
+    }
+    return true;
+}
+
+}
+
+void write_session(const vlc_session& session, std::vector<unsigned char>& blob)
+{
+    blob.clear();
+    session_writer out(blob);
+    out.put(session_magic, sizeof(session_magic));
+    out.put_value(session_version);
+    out.put_value((uint16_t)0);
+    // size and checksum are filled once the body is written
+    out.put_value((uint32_t)0);
+    out.put_value((uint32_t)0);
+
+    out.put_value((int32_t)session.current);
+    out.put_value((int64_t)session.time);
+    out.put_value((int32_t)session.audio_track);
+    out.put_value((int32_t)session.subtitle_track);
+    out.put_value((int32_t)session.video_track);
+    out.put_value((int32_t)session.volume);
+    out.put_value((uint8_t)session.mute);
+    out.put_value((uint8_t)session.loop);
+    out.put_value(session.rate);
+
+    out.put_value((uint32_t)session.items.size());
+    for( const auto& item : session.items )
+    {
+        out.put_string(item.mrl);
+        // counts are clamped to their field, nothing comes close
+        uint16_t options = (uint16_t)std::min<size_t>(item.options.size(), 0xFFFF);
+        out.put_value(options);
+        for( uint16_t i = 0; i < options; ++i )
+            out.put_string(item.options[i]);
+        uint8_t meta = (uint8_t)std::min<size_t>(item.meta.size(), 0xFF);
+        out.put_value(meta);
+        for( uint8_t i = 0; i < meta; ++i )
+        {
+            out.put_value((uint8_t)item.meta[i].first);
+            out.put_string(item.meta[i].second);
+        }
+    }
+
+    uint32_t size = (uint32_t)(blob.size() - header_size);
+    uint32_t crc = ~crc32_update(0xFFFFFFFFu, &blob[header_size], size);
+    memcpy(&blob[header_size - 2 * sizeof(uint32_t)], &size, sizeof(size));
+    memcpy(&blob[header_size - sizeof(uint32_t)], &crc, sizeof(crc));
+}
+
+bool read_session(const unsigned char *data, size_t size, vlc_session& session)
+{
+    blob_cursor in(data, size);
+    char magic[4];
+    uint16_t version, padding;
+    uint32_t body, crc;
+    if( !in.get(magic, sizeof(magic)) || memcmp(magic, session_magic, sizeof(magic)) != 0
+     || !in.get(&version, sizeof(version)) || version != session_version
+     || !in.get(&padding, sizeof(padding))
+     || !in.get(&body, sizeof(body)) || !in.get(&crc, sizeof(crc))
+     || in.left() < body || ~crc32_update(0xFFFFFFFFu, in.at(), body) != crc )
+        return false;
+
+    blob_cursor content(in.at(), body);
+    vlc_session s;
+    int32_t current, audio, subtitle, video, volume;
+    int64_t time;
+    uint8_t mute, loop;
+    uint32_t count;
+    if( !content.get(&current, sizeof(current)) || !content.get(&time, sizeof(time))
+     || !content.get(&audio, sizeof(audio)) || !content.get(&subtitle, sizeof(subtitle))
+     || !content.get(&video, sizeof(video)) || !content.get(&volume, sizeof(volume))
+     || !content.get(&mute, sizeof(mute)) || !content.get(&loop, sizeof(loop))
+     || !content.get(&s.rate, sizeof(s.rate)) || !content.get(&count, sizeof(count)) )
+        return false;
+
+    // every item takes at least 7 bytes, do not trust count any further
+    if( count > content.left() / 7 )
+        return false;
+    s.items.resize(count);
+    for( auto& item : s.items )
+    {
+        if( !read_item(content, item) )
+            return false;
+    }
+    if( content.left() != 0 || current < -1 || current >= (int32_t)count )
+        return false;
+
+    s.current = current;
+    s.time = time;
+    s.audio_track = audio;
+    s.subtitle_track = subtitle;
+    s.video_track = video;
+    s.volume = volume;
+    s.mute = mute != 0;
+    s.loop = loop != 0;
+    session = std::move(s);
+    return true;
+}
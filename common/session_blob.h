@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * session_blob.h: playback session snapshot codec
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _SESSION_BLOB_H_
+#define _SESSION_BLOB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct vlc_session_item
+{
+    std::string                                mrl;
+    std::vector<std::string>                   options;
+    // libvlc_meta_t and value of the metadata known when saved
+    std::vector<std::pair<int, std::string> >  meta;
+};
+
+// everything vlc_player::restore_session needs to resume playback
+struct vlc_session
+{
+    vlc_session()
+        : current(-1), time(0), audio_track(-1), subtitle_track(-1),
+          video_track(-1), volume(100), mute(false), loop(false), rate(1.f)
+    {
+    }
+
+    std::vector<vlc_session_item> items;
+    int      current;           // -1 when nothing was playing
+    int64_t  time;              // in ms, within the current item
+    // libvlc track ids, -1 for none
+    int      audio_track;
+    int      subtitle_track;
+    int      video_track;
+    int      volume;
+    bool     mute;
+    bool     loop;
+    float    rate;
+};
+
+/*
+ * A session is saved as "VLCs", uint16 version, uint16 zero, uint32 size
+ * of the body and its CRC-32, then the body: player state, uint32 item
+ * count and the items, each being its MRL, a uint16 count of options and
+ * the options, a uint8 count of metadata and for each one its uint8 kind
+ * and value. Strings are a uint32 size and UTF-8 bytes, multi-byte
+ * fields are in host byte order.
+ */
+void write_session(const vlc_session& session, std::vector<unsigned char>& blob);
+
+// returns false, leaving session untouched, on anything but a whole and
+// intact session blob
+bool read_session(const unsigned char *data, size_t size, vlc_session& session);
+
+#endif //_SESSION_BLOB_H_
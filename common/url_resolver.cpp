@@ -0,0 +1,327 @@
+/*****************************************************************************
+ * url_resolver.cpp: resolves relative MRLs against a base URL
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "url_resolver.h"
+
+namespace {
+
+// components of a URI reference, as offsets into the parsed string
+struct uri_parts
+{
+    size_t scheme_end;      // past the ':', 0 without scheme
+    size_t authority_end;   // past the authority, == scheme_end without one
+    size_t path_end;
+    size_t query_end;       // past the query, == path_end without one
+    bool   has_authority;
+    bool   has_query;
+};
+
+inline bool is_alpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline int hex_value(char c)
+{
+    if( is_digit(c) )
+        return c - '0';
+    if( c >= 'a' && c <= 'f' )
+        return c - 'a' + 10;
+    if( c >= 'A' && c <= 'F' )
+        return c - 'A' + 10;
+    return -1;
+}
+
+inline bool is_unreserved(char c)
+{
+    return is_alpha(c) || is_digit(c) || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+inline char to_lower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+size_t find_first(const char *s, size_t from, size_t len, const char *set)
+{
+    for( size_t i = from; i < len; ++i )
+    {
+        for( const char *c = set; *c; ++c )
+        {
+            if( s[i] == *c )
+                return i;
+        }
+    }
+    return len;
+}
+
+uri_parts split(const char *s, size_t len)
+{
+    uri_parts p;
+    size_t i = url_resolver::scheme_length(s, len);
+    p.scheme_end = i;
+
+    p.has_authority = i + 1 < len && s[i] == '/' && s[i + 1] == '/';
+    if( p.has_authority )
+        i = find_first(s, i + 2, len, "/?#");
+    p.authority_end = i;
+
+    i = find_first(s, i, len, "?#");
+    p.path_end = i;
+
+    p.has_query = i < len && s[i] == '?';
+    if( p.has_query )
+        i = find_first(s, i, len, "#");
+    p.query_end = i;
+    return p;
+}
+
+/* RFC 3986 5.2.4, the result is appended to out and segments are
+ * only ever removed from the part appended by this call */
+void remove_dot_segments(const char *in, size_t len, std::string& out)
+{
+    const size_t start = out.size();
+    size_t i = 0;
+
+    // drops the last segment and its leading '/' from the output
+    auto pop_segment = [&out, start]() {
+        size_t slash = out.rfind('/');
+        out.resize(slash == std::string::npos || slash < start ? start : slash);
+    };
+
+    while( i < len )
+    {
+        size_t left = len - i;
+        const char *p = in + i;
+
+        if( left >= 3 && p[0] == '.' && p[1] == '.' && p[2] == '/' )
+            i += 3;
+        else if( left >= 2 && p[0] == '.' && p[1] == '/' )
+            i += 2;
+        else if( left >= 3 && p[0] == '/' && p[1] == '.' && p[2] == '/' )
+            i += 2;
+        else if( left == 2 && p[0] == '/' && p[1] == '.' )
+        {
+            out.push_back('/');
+            break;
+        }
+        else if( left >= 4 && p[0] == '/' && p[1] == '.' && p[2] == '.' && p[3] == '/' )
+        {
+            i += 3;
+            pop_segment();
+        }
+        else if( left == 3 && p[0] == '/' && p[1] == '.' && p[2] == '.' )
+        {
+            pop_segment();
+            out.push_back('/');
+            break;
+        }
+        else if( (left == 1 && p[0] == '.')
+              || (left == 2 && p[0] == '.' && p[1] == '.') )
+            break;
+        else
+        {
+            // move the first segment, with its leading '/', to the output
+            size_t end = i + 1;
+            while( end < len && in[end] != '/' )
+                ++end;
+            out.append(in + i, end - i);
+            i = end;
+        }
+    }
+}
+
+}
+
+size_t url_resolver::scheme_length(const char *s, size_t len)
+{
+    if( len == 0 || !is_alpha(s[0]) )
+        return 0;
+    for( size_t i = 1; i < len; ++i )
+    {
+        char c = s[i];
+        if( c == ':' )
+            return i + 1;
+        /* VLC uses / to allow user to specify a demuxer */
+        if( !is_alpha(c) && !is_digit(c)
+         && c != '+' && c != '-' && c != '.' && c != '/' )
+            return 0;
+    }
+    return 0;
+}
+
+void url_resolver::clear()
+{
+    _base.clear();
+    _scheme_end = _authority_end = _path_end = _dir_end = 0;
+    _has_authority = false;
+}
+
+bool url_resolver::set_base(const char *base, size_t len)
+{
+    clear();
+    uri_parts p = split(base, len);
+
+    // a base without scheme must be an absolute path
+    if( p.scheme_end == 0 && (p.has_authority || p.path_end == 0 || base[0] != '/') )
+        return false;
+
+    _base.reserve(len + 1);
+    _base.append(base, p.authority_end);
+    remove_dot_segments(base + p.authority_end, p.path_end - p.authority_end, _base);
+    _path_end = _base.size();
+    // the fragment of the base never shows up in a resolved reference
+    _base.append(base + p.path_end, p.query_end - p.path_end);
+
+    _scheme_end = p.scheme_end;
+    _authority_end = p.authority_end;
+    _has_authority = p.has_authority;
+
+    size_t slash = _base.rfind('/', _path_end ? _path_end - 1 : 0);
+    _dir_end = slash == std::string::npos || slash < _authority_end ? _authority_end : slash + 1;
+    return true;
+}
+
+bool url_resolver::resolve(const char *ref, size_t len, std::string& out) const
+{
+    uri_parts r = split(ref, len);
+    if( r.scheme_end )
+    {
+        out.assign(ref, len);
+        return true;
+    }
+    if( _base.empty() )
+        return false;
+
+    out.clear();
+    out.reserve(_base.size() + len + 1);
+    out.append(_base, 0, _scheme_end);
+
+    const char *path = ref + r.authority_end;
+    size_t path_len = r.path_end - r.authority_end;
+
+    if( r.has_authority )
+    {
+        out.append(ref, r.authority_end);
+        remove_dot_segments(path, path_len, out);
+    }
+    else
+    {
+        out.append(_base, _scheme_end, _authority_end - _scheme_end);
+        if( path_len == 0 )
+        {
+            out.append(_base, _authority_end, _path_end - _authority_end);
+            if( !r.has_query )
+                out.append(_base, _path_end, std::string::npos);
+        }
+        else if( path[0] == '/' )
+            remove_dot_segments(path, path_len, out);
+        else
+        {
+            // merge with the directory of the base path
+            if( _has_authority && _path_end == _authority_end )
+                _scratch.assign(1, '/');
+            else
+                _scratch.assign(_base, _authority_end, _dir_end - _authority_end);
+            _scratch.append(path, path_len);
+            remove_dot_segments(_scratch.data(), _scratch.size(), out);
+        }
+    }
+
+    // query and fragment of the reference
+    out.append(ref + r.path_end, len - r.path_end);
+    return true;
+}
+
+void url_resolver::normalize(const char *s, size_t len, std::string& out)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    /* escapes first: decoding an unreserved character never creates a
+     * delimiter, so the result splits like the original */
+    std::string escaped;
+    escaped.reserve(len);
+    for( size_t i = 0; i < len; ++i )
+    {
+        int hi, lo;
+        if( s[i] == '%' && i + 2 < len && (hi = hex_value(s[i + 1])) >= 0
+         && (lo = hex_value(s[i + 2])) >= 0 )
+        {
+            char c = (char)(hi << 4 | lo);
+            if( is_unreserved(c) )
+                escaped.push_back(c);
+            else
+            {
+                escaped.push_back('%');
+                escaped.push_back(hex[hi]);
+                escaped.push_back(hex[lo]);
+            }
+            i += 2;
+        }
+        else
+            escaped.push_back(s[i]);
+    }
+
+    const char *e = escaped.data();
+    uri_parts p = split(e, escaped.size());
+
+    out.clear();
+    out.reserve(escaped.size() + 1);
+    for( size_t i = 0; i < p.scheme_end; ++i )
+        out.push_back(to_lower(e[i]));
+
+    size_t path_begin = p.scheme_end;
+    if( p.has_authority )
+    {
+        size_t host = p.scheme_end + 2;
+        for( size_t i = host; i < p.authority_end; ++i )
+        {
+            if( e[i] == '@' )
+                host = i + 1;
+        }
+        out.append(e + p.scheme_end, host - p.scheme_end);
+        size_t host_end = p.authority_end;
+        if( host_end > host && e[host_end - 1] == ':' )
+            --host_end;
+        for( size_t i = host; i < host_end; ++i )
+            out.push_back(to_lower(e[i]));
+        path_begin = p.authority_end;
+    }
+
+    const char *path = e + path_begin;
+    size_t path_len = p.path_end - path_begin;
+    if( path_len > 0 && path[0] == '/' )
+        remove_dot_segments(path, path_len, out);
+    else if( path_len == 0 && p.has_authority && p.authority_end > p.scheme_end + 2 )
+        out.push_back('/');
+    else
+        out.append(path, path_len);
+
+    out.append(e + p.path_end, escaped.size() - p.path_end);
+}
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * url_resolver.h: resolves relative MRLs against a base URL
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _URL_RESOLVER_H_
+#define _URL_RESOLVER_H_
+
+#include <stddef.h>
+#include <string>
+
+/*
+ * Reference resolution as described in RFC 3986 section 5.2, on UTF-8
+ * strings. The base is split once when it is set, every resolve() then
+ * only parses the reference and writes the result with a single
+ * allocation.
+ *
+ * Two departures from the RFC, kept for compatibility with VLC MRLs:
+ * a scheme may contain '/' so "http/ts://host/x" (scheme plus demuxer)
+ * counts as absolute, and absolute references are returned untouched.
+ * The base may also be an absolute UNIX path instead of a URL.
+ *
+ * Not thread safe, resolve() reuses an internal scratch buffer.
+ */
+class url_resolver
+{
+public:
+    url_resolver()
+        { clear(); }
+
+    // returns false, and clears the base, if base is neither
+    // an absolute URL nor an absolute path
+    bool set_base(const char *base, size_t len);
+    void clear();
+    bool has_base() const
+        { return !_base.empty(); }
+
+    // returns false when there is no base to resolve a relative ref with
+    bool resolve(const char *ref, size_t len, std::string& out) const;
+
+    // length of the "scheme:" prefix of s, 0 if s has none
+    static size_t scheme_length(const char *s, size_t len);
+
+    /* syntax based normalization (RFC 3986 6.2.2) into out: scheme and
+     * host are lowercased, percent-encoded unreserved characters decoded
+     * and the other escapes uppercased, dot segments removed from absolute
+     * paths. An authority with an empty path gets "/" and an empty port
+     * is dropped. Two MRLs normalizing to the same string name the same
+     * resource. */
+    static void normalize(const char *s, size_t len, std::string& out);
+
+private:
+    std::string _base;
+    // the base split into scheme (with ':'), "//authority",
+    // normalized path and "?query", as offsets into _base
+    size_t _scheme_end;
+    size_t _authority_end;
+    size_t _path_end;
+    bool   _has_authority;
+    // normalized path up to and including its last '/'
+    size_t _dir_end;
+
+    mutable std::string _scratch;
+};
+
+#endif //_URL_RESOLVER_H_
@@ -0,0 +1,301 @@
+/*****************************************************************************
+ * utf_transcoder.cpp: UTF-16 <-> UTF-8 conversions
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define UTF_HAVE_SSE2 1
+#  include <emmintrin.h>
+#endif
+
+#include "utf_transcoder.h"
+
+static const char32_t replacement_char = 0xFFFD;
+
+/* ASCII fast paths: return how many leading units are ASCII, looking at
+ * whole blocks only, the scalar loops take care of the rest. After a block
+ * holding a non ASCII unit the scalar loops convert the whole block before
+ * trying again, so text without long ASCII runs does not pay for a failed
+ * block check on every unit. */
+enum { block16 = 8, block8 = 16 };
+
+static size_t ascii_prefix16(const char16_t *s, size_t len)
+{
+    size_t i = 0;
+#if defined(UTF_HAVE_SSE2)
+    const __m128i high = _mm_set1_epi16((short)0xFF80);
+    const __m128i zero = _mm_setzero_si128();
+    for( ; i + 8 <= len; i += 8 )
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i hi = _mm_cmpeq_epi16(_mm_and_si128(v, high), zero);
+        if( _mm_movemask_epi8(hi) != 0xFFFF )
+            break;
+    }
+#else
+    for( ; i + 4 <= len; i += 4 )
+    {
+        uint64_t w;
+        memcpy(&w, s + i, sizeof(w));
+        if( w & 0xFF80FF80FF80FF80ULL )
+            break;
+    }
+#endif
+    return i;
+}
+
+static size_t ascii_prefix8(const char *s, size_t len)
+{
+    size_t i = 0;
+#if defined(UTF_HAVE_SSE2)
+    for( ; i + 16 <= len; i += 16 )
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        if( _mm_movemask_epi8(v) != 0 )
+            break;
+    }
+#else
+    for( ; i + 8 <= len; i += 8 )
+    {
+        uint64_t w;
+        memcpy(&w, s + i, sizeof(w));
+        if( w & 0x8080808080808080ULL )
+            break;
+    }
+#endif
+    return i;
+}
+
+static inline bool is_high_surrogate(char32_t c)
+{
+    return c >= 0xD800 && c <= 0xDBFF;
+}
+
+static inline bool is_low_surrogate(char32_t c)
+{
+    return c >= 0xDC00 && c <= 0xDFFF;
+}
+
+// reads one code point, unpaired surrogates read as U+FFFD
+static inline char32_t next16(const char16_t *s, size_t len, size_t& i)
+{
+    char32_t c = s[i++];
+    if( is_high_surrogate(c) )
+    {
+        if( i < len && is_low_surrogate(s[i]) )
+            return 0x10000 + ((c - 0xD800) << 10) + (s[i++] - 0xDC00);
+        return replacement_char;
+    }
+    if( is_low_surrogate(c) )
+        return replacement_char;
+    return c;
+}
+
+static inline size_t utf8_size(char32_t c)
+{
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
+
+size_t utf16_to_utf8_length(const char16_t *s, size_t len)
+{
+    size_t n = 0;
+    size_t i = 0;
+    while( i < len )
+    {
+        size_t ascii = ascii_prefix16(s + i, len - i);
+        n += ascii;
+        i += ascii;
+        size_t stop = len - i > block16 ? i + block16 : len;
+        while( i < stop )
+            n += utf8_size(next16(s, len, i));
+    }
+    return n;
+}
+
+size_t utf16_to_utf8(const char16_t *s, size_t len, char *out)
+{
+    char *p = out;
+    size_t i = 0;
+    while( i < len )
+    {
+#if defined(UTF_HAVE_SSE2)
+        const __m128i high = _mm_set1_epi16((short)0xFF80);
+        const __m128i zero = _mm_setzero_si128();
+        while( i + 8 <= len )
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            if( _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, high), zero)) != 0xFFFF )
+                break;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(v, v));
+            p += 8;
+            i += 8;
+        }
+#else
+        size_t ascii = ascii_prefix16(s + i, len - i);
+        for( size_t k = 0; k < ascii; ++k )
+            *p++ = (char)s[i + k];
+        i += ascii;
+#endif
+        size_t stop = len - i > block16 ? i + block16 : len;
+        while( i < stop )
+        {
+            char32_t c = next16(s, len, i);
+            if( c < 0x80 )
+                *p++ = (char)c;
+            else if( c < 0x800 )
+            {
+                *p++ = (char)(0xC0 | (c >> 6));
+                *p++ = (char)(0x80 | (c & 0x3F));
+            }
+            else if( c < 0x10000 )
+            {
+                *p++ = (char)(0xE0 | (c >> 12));
+                *p++ = (char)(0x80 | ((c >> 6) & 0x3F));
+                *p++ = (char)(0x80 | (c & 0x3F));
+            }
+            else
+            {
+                *p++ = (char)(0xF0 | (c >> 18));
+                *p++ = (char)(0x80 | ((c >> 12) & 0x3F));
+                *p++ = (char)(0x80 | ((c >> 6) & 0x3F));
+                *p++ = (char)(0x80 | (c & 0x3F));
+            }
+        }
+    }
+    return p - out;
+}
+
+/* reads one code point, any malformed sequence reads as U+FFFD and only
+ * consumes its first byte */
+static inline char32_t next8(const unsigned char *s, size_t len, size_t& i)
+{
+    unsigned char b = s[i];
+    size_t need;
+    char32_t c, min;
+    if( b < 0x80 )
+    {
+        ++i;
+        return b;
+    }
+    else if( (b & 0xE0) == 0xC0 )
+    {
+        need = 1; c = b & 0x1F; min = 0x80;
+    }
+    else if( (b & 0xF0) == 0xE0 )
+    {
+        need = 2; c = b & 0x0F; min = 0x800;
+    }
+    else if( (b & 0xF8) == 0xF0 )
+    {
+        need = 3; c = b & 0x07; min = 0x10000;
+    }
+    else
+    {
+        ++i;
+        return replacement_char;
+    }
+
+    if( len - i <= need )
+    {
+        ++i;
+        return replacement_char;
+    }
+    for( size_t k = 1; k <= need; ++k )
+    {
+        unsigned char cont = s[i + k];
+        if( (cont & 0xC0) != 0x80 )
+        {
+            ++i;
+            return replacement_char;
+        }
+        c = (c << 6) | (cont & 0x3F);
+    }
+    if( c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF) )
+    {
+        ++i;
+        return replacement_char;
+    }
+    i += need + 1;
+    return c;
+}
+
+size_t utf8_to_utf16_length(const char *str, size_t len)
+{
+    const unsigned char *s = reinterpret_cast<const unsigned char*>(str);
+    size_t n = 0;
+    size_t i = 0;
+    while( i < len )
+    {
+        size_t ascii = ascii_prefix8(str + i, len - i);
+        n += ascii;
+        i += ascii;
+        size_t stop = len - i > block8 ? i + block8 : len;
+        while( i < stop )
+            n += next8(s, len, i) >= 0x10000 ? 2 : 1;
+    }
+    return n;
+}
+
+size_t utf8_to_utf16(const char *str, size_t len, char16_t *out)
+{
+    const unsigned char *s = reinterpret_cast<const unsigned char*>(str);
+    char16_t *p = out;
+    size_t i = 0;
+    while( i < len )
+    {
+#if defined(UTF_HAVE_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        while( i + 16 <= len )
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            if( _mm_movemask_epi8(v) != 0 )
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_unpacklo_epi8(v, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 8), _mm_unpackhi_epi8(v, zero));
+            p += 16;
+            i += 16;
+        }
+#else
+        size_t ascii = ascii_prefix8(str + i, len - i);
+        for( size_t k = 0; k < ascii; ++k )
+            *p++ = s[i + k];
+        i += ascii;
+#endif
+        size_t stop = len - i > block8 ? i + block8 : len;
+        while( i < stop )
+        {
+            char32_t c = next8(s, len, i);
+            if( c < 0x10000 )
+                *p++ = (char16_t)c;
+            else
+            {
+                c -= 0x10000;
+                *p++ = (char16_t)(0xD800 | (c >> 10));
+                *p++ = (char16_t)(0xDC00 | (c & 0x3FF));
+            }
+        }
+    }
+    return p - out;
+}
@@ -0,0 +1,45 @@
+/*****************************************************************************
+ * utf_transcoder.h: UTF-16 <-> UTF-8 conversions
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _UTF_TRANSCODER_H_
+#define _UTF_TRANSCODER_H_
+
+#include <stddef.h>
+
+/*
+ * Conversions between UTF-16 and UTF-8 that never fail: unpaired
+ * surrogates, and in UTF-8 input overlong forms, encoded surrogates, code
+ * points above U+10FFFF and truncated sequences, are replaced by U+FFFD
+ * (one replacement per offending unit or byte).
+ *
+ * The *_length() functions return the exact size of the output, in units
+ * of the output type and without terminator, so callers can allocate once
+ * and convert in place. Runs of ASCII are handled 8 or 16 units at a time.
+ */
+
+size_t utf16_to_utf8_length(const char16_t *s, size_t len);
+// out must hold utf16_to_utf8_length(s, len) bytes, returns the bytes written
+size_t utf16_to_utf8(const char16_t *s, size_t len, char *out);
+
+size_t utf8_to_utf16_length(const char *s, size_t len);
+// out must hold utf8_to_utf16_length(s, len) units, returns the units written
+size_t utf8_to_utf16(const char *s, size_t len, char16_t *out);
+
+#endif //_UTF_TRANSCODER_H_
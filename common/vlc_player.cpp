@@ -26,149 +26,1156 @@
 #if defined(_WIN32)
 #  include <windows.h>
 #else
-#  include <future>
+#  include <condition_variable>
+#  include <mutex>
 #endif
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
 
+#include "monotonic_clock.h"
 #include "vlc_player.h"
 
+#if defined(_WIN32)
+vlc_player::playlist_lock::playlist_lock()
+{
+    InitializeCriticalSection( &_cs );
+}
+
+vlc_player::playlist_lock::~playlist_lock()
+{
+    DeleteCriticalSection( &_cs );
+}
+
+void vlc_player::playlist_lock::lock()
+{
+    EnterCriticalSection( &_cs );
+}
+
+void vlc_player::playlist_lock::unlock()
+{
+    LeaveCriticalSection( &_cs );
+}
+#else
+vlc_player::playlist_lock::playlist_lock()
+{
+}
+
+vlc_player::playlist_lock::~playlist_lock()
+{
+}
+
+void vlc_player::playlist_lock::lock()
+{
+    _mutex.lock();
+}
+
+void vlc_player::playlist_lock::unlock()
+{
+    _mutex.unlock();
+}
+#endif
+
+unsigned vlc_player::shuffle_seed()
+{
+    // some random_device implementations are deterministic, the clock
+    // still tells players apart
+    return std::random_device()() ^ unsigned( monotonic_now_us() );
+}
+
+vlc_player::~vlc_player()
+{
+    // no new command from the player, then none running
+    _mp_events.clear();
+    _executor.shutdown();
+    if( _mp )
+        _mp.stopAsync();
+    // the media may outlive the player, their handlers must not
+    _playlist.clear();
+}
+
 bool vlc_player::open(VLC::Instance& inst)
 {
     if( !inst )
         return false;
 
     _libvlc_instance = inst;
+    _mp_events.clear();
 
     try {
-        _mp   = VLC::MediaPlayer(inst);
-        _ml   = VLC::MediaList();
-        _ml_p = VLC::MediaListPlayer(inst);
-
-        _ml_p.setMediaList( _ml );
-        _ml_p.setMediaPlayer( _mp );
+        _mp = VLC::MediaPlayer(inst);
     }
     catch (std::runtime_error&) {
         return false;
     }
 
+    /* the player stops at the end of each item, unless asked to it goes
+     * on with the next one from the worker: libvlc must not be called
+     * back from its own events */
+    auto& em = _mp.eventManager();
+    _mp_events.emplace_back( em.onStopping([this] {
+        if( _stop_requested.exchange( false ) )
+            return;
+        uint64_t ended = monotonic_now_us();
+        unsigned starts = _starts;
+        _executor.post( pc_advance, [this, ended, starts]() {
+            // a script already moved on from the item which ended
+            if( _starts != starts )
+                return 0;
+            int pos;
+            VLC::Media media;
+            {
+                playlist_guard guard( _lock );
+                pos = _playlist.next();
+                if( pos >= 0 )
+                {
+                    media = _playlist[pos].media;
+                    publish( _playlist.size() );
+                }
+            }
+            if( pos >= 0 )
+                start_media( media, ended );
+            return 0;
+        }, false );
+    }) );
+    // the gap runs from the end of an item to the next one playing, which
+    // is then moved to its session or resume position
+    _mp_events.emplace_back( em.onPlaying([this] {
+        uint64_t ended = _gap_start.exchange( 0 );
+        if( ended )
+            _gaps.record( monotonic_now_us() - ended );
+
+        std::string mrl;
+        if( _resume_pending )
+        {
+            _resume_pending = false;
+            mrl = _resume_mrl;
+        }
+        if( mrl.empty() && !_session_pending )
+            return;
+        _executor.post( pc_resume, [this, mrl]() {
+            restore_position( mrl );
+            return 0;
+        }, false );
+    }) );
+
     return true;
 }
 
-int vlc_player::add_item(const char * mrl, unsigned int optc, const char **optv)
+void vlc_player::apply_settings(const vlc_player_settings& settings)
+{
+    if( !is_open() )
+        return;
+
+    if( settings.set & vlc_player_settings::loop_set )
+        set_loop( settings.loop );
+    if( settings.set & vlc_player_settings::mute_set )
+        _mp.setMute( settings.mute );
+    if( settings.set & vlc_player_settings::volume_set )
+        _mp.setVolume( settings.volume );
+}
+
+void vlc_player::set_loop(bool loop)
+{
+    playlist_guard guard( _lock );
+    _loop = loop;
+    if( _playlist.mode() != playlist_type::mode_repeat )
+        _playlist.set_mode( loop ? playlist_type::mode_loop :
+                                   playlist_type::mode_default );
+}
+
+void vlc_player::set_repeat(bool repeat)
+{
+    playlist_guard guard( _lock );
+    if( repeat )
+        _playlist.set_mode( playlist_type::mode_repeat );
+    else
+        _playlist.set_mode( _loop ? playlist_type::mode_loop :
+                                    playlist_type::mode_default );
+}
+
+bool vlc_player::get_repeat()
+{
+    playlist_guard guard( _lock );
+    return _playlist.mode() == playlist_type::mode_repeat;
+}
+
+void vlc_player::set_shuffle(bool shuffle)
+{
+    playlist_guard guard( _lock );
+    _playlist.set_shuffle( shuffle );
+}
+
+bool vlc_player::get_shuffle()
+{
+    playlist_guard guard( _lock );
+    return _playlist.shuffle();
+}
+
+bool vlc_player::make_media(const char * mrl, const option_set_ptr& options, VLC::Media& media)
 {
-    VLC::Media media;
     try {
         media = VLC::Media( _libvlc_instance, mrl, VLC::Media::FromLocation );
     }
     catch ( std::runtime_error& ) {
-        return -1;
+        return false;
     }
 
-    for( unsigned int i = 0; i < optc; ++i )
+    const char * const *optv = options->argv();
+    for( size_t i = 0; i < options->size(); ++i )
         media.addOptionFlag( optv[i], libvlc_media_option_unique );
+    return true;
+}
 
-    VLC::MediaList::Lock lock( _ml );
-    if( _ml.addMedia( media ) )
-         return _ml.count() - 1;
-    return -1;
+int vlc_player::add_item(const char * mrl, unsigned int optc, const char **optv)
+{
+    return add_item( mrl, _option_sets.intern( optc, optv ) );
 }
 
-int vlc_player::current_item()
+int vlc_player::add_item(const char * mrl, const option_set_ptr& options)
+{
+    VLC::Media media;
+    if( !make_media( mrl, options, media ) )
+        return -1;
+
+    playlist_guard guard( _lock );
+    append_media( mrl, options, media );
+    publish( _playlist.size() - 1 );
+    return int( _playlist.size() ) - 1;
+}
+
+void vlc_player::append_media(const char * mrl, const option_set_ptr& options, VLC::Media& media)
+{
+    playlist_item item;
+    item.media = media;
+    item.options = options;
+    item.prefetched = false;
+    item.resume = !edl_sets_time_range( options->size(), options->argv() );
+    watch_media( _meta_index.push_back(), item );
+    _playlist.push_back( std::move( item ) );
+    _mrl_index.push_back( mrl );
+}
+
+void vlc_player::publish(size_t from)
+{
+    _snapshot.publish( _playlist.size(), from, _playlist.current(),
+                       [this](size_t pos) { return _playlist[pos].media; } );
+}
+
+void vlc_player::watch_media(uint32_t id, playlist_item& item)
+{
+    index_media( id, item.media );
+    /* the playlist may be locked while an event comes in, the index is
+     * updated from the worker instead; the handlers go with the item */
+    auto& em = item.media.eventManager();
+    item.meta_changed = em.onMetaChanged([this, id](libvlc_meta_t) {
+        reindex_media( id );
+    });
+    item.parsed_changed = em.onParsedChanged([this, id](VLC::Media::ParsedStatus) {
+        reindex_media( id );
+    });
+}
+
+void vlc_player::index_media(uint32_t id, VLC::Media& media)
+{
+    std::string fields[] = {
+        media.meta( libvlc_meta_Title ),
+        media.meta( libvlc_meta_Artist ),
+        media.meta( libvlc_meta_Album ),
+        media.meta( libvlc_meta_Genre ),
+        media.mrl(),
+    };
+    const char *texts[sizeof(fields) / sizeof(*fields)];
+    for( size_t i = 0; i < sizeof(fields) / sizeof(*fields); ++i )
+        texts[i] = fields[i].c_str();
+    _meta_index.set( id, texts, sizeof(fields) / sizeof(*fields) );
+}
+
+void vlc_player::reindex_media(uint32_t id)
+{
+    _executor.post( pc_index, [this, id]() {
+        playlist_guard guard( _lock );
+        int pos = _meta_index.position( id );
+        if( pos >= 0 )
+            index_media( id, _playlist[pos].media );
+        return 0;
+    }, false );
+}
+
+int vlc_player::add_items(unsigned int count, const char **mrls, const option_set_ptr& options)
+{
+    // build every media first, the list stays locked only while appending
+    std::vector<std::pair<const char *, VLC::Media> > medias;
+    medias.reserve( count );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        VLC::Media media;
+        if( make_media( mrls[i], options, media ) )
+            medias.emplace_back( mrls[i], media );
+    }
+
+    if( medias.empty() )
+        return -1;
+    playlist_guard guard( _lock );
+    int first = int( _playlist.size() );
+    for( auto& m : medias )
+        append_media( m.first, options, m.second );
+    publish( first );
+    return first;
+}
+
+int vlc_player::add_entries(const std::vector<playlist_entry>& entries)
+{
+    std::vector<std::pair<const char *, VLC::Media> > medias;
+    std::vector<option_set_ptr> options;
+    medias.reserve( entries.size() );
+    options.reserve( entries.size() );
+    std::vector<const char *> optv;
+    for( const auto& e : entries )
+    {
+        optv.clear();
+        for( const auto& o : e.options )
+            optv.push_back( o.c_str() );
+        option_set_ptr set = _option_sets.intern( optv.size(), optv.empty() ? nullptr : &optv[0] );
+
+        VLC::Media media;
+        if( !make_media( e.mrl.c_str(), set, media ) )
+            continue;
+        if( !e.name.empty() )
+            media.setMeta( libvlc_meta_Title, e.name );
+        medias.emplace_back( e.mrl.c_str(), media );
+        options.push_back( std::move( set ) );
+    }
+
+    playlist_guard guard( _lock );
+    size_t first = _playlist.size();
+    for( size_t i = 0; i < medias.size(); ++i )
+        append_media( medias[i].first, options[i], medias[i].second );
+    publish( first );
+    return int( medias.size() );
+}
+
+int vlc_player::add_segments(const std::vector<vlc_edl_segment>& segments)
 {
-    auto media = _mp.media();
+    std::vector<std::pair<const char *, VLC::Media> > medias;
+    std::vector<option_set_ptr> options;
+    medias.reserve( segments.size() );
+    options.reserve( segments.size() );
+    for( const auto& seg : segments )
+    {
+        std::string range[2];
+        const char *optv[2];
+        unsigned int optc = edl_segment_options( seg, range );
+        for( unsigned int i = 0; i < optc; ++i )
+            optv[i] = range[i].c_str();
+        option_set_ptr set = _option_sets.intern( optc, optc ? optv : nullptr );
 
-    if( !media )
+        VLC::Media media;
+        if( !make_media( seg.mrl.c_str(), set, media ) )
+            continue;
+        medias.emplace_back( seg.mrl.c_str(), media );
+        options.push_back( std::move( set ) );
+    }
+    if( medias.empty() )
+        return -1;
+
+    playlist_guard guard( _lock );
+    size_t first = _playlist.size();
+    for( size_t i = 0; i < medias.size(); ++i )
+        append_media( medias[i].first, options[i], medias[i].second );
+    publish( first );
+    return int( first );
+}
+
+int vlc_player::import_playlist(const char * path, const char * base)
+{
+    FILE *f = fopen( path, "rb" );
+    if( !f )
         return -1;
-    return _ml.indexOfItem( *media );
+
+    int added = 0;
+    playlist_importer importer( [this, &added](std::vector<playlist_entry>& batch) {
+        added += add_entries( batch );
+    } );
+    if( base )
+        importer.set_base( base, strlen( base ) );
+
+    std::vector<char> buffer( 64 * 1024 );
+    size_t read;
+    while( (read = fread( &buffer[0], 1, buffer.size(), f )) > 0 )
+        importer.feed( &buffer[0], read );
+    fclose( f );
+    importer.finish();
+    return added;
+}
+
+int vlc_player::current_item()
+{
+    return _snapshot.load()->current();
 }
 
 int vlc_player::items_count()
 {
-    VLC::MediaList::Lock lock( _ml );
-    return _ml.count();
+    return int( _snapshot.load()->size() );
+}
+
+int vlc_player::find_item(const char * mrl)
+{
+    playlist_guard guard( _lock );
+    return _mrl_index.find( mrl );
+}
+
+void vlc_player::search_items(const char * query, std::vector<unsigned>& items)
+{
+    playlist_guard guard( _lock );
+    _meta_index.query( query, strlen( query ), items );
 }
 
 bool vlc_player::delete_item(unsigned int idx)
 {
-    VLC::MediaList::Lock lock( _ml );
-    return _ml.removeIndex( idx );
+    playlist_guard guard( _lock );
+    if( idx >= _playlist.size() )
+        return false;
+    _playlist.erase( idx );
+    _mrl_index.erase( idx );
+    _meta_index.erase( idx );
+    publish( idx );
+    return true;
 }
 
 void vlc_player::clear_items()
 {
-    VLC::MediaList::Lock lock( _ml );
-    for( int i = _ml.count(); i > 0; --i) {
-        _ml.removeIndex( i - 1 );
+    playlist_guard guard( _lock );
+    _playlist.clear();
+    _mrl_index.clear();
+    _meta_index.clear();
+    publish( 0 );
+}
+
+int vlc_player::apply_playlist(unsigned int count, const char **mrls, const option_set_ptr& options)
+{
+    playlist_guard guard( _lock );
+
+    std::vector<int> sources;
+    _mrl_index.diff( mrls, count, sources );
+
+    // media for the new entries, entries failing to make one are dropped
+    std::vector<const char *> target;
+    std::vector<VLC::Media> medias( count );
+    target.reserve( count );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        if( sources[i] < 0 && !make_media( mrls[i], options, medias[i] ) )
+            continue;
+        sources[target.size()] = sources[i];
+        medias[target.size()] = medias[i];
+        target.push_back( mrls[i] );
+    }
+    sources.resize( target.size() );
+    medias.resize( target.size() );
+
+    // removals from the end, the kept items are then in their final order
+    std::vector<bool> keep( _playlist.size(), false );
+    for( int source : sources )
+    {
+        if( source >= 0 )
+            keep[source] = true;
+    }
+    for( size_t i = keep.size(); i > 0; --i )
+    {
+        if( !keep[i - 1] )
+            _playlist.erase( i - 1 );
+    }
+
+    // the current item, if kept, stays current wherever it lands
+    int inserted = 0;
+    for( size_t i = 0; i < target.size(); ++i )
+    {
+        if( sources[i] >= 0 )
+            continue;
+        playlist_item item;
+        item.media = medias[i];
+        item.options = options;
+        item.prefetched = false;
+        item.resume = !edl_sets_time_range( options->size(), options->argv() );
+        _playlist.insert( i, std::move( item ) );
+        ++inserted;
+    }
+
+    _mrl_index.clear();
+    for( const char *mrl : target )
+        _mrl_index.push_back( mrl );
+    publish( 0 );
+
+    std::vector<uint32_t> ids;
+    _meta_index.reorder( sources, ids );
+    for( size_t i = 0; i < target.size(); ++i )
+    {
+        if( sources[i] < 0 )
+            watch_media( ids[i], _playlist[i] );
+    }
+    return inserted;
+}
+
+bool vlc_player::save_session(std::vector<unsigned char>& blob)
+{
+    if( !is_open() )
+        return false;
+
+    vlc_session session;
+    {
+        playlist_guard guard( _lock );
+        size_t count = _playlist.size();
+        session.items.resize( count );
+        for( size_t i = 0; i < count; ++i )
+        {
+            VLC::Media *media = &_playlist[i].media;
+            vlc_session_item& item = session.items[i];
+            item.mrl = media->mrl();
+            const option_set_ptr& options = _playlist[i].options;
+            if( options && options->size() > 0 )
+                item.options.assign( options->argv(), options->argv() + options->size() );
+            for( int m = libvlc_meta_Title; m <= libvlc_meta_DiscTotal; ++m )
+            {
+                std::string value = media->meta( libvlc_meta_t( m ) );
+                if( !value.empty() )
+                    item.meta.emplace_back( m, std::move( value ) );
+            }
+        }
+        session.current = _playlist.current();
     }
+
+    session.time = _mp.time();
+    session.audio_track = currentAudioTrack();
+    session.subtitle_track = currentSubtitleTrack();
+    session.video_track = currentVideoTrack();
+    session.volume = _mp.volume();
+    session.mute = _mp.mute();
+    session.rate = _mp.rate();
+    session.loop = _loop;
+
+    write_session( session, blob );
+    return true;
 }
 
-int vlc_player::preparse_item_sync(unsigned int idx, int options, unsigned int timeout)
+bool vlc_player::restore_session(const unsigned char *data, size_t size)
 {
-    int retval = -1;
+    vlc_session session;
+    if( !is_open() || !read_session( data, size, session ) )
+        return false;
+
+    // build every media first, like add_items, with the metadata known
+    // when saved so that nothing has to be preparsed again
+    struct restored_item
+    {
+        const char     *mrl;
+        option_set_ptr  options;
+        VLC::Media      media;
+    };
+    std::vector<restored_item> items;
+    items.reserve( session.items.size() );
+    int current = -1;
+    std::vector<const char *> optv;
+    for( size_t i = 0; i < session.items.size(); ++i )
+    {
+        const vlc_session_item& saved = session.items[i];
+        optv.clear();
+        for( const auto& o : saved.options )
+            optv.push_back( o.c_str() );
+
+        restored_item item;
+        item.mrl = saved.mrl.c_str();
+        item.options = _option_sets.intern( optv.size(), optv.empty() ? nullptr : &optv[0] );
+        if( !make_media( item.mrl, item.options, item.media ) )
+            continue;
+        for( const auto& m : saved.meta )
+        {
+            if( m.first >= libvlc_meta_Title && m.first <= libvlc_meta_DiscTotal )
+                item.media.setMeta( libvlc_meta_t( m.first ), m.second );
+        }
+
+        if( int( i ) == session.current )
+            current = int( items.size() );
+        items.push_back( std::move( item ) );
+    }
+
+    {
+        playlist_guard guard( _lock );
+        _playlist.clear();
+        _mrl_index.clear();
+        _meta_index.clear();
+        for( auto& item : items )
+            append_media( item.mrl, item.options, item.media );
+        publish( 0 );
+    }
+
+    vlc_player_settings settings;
+    settings.set = vlc_player_settings::volume_set | vlc_player_settings::mute_set |
+                   vlc_player_settings::loop_set;
+    settings.volume = session.volume;
+    settings.mute = session.mute;
+    settings.loop = session.loop;
+    apply_settings( settings );
+
+    if( current >= 0 )
+    {
+        /* the tracks can only be picked once the item is playing, the
+         * position and tracks of the session wait for it there and win
+         * over the ones of the resume store */
+        VLC::Media media = items[current].media;
+        resume_entry entry;
+        entry.time = session.time;
+        entry.audio_track = session.audio_track;
+        entry.subtitle_track = session.subtitle_track;
+        entry.video_track = session.video_track;
+        _executor.post( pc_resume, [this, media, entry]() {
+            _session_media = media;
+            _session_entry = entry;
+            return 0;
+        }, false );
+        _session_pending = true;
+        async_play_item( current );
+    }
+    if( session.rate > 0.f )
+        async_set_rate( session.rate );
+    return true;
+}
+
+namespace {
+
+/* the status ParsedChanged reports, waited for with a bound: -1 until
+ * one is reported */
+class parse_result
+{
+public:
+#if defined(_WIN32)
+    parse_result()
+        : _event(CreateEvent(nullptr, true, false, nullptr)), _status(-1)
+    {
+    }
+    ~parse_result()
+    {
+        if( _event )
+            CloseHandle( _event );
+    }
+    bool valid() const
+        { return _event != nullptr; }
+
+    void set(int status)
+    {
+        _status = status;
+        SetEvent( _event );
+    }
+    void reset()
+    {
+        ResetEvent( _event );
+        _status = -1;
+    }
+    int wait(unsigned ms)
+    {
+        if( WaitForSingleObject( _event, ms ) != WAIT_OBJECT_0 )
+            return -1;
+        return _status;
+    }
+#else
+    parse_result()
+        : _status(-1)
+    {
+    }
+    bool valid() const
+        { return true; }
+
+    void set(int status)
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _status = status;
+        _cond.notify_all();
+    }
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _status = -1;
+    }
+    int wait(unsigned ms)
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+        _cond.wait_for( lock, std::chrono::milliseconds( ms ),
+                        [this] { return _status >= 0; } );
+        return _status;
+    }
+#endif
+
+private:
+#if defined(_WIN32)
+    HANDLE                  _event;
+#else
+    std::mutex              _mutex;
+    std::condition_variable _cond;
+#endif
+    std::atomic<int>        _status;
+};
+
+bool parse_over(VLC::Media::ParsedStatus status)
+{
+    switch( status )
+    {
+    case VLC::Media::ParsedStatus::Skipped:
+    case VLC::Media::ParsedStatus::Failed:
+    case VLC::Media::ParsedStatus::Timeout:
+    case VLC::Media::ParsedStatus::Done:
+        return true;
+    default:
+        return false;
+    }
+}
+
+}
 
-    VLC::MediaList::Lock lock( _ml );
-    auto media = _ml.itemAtIndex( idx );
+// how late past its own timeout a parse may report, and the bound of a
+// wait for a parse asked without a timeout
+static const unsigned parse_grace_ms = 1000;
+static const unsigned parse_wait_max_ms = 60000;
+
+int vlc_player::preparse_item_sync(unsigned int idx, int options, unsigned int timeout)
+{
+    // read from the snapshot, nothing is locked while waiting for the result
+    auto media = get_media( idx );
     if ( !media )
         return -1;
     auto em = media->eventManager();
 
-#  if defined(_WIN32)
-    HANDLE barrier = CreateEvent(nullptr, true,  false, nullptr);
-    if ( barrier == nullptr )
+    parse_result result;
+    if ( !result.valid() )
         return -1;
 
+    // a prefetch of the same media would race this parse for its result
+    {
+        playlist_guard guard( _lock );
+        _parsing.push_back( media->get() );
+    }
+
     auto event = em.onParsedChanged(
-        [&barrier, &retval](VLC::Media::ParsedStatus status )
+        [&result]( VLC::Media::ParsedStatus status )
     {
-        retval = int( status );
-        SetEvent( barrier );
+        result.set( int( status ) );
     });
 
-    media->parseWithOptions( VLC::Media::ParseFlags( options ), timeout );
+    const unsigned budget = timeout ? timeout + parse_grace_ms : parse_wait_max_ms;
+    const uint64_t start = monotonic_now_us();
+    auto remaining = [budget, start]() {
+        uint64_t spent = (monotonic_now_us() - start) / 1000;
+        return spent < budget ? unsigned( budget - spent ) : 0u;
+    };
+    VLC::Media::ParseFlags flags = VLC::Media::ParseFlags( options );
+
+    int retval = -1;
+    bool requested = media->parseWithOptions( flags, timeout );
+    /* refused while a prefetch started before is parsing it: asked again
+     * once that one is over, so that the flags are the caller's */
+    if ( !requested && result.wait( remaining() ) >= 0 )
+    {
+        result.reset();
+        requested = media->parseWithOptions( flags, timeout );
+    }
+    if ( requested )
+    {
+        /* some libvlc versions do not parse a media twice and then report
+         * nothing, a status that is not pending already is the result */
+        VLC::Media::ParsedStatus status = media->parsedStatus();
+        if ( parse_over( status ) )
+            retval = int( status );
+        else
+            retval = result.wait( remaining() );
+    }
+    event->unregister();
+
+    playlist_guard guard( _lock );
+    _parsing.erase( std::find( _parsing.begin(), _parsing.end(), media->get() ) );
+    return retval;
+}
 
-    DWORD waitResult = WaitForSingleObject( barrier, INFINITE );
-    switch ( waitResult ) {
-    case WAIT_OBJECT_0:
+std::shared_ptr<VLC::Media> vlc_player::get_media(unsigned int idx)
+{
+    auto snapshot = _snapshot.load();
+    if( idx >= snapshot->size() )
+        return nullptr;
+    return std::make_shared<VLC::Media>( (*snapshot)[idx] );
+}
+
+void vlc_player::start_media(VLC::Media& media, uint64_t gap_start)
+{
+    // the Stopping event of the item being replaced must not advance
+    switch( _mp.state() )
+    {
+    case libvlc_Opening:
+    case libvlc_Buffering:
+    case libvlc_Playing:
+    case libvlc_Paused:
+        _stop_requested = true;
         break;
     default:
-        retval = -1;
         break;
     }
-    CloseHandle( barrier );
-    event->unregister();
-#  else
-    std::promise<int> promise;
-    std::future<int> future = promise.get_future();
+    _gap_start = gap_start;
+    ++_starts;
+    _mp.setMedia( media );
+    _mp.play();
+    prefetch_next();
+}
 
-    auto event = em.onParsedChanged(
-        [&promise]( VLC::Media::ParsedStatus status )
+// bounds the preparse of an item that never answers
+static const int prefetch_timeout_ms = 5000;
+
+void vlc_player::prefetch_next()
+{
+    /* libvlc cannot queue the next media on the player, preparsing it
+     * at least opens and probes it while this one plays */
+    VLC::Media media;
+    {
+        playlist_guard guard( _lock );
+        int pos = _playlist.peek_next();
+        if( pos < 0 || _playlist[pos].prefetched )
+            return;
+        _playlist[pos].prefetched = true;
+        media = _playlist[pos].media;
+        // preparse_item_sync is already parsing it
+        if( std::find( _parsing.begin(), _parsing.end(), media.get() ) != _parsing.end() )
+            return;
+    }
+    media.parseWithOptions( VLC::Media::ParseFlags::Local, prefetch_timeout_ms );
+}
+
+void vlc_player::get_gap_stats(vlc_player_gap_stats& stats) const
+{
+    _gaps.get( stats );
+}
+
+void vlc_player::reset_gap_stats()
+{
+    _gaps.reset();
+}
+
+bool vlc_player::play_item(unsigned int idx)
+{
+    VLC::Media media;
+    {
+        playlist_guard guard( _lock );
+        if( idx >= _playlist.size() )
+            return false;
+        _playlist.set_current( idx );
+        media = _playlist[idx].media;
+        publish( _playlist.size() );
+    }
+    start_media( media );
+    return true;
+}
+
+void vlc_player::play()
+{
+    VLC::Media media;
+    {
+        playlist_guard guard( _lock );
+        if( _playlist.current() >= 0 )
+            media = _playlist[_playlist.current()].media;
+        else
+        {
+            int pos = _playlist.next();
+            if( pos < 0 )
+                return;
+            media = _playlist[pos].media;
+            publish( _playlist.size() );
+        }
+    }
+    auto playing = _mp.media();
+    if( playing && playing->get() == media.get() )
+        _mp.play();
+    else
+        start_media( media );
+}
+
+bool vlc_player::is_playing()
+{
+    return _mp.isPlaying();
+}
+
+void vlc_player::toggle_pause()
+{
+    _mp.pause();
+}
+
+void vlc_player::stop_async()
+{
+    switch( _mp.state() )
+    {
+    case libvlc_NothingSpecial:
+    case libvlc_Stopped:
+    case libvlc_Stopping:
+    case libvlc_Error:
+        return;
+    default:
+        break;
+    }
+    _stop_requested = true;
+    _mp.stopAsync();
+}
+
+bool vlc_player::next()
+{
+    VLC::Media media;
     {
-        promise.set_value( int( status ) );
+        playlist_guard guard( _lock );
+        int pos = _playlist.next();
+        if( pos < 0 )
+            return false;
+        media = _playlist[pos].media;
+        publish( _playlist.size() );
+    }
+    start_media( media );
+    return true;
+}
+
+bool vlc_player::prev()
+{
+    VLC::Media media;
+    {
+        playlist_guard guard( _lock );
+        int pos = _playlist.prev();
+        if( pos < 0 )
+            return false;
+        media = _playlist[pos].media;
+        publish( _playlist.size() );
+    }
+    start_media( media );
+    return true;
+}
+
+void vlc_player::on_command_done(std::function<void(vlc_player_command_e, int)> cb)
+{
+    _executor.set_done_callback([cb](int kind, int status) {
+        if( kind < pc_resume )
+            cb( vlc_player_command_e( kind ), status );
     });
+}
 
-    media->parseWithOptions( VLC::Media::ParseFlags( options ), timeout );
+void vlc_player::shutdown_commands()
+{
+    _executor.shutdown();
+}
 
-    future.wait();
-    retval = future.get();
-    event->unregister();
-#  endif
+// positions are written every few seconds of playback, and none is kept
+// this close to either end of an item
+static const int64_t resume_interval_ms = 5000;
+static const int64_t resume_margin_ms = 10000;
 
-    return retval;
+bool vlc_player::open_resume_store(const char * path)
+{
+    if( !is_open() || !_resume.open( path ) )
+        return false;
+
+    /* libvlc is not called back from its own events, anything that needs
+     * the player or the store runs as a command */
+    auto& em = _mp.eventManager();
+    _mp_events.emplace_back( em.onMediaChanged([this](VLC::MediaPtr media) {
+        _resume_mrl = media ? media->mrl() : std::string();
+        _resume_time = _resume_saved = -1;
+        _resume_pending = !_resume_mrl.empty();
+        // ahead of the saves and restores of this media
+        _executor.post( pc_resume, [this, media]() {
+            playlist_guard guard( _lock );
+            _resume_allowed = !media || resumable( media->get() );
+            return 0;
+        }, false );
+    }) );
+    _mp_events.emplace_back( em.onTimeChanged([this](int64_t time) {
+        _resume_time = time;
+        int64_t since = time - _resume_saved;
+        if( _resume_mrl.empty() || (_resume_saved >= 0
+         && since < resume_interval_ms && since > -resume_interval_ms) )
+            return;
+        _resume_saved = time;
+        std::string mrl = _resume_mrl;
+        _executor.post( pc_resume, [this, mrl, time]() {
+            resume_save( mrl, time, false );
+            return 0;
+        }, true );
+    }) );
+    _mp_events.emplace_back( em.onStopped([this] {
+        if( _resume_mrl.empty() || _resume_time < 0 )
+            return;
+        std::string mrl = _resume_mrl;
+        int64_t time = _resume_time;
+        _executor.post( pc_resume, [this, mrl, time]() {
+            resume_save( mrl, time, true );
+            return 0;
+        }, false );
+    }) );
+    return true;
 }
 
-std::shared_ptr<VLC::Media> vlc_player::get_media(unsigned int idx)
+bool vlc_player::resumable(libvlc_media_t *media)
 {
-    return _ml.itemAtIndex(idx);
+    // the item playing it is the current one, unless the list moved on
+    int pos = _playlist.current();
+    if( pos >= 0 && _playlist[pos].media.get() == media )
+        return _playlist[pos].resume;
+    for( size_t i = 0; i < _playlist.size(); ++i )
+    {
+        if( _playlist[i].media.get() == media )
+            return _playlist[i].resume;
+    }
+    return true;
 }
 
-void vlc_player::play()
+void vlc_player::resume_save(const std::string& mrl, int64_t time, bool stopped)
 {
-    if( 0 == items_count() )
+    if( !_resume_allowed )
+        return;
+    if( time < resume_margin_ms )
+    {
+        _resume.erase( mrl.data(), mrl.size() );
         return;
-    else if( -1 == current_item() ) {
-        _ml_p.playItemAtIndex( 0 );
     }
-    else
-        _ml_p.play();
+    if( stopped )
+    {
+        // an item played to its end starts over next time
+        libvlc_time_t length = _mp.length();
+        if( length > 0 && time >= length - resume_margin_ms )
+        {
+            _resume.erase( mrl.data(), mrl.size() );
+            return;
+        }
+    }
+
+    resume_entry entry;
+    entry.time = time;
+    entry.audio_track = currentAudioTrack();
+    entry.subtitle_track = currentSubtitleTrack();
+    entry.video_track = currentVideoTrack();
+    _resume.store( mrl.data(), mrl.size(), entry );
+}
+
+void vlc_player::resume_restore(const std::string& mrl)
+{
+    if( !_resume_allowed )
+        return;
+    resume_entry entry;
+    if( _resume.lookup( mrl.data(), mrl.size(), entry ) )
+        apply_position( entry );
+}
+
+void vlc_player::restore_position(const std::string& mrl)
+{
+    if( _session_pending && _session_media.get() )
+    {
+        VLC::MediaPtr media = _mp.media();
+        bool restored = media && media->get() == _session_media.get();
+        // played, or replaced by another item before it could play
+        _session_pending = false;
+        _session_media = VLC::Media();
+        if( restored )
+        {
+            apply_position( _session_entry );
+            return;
+        }
+    }
+    if( !mrl.empty() )
+        resume_restore( mrl );
+}
+
+void vlc_player::apply_position(const resume_entry& entry)
+{
+    if( entry.time > 0 )
+        _mp.setTime( entry.time, true );
+
+    const VLC::MediaTrack::Type types[] = { VLC::MediaTrack::Type::Audio,
+        VLC::MediaTrack::Type::Subtitle, VLC::MediaTrack::Type::Video };
+    const int32_t ids[] = { entry.audio_track, entry.subtitle_track, entry.video_track };
+    for( int k = 0; k < 3; ++k )
+    {
+        if( ids[k] < 0 )
+            continue;
+        for( const auto& t : _mp.tracks( types[k] ) )
+        {
+            if( t.id() == ids[k] )
+            {
+                if( !t.selected() )
+                    _mp.selectTrack( t );
+                break;
+            }
+        }
+    }
+}
+
+void vlc_player::async_stop()
+{
+    _executor.post( pc_stop, [this]() {
+        stop_async();
+        return 0;
+    }, false );
+}
+
+void vlc_player::async_play()
+{
+    _executor.post( pc_play, [this]() {
+        play();
+        return 0;
+    }, false );
+}
+
+void vlc_player::async_play_item(unsigned int idx)
+{
+    _executor.post( pc_play_item, [this, idx]() {
+        return play_item( idx ) ? 0 : -1;
+    }, false );
+}
+
+void vlc_player::async_next()
+{
+    _executor.post( pc_next, [this]() {
+        return next() ? 0 : -1;
+    }, false );
+}
+
+void vlc_player::async_prev()
+{
+    _executor.post( pc_prev, [this]() {
+        return prev() ? 0 : -1;
+    }, false );
+}
+
+void vlc_player::async_set_time(libvlc_time_t time)
+{
+    VLC::MediaPlayer mp = _mp;
+    _executor.post( pc_seek, [mp, time]() mutable {
+        mp.setTime( time, true );
+        return 0;
+    }, true );
+}
+
+void vlc_player::async_set_position(float position)
+{
+    VLC::MediaPlayer mp = _mp;
+    _executor.post( pc_seek, [mp, position]() mutable {
+        mp.setPosition( position, true );
+        return 0;
+    }, true );
+}
+
+void vlc_player::async_set_volume(int volume)
+{
+    VLC::MediaPlayer mp = _mp;
+    _executor.post( pc_volume, [mp, volume]() mutable {
+        return mp.setVolume( volume ) ? 0 : -1;
+    }, true );
+}
+
+void vlc_player::async_set_rate(float rate)
+{
+    VLC::MediaPlayer mp = _mp;
+    _executor.post( pc_rate, [mp, rate]() mutable {
+        mp.setRate( rate );
+        return 0;
+    }, true );
 }
 
 int vlc_player::currentAudioTrack()
@@ -23,6 +23,24 @@
 
 #include <vlcpp/vlc.hpp>
 
+#include <atomic>
+#if !defined(_WIN32)
+#  include <mutex>
+#endif
+#include <utility>
+#include <vector>
+
+#include "command_executor.h"
+#include "edl.h"
+#include "meta_index.h"
+#include "mrl_index.h"
+#include "option_set.h"
+#include "playlist_engine.h"
+#include "playlist_snapshot.h"
+#include "playlist_importer.h"
+#include "resume_store.h"
+#include "session_blob.h"
+
 enum vlc_player_action_e
 {
     pa_play,
@@ -32,22 +50,147 @@ enum vlc_player_action_e
     pa_prev
 };
 
+// commands run by the player's worker thread, seeks, volume and
+// rate changes collapse with a pending command of the same kind
+enum vlc_player_command_e
+{
+    pc_stop,
+    pc_play_item,
+    pc_seek,
+    pc_volume,
+    pc_rate,
+    pc_play,
+    pc_next,
+    pc_prev,
+    // internal commands, never reported: resume store reads and writes,
+    // metadata index updates and moving on at the end of an item
+    pc_resume,
+    pc_index,
+    pc_advance
+};
+
+// player state applied in one batch by vlc_player::apply_settings,
+// only the fields flagged in set are applied
+struct vlc_player_settings
+{
+    enum
+    {
+        volume_set = 1,
+        mute_set   = 2,
+        loop_set   = 4
+    };
+
+    unsigned set;
+    int      volume;
+    bool     mute;
+    bool     loop;
+};
+
 class vlc_player
 {
 public:
+    vlc_player()
+        : _playlist(shuffle_seed()), _loop(false), _stop_requested(false), _gap_start(0), _starts(0),
+          _resume_time(-1),
+          _resume_saved(-1), _resume_pending(false), _resume_allowed(true),
+          _session_pending(false)
+    {
+    }
+    // stops the player and drops every libvlc event handler first, none
+    // of them may run once members start going
+    ~vlc_player();
+    vlc_player(const vlc_player&) = delete;
+    vlc_player& operator=(const vlc_player&) = delete;
+
     bool open(VLC::Instance& inst);
+    bool is_open() const
+        { return bool( _mp ); }
+
+    void apply_settings(const vlc_player_settings& settings);
+
+    void set_loop(bool loop);
+    bool get_loop() const
+        { return _loop; }
+    // repeat plays the current item over, and takes over loop until unset
+    void set_repeat(bool repeat);
+    bool get_repeat();
+    // items play in a random order, each once per pass
+    void set_shuffle(bool shuffle);
+    bool get_shuffle();
+
+    // snapshot of the playlist, with options and known metadata, and of
+    // the playback state, see session_blob.h; false if not open
+    bool save_session(std::vector<unsigned char>& blob);
+    // replaces the playlist with a saved one in a single insertion and
+    // resumes playback where it was; false, changing nothing, on a bad blob
+    bool restore_session(const unsigned char *data, size_t size);
+
+    // from then on the position of each item is saved while it plays and
+    // when it stops, and playback resumes there the next time it is
+    // played; items whose options set start-time or stop-time are left
+    // alone. Call once, after open()
+    bool open_resume_store(const char *path);
 
     int add_item(const char * mrl, unsigned int optc, const char **optv);
     int add_item(const char * mrl)
         { return add_item( mrl, 0, nullptr ); }
+    int add_item(const char * mrl, const option_set_ptr& options);
+
+    // shares one parsed option list between all the items using it
+    option_set_ptr intern_options(unsigned int optc, const char **optv)
+        { return _option_sets.intern( optc, optv ); }
 
+    // adds count items sharing the same options under a single list lock,
+    // returns the index of the first one or -1 if none could be added
+    int add_items(unsigned int count, const char **mrls, const option_set_ptr& options);
+
+    // adds parsed playlist entries, named after their name if they have
+    // one, under a single list lock; returns the number of items added
+    int add_entries(const std::vector<playlist_entry>& entries);
+
+    /* adds one item per segment, played from its start to its stop time
+     * through the start-time and stop-time options, so that the segments
+     * play back to back; returns the index of the first one or -1 if
+     * none could be added */
+    int add_segments(const std::vector<vlc_edl_segment>& segments);
+
+    // reads an M3U or XSPF file in chunks, each batch of entries is added
+    // while the rest of the file is parsed; base resolves relative
+    // locations and may be null. Returns the number of items added, -1 if
+    // the file cannot be read. The path is opened as is, it must never
+    // come from a page script
+    int import_playlist(const char *path, const char *base);
+
+    // read from the latest snapshot, never waiting for a playlist change
     int  current_item();
     int  items_count();
+    // index of the first item naming the same resource as mrl, compared
+    // after normalization, -1 if there is none
+    int  find_item(const char * mrl);
+    // indexes of the items whose title, artist, album, genre or MRL has,
+    // for each word of query, a word starting with it; ascending
+    void search_items(const char * query, std::vector<unsigned>& items);
     bool delete_item(unsigned int idx);
     void clear_items();
 
-    void play();
+    /* turns the playlist into mrls with as few removals and insertions
+     * as possible, under a single list lock: the items already there keep
+     * their media, parse state and options, new ones get options. The
+     * playing item goes on playing if it is kept. Returns the number of
+     * items inserted, MRLs that do not make a media are left out */
+    int apply_playlist(unsigned int count, const char **mrls, const option_set_ptr& options);
+
+    bool is_playing();
+    void toggle_pause();
+    void stop_async();
 
+    // gaps between items played one after the other, measured from the
+    // end of one item to the next one playing
+    void get_gap_stats(vlc_player_gap_stats& stats) const;
+    void reset_gap_stats();
+
+    // returns the parsed status, or -1 when the parse could not be asked
+    // or did not report within timeout milliseconds, 0 being a minute
     int preparse_item_sync(unsigned int idx, int options, unsigned int timeout);
 
     VLC::MediaPlayer& get_mp()
@@ -55,25 +198,184 @@ public:
         return _mp;
     }
 
-    VLC::MediaListPlayer& mlp()
-    {
-        return _ml_p;
-    }
-
+    // from the latest snapshot too
     std::shared_ptr<VLC::Media> get_media( unsigned int idx );
 
     int currentAudioTrack();
     int currentSubtitleTrack();
     int currentVideoTrack();
 
+    // called on the worker thread once a command ran, status is 0 on
+    // success; must be set before the first command is posted
+    void on_command_done(std::function<void(vlc_player_command_e, int)> cb);
+    // drops the pending commands and joins the worker, the done callback
+    // is not called anymore once this returns
+    void shutdown_commands();
+
+    void async_stop();
+    // resumes the current item, or starts the play order from its start
+    void async_play();
+    void async_play_item(unsigned int idx);
+    // follow the play order, fail at either end of it unless looping
+    void async_next();
+    void async_prev();
+    void async_set_time(libvlc_time_t time);
+    void async_set_position(float position);
+    void async_set_volume(int volume);
+    void async_set_rate(float rate);
+
 private:
     // Returns a 0-based track index, instead of the internal libvlc one
     int getCurrentTrack( const std::vector<VLC::MediaTrack>& tracks );
 
+    bool make_media( const char * mrl, const option_set_ptr& options, VLC::Media& media );
+    // the playlist must be locked
+    void append_media( const char * mrl, const option_set_ptr& options, VLC::Media& media );
+    /* publishes the playlist as it is now, the items before from being
+     * unchanged since the last time; the playlist must be locked */
+    void publish( size_t from );
+    /* plays media, gap_start is when the previous item ended if it ended
+     * on its own; the playlist must not be locked */
+    void start_media( VLC::Media& media, uint64_t gap_start = 0 );
+    // playlist moves, run on the worker so that they and the advance at
+    // the end of an item are serialized
+    void play();
+    bool play_item( unsigned int idx );
+    bool next();
+    bool prev();
+    // preparses the item to play next, once per item
+    void prefetch_next();
+
+    // the playlist must be locked
+    void index_media( uint32_t id, VLC::Media& media );
+    struct playlist_item;
+    // indexes a new item and follows its metadata changes
+    void watch_media( uint32_t id, playlist_item& item );
+    // refreshes an item's metadata in the index once the media changed
+    void reindex_media( uint32_t id );
+
+    // whether the item playing media has its position saved, from its
+    // playlist item, true if it has none; the playlist must be locked
+    bool resumable( libvlc_media_t *media );
+    // run on the worker thread, the only one using _resume
+    void resume_save( const std::string& mrl, int64_t time, bool stopped );
+    void resume_restore( const std::string& mrl );
+    // run on the worker once an item plays, the position restore_session
+    // left for it wins over the one of the resume store
+    void restore_position( const std::string& mrl );
+    void apply_position( const resume_entry& entry );
+
+
+    // a libvlc event handler, unregistered when the handle goes
+    class event_handle
+    {
+    public:
+        event_handle(VLC::EventManager::RegisteredEvent event = nullptr)
+            : _event(event)
+            {}
+        event_handle(event_handle&& other)
+            : _event(other._event)
+            { other._event = nullptr; }
+        event_handle& operator=(event_handle&& other)
+            { std::swap( _event, other._event ); return *this; }
+        ~event_handle()
+            { if( _event ) _event->unregister(); }
+        event_handle(const event_handle&) = delete;
+        event_handle& operator=(const event_handle&) = delete;
+
+    private:
+        VLC::EventManager::RegisteredEvent _event;
+    };
+
+    struct playlist_item
+    {
+        VLC::Media      media;
+        option_set_ptr  options;
+        bool            prefetched;
+        // false when the options play a time range, resuming would
+        // override it
+        bool            resume;
+        // the handlers of watch_media, they post to the worker
+        event_handle    meta_changed;
+        event_handle    parsed_changed;
+    };
+    typedef playlist_engine<playlist_item> playlist_type;
+    // differs for each player, so is the shuffle order
+    static unsigned shuffle_seed();
+
+    class playlist_lock
+    {
+    public:
+        playlist_lock();
+        ~playlist_lock();
+        playlist_lock(const playlist_lock&) = delete;
+        playlist_lock& operator=(const playlist_lock&) = delete;
+
+        void lock();
+        void unlock();
+
+    private:
+#if defined(_WIN32)
+        CRITICAL_SECTION _cs;
+#else
+        std::mutex       _mutex;
+#endif
+    };
+
+    class playlist_guard
+    {
+    public:
+        explicit playlist_guard(playlist_lock& lock)
+            : _lock(lock)
+            { _lock.lock(); }
+        ~playlist_guard()
+            { _lock.unlock(); }
+
+    private:
+        playlist_lock& _lock;
+    };
 
 private:
     VLC::Instance           _libvlc_instance;
     VLC::MediaPlayer        _mp;
-    VLC::MediaList          _ml;
-    VLC::MediaListPlayer    _ml_p;
+    // the handlers of open and open_resume_store
+    std::vector<event_handle> _mp_events;
+    option_set_table        _option_sets;
+    // not recursive, libvlc event callbacks never take it
+    playlist_lock           _lock;
+    // guarded by _lock, the indexes follow the playlist positions
+    playlist_type           _playlist;
+    mrl_index               _mrl_index;
+    meta_index              _meta_index;
+    // media preparse_item_sync waits for, prefetch_next leaves them alone
+    std::vector<libvlc_media_t*> _parsing;
+    // what readers see of _playlist, republished by each change
+    snapshot_publisher<VLC::Media> _snapshot;
+    bool                    _loop;
+    // set when the player is stopped or switched to another item, so
+    // that the Stopping event which follows does not advance the playlist
+    std::atomic<bool>       _stop_requested;
+    // end of the item an automatic advance came from, 0 otherwise
+    std::atomic<uint64_t>   _gap_start;
+    // bumped by each start_media, an advance queued at the end of an item
+    // is dropped when another one was started in between
+    std::atomic<unsigned>   _starts;
+    edl_gap_stats           _gaps;
+
+    resume_store            _resume;
+    // item being played, only used by the event callbacks
+    std::string             _resume_mrl;
+    int64_t                 _resume_time;
+    int64_t                 _resume_saved;
+    bool                    _resume_pending;
+    // whether the item being played has resume, only used by the worker
+    bool                    _resume_allowed;
+    // set by restore_session until its item plays
+    std::atomic<bool>       _session_pending;
+    // position and tracks restore_session left, only used by the worker
+    VLC::Media              _session_media;
+    resume_entry            _session_entry;
+
+    // declared last so the worker is joined before the handles go away
+    command_executor        _executor;
 };
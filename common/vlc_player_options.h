@@ -56,7 +56,8 @@ enum vlc_player_option_e
     po_enable_fullscreen,
     po_bg_text,
     po_bg_color,
-    po_enable_branding
+    po_enable_branding,
+    po_resume_playback
 };
 
 class vlc_player_options
@@ -64,7 +65,7 @@ class vlc_player_options
 public:
     vlc_player_options()
         :_autoplay(true), _show_toolbar(true), _enable_fullscreen(true), _enable_branding(true),
-        _bg_color(/*black*/"#000000")
+        _resume_playback(false), _bg_color(/*black*/"#000000")
    {}
 
     void set_autoplay(bool ap){
@@ -105,11 +106,20 @@ public:
     bool get_enable_branding() const
     {return _enable_branding;}
 
+    // positions are saved and playback resumes there, in a store shared
+    // by every control of the user
+    void set_resume_playback(bool rp){
+        _resume_playback = rp;
+    }
+    bool get_resume_playback() const
+    {return _resume_playback;}
+
 private:
     bool         _autoplay;
     bool         _show_toolbar;
     bool         _enable_fullscreen;
     bool         _enable_branding;
+    bool         _resume_playback;
     std::string  _bg_text;
     //background color format is "#rrggbb"
     std::string  _bg_color;
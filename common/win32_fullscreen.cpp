@@ -279,7 +279,7 @@ LRESULT VLCControlsWnd::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
                         case ID_FS_PLAY_PAUSE:{
                             if( VP() ){
                                 if( IsPlaying() )
-                                    VP()->mlp().pause();
+                                    VP()->toggle_pause();
                                 else
                                     VP()->play();
                             }
@@ -391,7 +391,7 @@ LRESULT VLCControlsWnd::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
             if( hVolumeSlider == (HWND)lParam ){
                 if( VP() ){
                     LRESULT SliderPos = SendMessage(hVolumeSlider, (UINT) TBM_GETPOS, 0, 0);
-                    VP()->get_mp().setVolume( SliderPos );
+                    VP()->async_set_volume( SliderPos );
                 }
             }
             break;
@@ -458,7 +458,7 @@ void VLCControlsWnd::NeedHideControls()
 void VLCControlsWnd::SetVideoPos(float Pos) //0-start, 1-end
 {
     if( VP() ){
-        VP()->get_mp().setPosition( Pos, true );
+        VP()->async_set_position( Pos );
 
         if( VP()->get_mp().length() > 0 )
             PostMessage(hVideoPosScroll, (UINT)PBM_SETPOS, (WPARAM) (Pos * 1000), 0);
@@ -120,7 +120,7 @@ private:
     bool IsPlaying()
     {
         if( VP() )
-            return VP()->mlp().isPlaying();
+            return VP()->is_playing();
         return false;
     }
 
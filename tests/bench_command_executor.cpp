@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * bench_command_executor.cpp: UI thread cost of player commands
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+#include "command_executor.h"
+#include "event_stats.h"
+#include "test.h"
+
+/*
+ * bench_command_executor [commands] [libvlc call us]
+ *
+ * Plays a slider drag: the UI thread issues seeks and volume changes back
+ * to back, each one standing for a libvlc call of the given duration.
+ * Reports how long the UI thread is held per call when the calls are made
+ * directly and when they go through the command worker, and how many of
+ * the deferred commands actually reached the player.
+ */
+
+enum { k_seek, k_volume };
+
+static void busy_wait_us(unsigned us)
+{
+    uint64_t until = monotonic_now_us() + us;
+    while( monotonic_now_us() < until )
+        std::this_thread::yield();
+}
+
+static void print(const char *what, const latency_histogram& h, double ms)
+{
+    printf("%-6s UI thread %.1f ms total, per call mean %llu us, p50 < %llu us, "
+           "p99 < %llu us, max %llu us\n", what, ms,
+           (unsigned long long)h.mean_us(),
+           (unsigned long long)h.percentile_us(0.5),
+           (unsigned long long)h.percentile_us(0.99),
+           (unsigned long long)h.max_us);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned count = argc > 1 ? (unsigned)atoi(argv[1]) : 2000;
+    unsigned call_us = argc > 2 ? (unsigned)atoi(argv[2]) : 500;
+
+    std::atomic<unsigned> ran(0);
+    auto libvlc_call = [&ran, call_us]() {
+        busy_wait_us(call_us);
+        ++ran;
+        return 0;
+    };
+
+    latency_histogram sync_calls;
+    uint64_t start = monotonic_now_us();
+    for( unsigned i = 0; i < count; ++i )
+    {
+        uint64_t t = monotonic_now_us();
+        libvlc_call();
+        sync_calls.add(monotonic_now_us() - t);
+    }
+    double sync_ms = elapsed_ms(start);
+    print("sync", sync_calls, sync_ms);
+
+    ran = 0;
+    std::atomic<unsigned> done(0);
+    latency_histogram async_calls;
+    double async_ms;
+    unsigned long collapsed;
+    {
+        command_executor e;
+        e.set_done_callback([&done](int, int) { ++done; });
+        start = monotonic_now_us();
+        for( unsigned i = 0; i < count; ++i )
+        {
+            uint64_t t = monotonic_now_us();
+            e.post(i % 4 ? k_seek : k_volume, libvlc_call, true);
+            async_calls.add(monotonic_now_us() - t);
+        }
+        async_ms = elapsed_ms(start);
+        collapsed = e.collapsed_count();
+
+        // let the worker catch up before reporting what reached the player
+        while( done + collapsed < count && elapsed_ms(start) < 60000 )
+            std::this_thread::yield();
+    }
+    print("async", async_calls, async_ms);
+    printf("commands posted %u, run %u, collapsed %lu, drained after %.1f ms\n",
+           count, ran.load(), collapsed, elapsed_ms(start));
+    return 0;
+}
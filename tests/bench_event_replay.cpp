@@ -0,0 +1,223 @@
+/*****************************************************************************
+ * bench_event_replay.cpp: replays a flight recording through the dispatch path
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#  include <atomic>
+#  include <deque>
+#  include <mutex>
+#  include <thread>
+#endif
+
+#include "event_dispatcher.h"
+#include "event_recorder.h"
+#include "event_stats.h"
+#include "mouse_move_coalescer.h"
+#include "test.h"
+
+/*
+ * bench_event_replay [recording] [--realtime]
+ *
+ * Feeds a recording made with VLC_PLUGIN_RECORD, or a synthetic one, to
+ * the same pipeline as VLCConnectionPointContainer: events are queued from
+ * a libvlc-like thread, mouse moves merged while one is pending, and the
+ * queue drained on the dispatcher thread after a single wakeup per burst.
+ * Reports the throughput and the delivery latencies.
+ */
+
+#if defined(_WIN32)
+
+int main()
+{
+    fprintf(stderr, "the replay benchmark drives the dispatcher loop, it only runs on POSIX hosts\n");
+    return 0;
+}
+
+#else
+
+static const int32_t dispid_mousemove = -606;
+
+// mouse move bursts between time and position changes, like a user
+// hovering over a playing video
+static void write_synthetic(const char *path, unsigned count)
+{
+    event_recorder rec;
+    if( !rec.open(path, count) )
+        return;
+    for( unsigned i = 0; i < count; ++i )
+    {
+        unsigned phase = i % 32;
+        if( phase < 24 )
+            rec.record(erk_event, dispid_mousemove, (int64_t)(phase & 1));
+        else if( phase < 28 )
+            rec.record(erk_event, 205, (int64_t)i);
+        else
+            rec.record(erk_event, 206, i / (double)count);
+    }
+}
+
+struct pipeline
+{
+    std::shared_ptr<event_dispatcher> dispatcher;
+    std::mutex              lock;
+    std::deque<std::pair<int32_t, uint64_t> > queue;
+    mouse_move_coalescer    moves;
+    event_stats             stats;
+    bool                    notify_pending;
+    uint64_t                notify_posted;
+    unsigned long           delivered;
+    unsigned long           wakeups;
+
+    pipeline()
+        : dispatcher(event_dispatcher::current()), notify_pending(false),
+          notify_posted(0), delivered(0), wakeups(0)
+    {
+    }
+
+    void post(const event_record& rec)
+    {
+        bool notify = false;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if( rec.id == dispid_mousemove )
+            {
+                mouse_move_event ev = { (short)rec.arg.i, 0, 0, 0 };
+                if( !moves.push(ev) )
+                    return;
+            }
+            queue.push_back(std::make_pair(rec.id, monotonic_now_us()));
+            stats.queued(queue.size());
+            if( !notify_pending )
+            {
+                notify = notify_pending = true;
+                notify_posted = monotonic_now_us();
+            }
+        }
+        if( notify )
+            dispatcher->post(this, [this]() { drain(); });
+    }
+
+    void drain()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stats.woken(notify_posted, monotonic_now_us());
+            notify_pending = false;
+            ++wakeups;
+        }
+        for( ;; )
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if( queue.empty() )
+                break;
+            std::pair<int32_t, uint64_t> ev = queue.front();
+            queue.pop_front();
+            if( ev.first == dispid_mousemove )
+            {
+                mouse_move_event move;
+                moves.take(move);
+            }
+            stats.delivered(ev.first, ev.second, monotonic_now_us());
+            ++delivered;
+        }
+    }
+};
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    bool realtime = false;
+    for( int i = 1; i < argc; ++i )
+    {
+        if( !strcmp(argv[i], "--realtime") )
+            realtime = true;
+        else
+            path = argv[i];
+    }
+    if( !path )
+    {
+        path = "bench_event_replay.dat";
+        write_synthetic(path, 1 << 20);
+    }
+
+    pipeline p;
+    std::atomic<bool> done(false);
+    long replayed = 0;
+    uint64_t start = monotonic_now_us();
+    std::thread producer([&]() {
+        replayed = event_recorder::replay(path,
+            realtime ? event_recorder::replay_realtime : event_recorder::replay_fast,
+            [&p](const event_record& rec) {
+                if( rec.kind == erk_event )
+                    p.post(rec);
+            });
+        done = true;
+        p.dispatcher->post(&p, []() {});
+    });
+
+    while( !done )
+        p.dispatcher->wait_and_drain(100);
+    producer.join();
+    p.dispatcher->drain();
+    double ms = elapsed_ms(start);
+
+    if( replayed < 0 )
+    {
+        fprintf(stderr, "%s is not a flight recording\n", path);
+        return 1;
+    }
+
+    latency_histogram all;
+    for( const auto& l : p.stats.latencies() )
+    {
+        const latency_histogram& h = l.second;
+        all.count += h.count;
+        all.total_us += h.total_us;
+        if( h.max_us > all.max_us )
+            all.max_us = h.max_us;
+        for( unsigned b = 0; b < latency_histogram::buckets; ++b )
+            all.bucket[b] += h.bucket[b];
+    }
+
+    printf("records replayed   %ld in %.1f ms (%.0f records/s)\n",
+           replayed, ms, ms > 0 ? replayed / ms * 1000 : 0.);
+    printf("events delivered   %lu, mouse moves merged %lu\n",
+           p.delivered, p.moves.merged_count());
+    printf("wakeups            %lu, queue high water %zu\n",
+           p.wakeups, p.stats.depth_high_water());
+    printf("delivery latency   mean %llu us, p50 < %llu us, p99 < %llu us, max %llu us\n",
+           (unsigned long long)all.mean_us(),
+           (unsigned long long)all.percentile_us(0.5),
+           (unsigned long long)all.percentile_us(0.99),
+           (unsigned long long)all.max_us);
+    printf("wakeup latency     mean %llu us, max %llu us\n",
+           (unsigned long long)p.stats.wakeup().mean_us(),
+           (unsigned long long)p.stats.wakeup().max_us);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*****************************************************************************
+ * bench_folded_name_map.cpp: property bag lookup microbenchmark
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "folded_name_map.h"
+#include "test.h"
+
+/*
+ * bench_folded_name_map [rounds]
+ *
+ * Fills a property bag with the control's persisted properties, then
+ * reads each of them back under the spellings containers use, with
+ * folded_name_map and with the std::map ordered by a case-insensitive
+ * compare it replaced, and reports the time per bag and per lookup.
+ */
+
+static int fold(char16_t c)
+{
+    return c >= u'A' && c <= u'Z' ? c - u'A' + u'a' : c;
+}
+
+// what _wcsicmp did for ASCII names
+struct less_nocase
+{
+    bool operator()(const std::u16string& a, const std::u16string& b) const
+    {
+        size_t n = a.size() < b.size() ? a.size() : b.size();
+        for( size_t i = 0; i < n; ++i )
+        {
+            int d = fold(a[i]) - fold(b[i]);
+            if( d )
+                return d < 0;
+        }
+        return a.size() < b.size();
+    }
+};
+
+int main(int argc, char **argv)
+{
+    unsigned rounds = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+    static const char16_t *saved[] = {
+        u"MRL", u"AutoPlay", u"Toolbar", u"ExtentWidth", u"ExtentHeight",
+        u"AutoLoop", u"Visible", u"Volume", u"StartTime", u"BaseURL",
+        u"BackColor", u"FullscreenEnabled", u"Branding",
+    };
+    // Load asks for the canonical name and its aliases, mostly missing
+    static const char16_t *loaded[] = {
+        u"mrl", u"src", u"filename", u"target", u"autoplay", u"autostart",
+        u"toolbar", u"controls", u"extentwidth", u"extentheight", u"autoloop",
+        u"loop", u"mute", u"visible", u"showdisplay", u"volume", u"starttime",
+        u"baseurl", u"backcolor", u"bgcolor", u"fullscreenenabled",
+        u"allowfullscreen", u"fullscreen", u"branding",
+    };
+    const size_t n_saved = sizeof(saved) / sizeof(saved[0]);
+    const size_t n_loaded = sizeof(loaded) / sizeof(loaded[0]);
+    std::vector<std::u16string> names(saved, saved + n_saved);
+    std::vector<std::u16string> probes(loaded, loaded + n_loaded);
+
+    long found = 0;
+    uint64_t start = monotonic_now_us();
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        std::map<std::u16string, int, less_nocase> bag;
+        for( size_t i = 0; i < n_saved; ++i )
+            bag[names[i]] = (int)i;
+        for( size_t i = 0; i < n_loaded; ++i )
+            found += bag.find(probes[i]) != bag.end();
+    }
+    double map_ms = elapsed_ms(start);
+
+    start = monotonic_now_us();
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        folded_name_map<int> bag;
+        for( size_t i = 0; i < n_saved; ++i )
+            bag.assign(names[i].data(), names[i].size(), (int)i);
+        for( size_t i = 0; i < n_loaded; ++i )
+            found -= bag.find(probes[i].data(), probes[i].size()) != nullptr;
+    }
+    double folded_ms = elapsed_ms(start);
+
+    // lookups alone, on one filled bag
+    folded_name_map<int> fbag;
+    std::map<std::u16string, int, less_nocase> mbag;
+    for( size_t i = 0; i < n_saved; ++i )
+    {
+        fbag.assign(names[i].data(), names[i].size(), (int)i);
+        mbag[names[i]] = (int)i;
+    }
+    unsigned lookups = rounds * 10;
+    long hits = 0;
+    start = monotonic_now_us();
+    for( unsigned r = 0; r < lookups; ++r )
+        hits += mbag.find(probes[r % n_loaded]) != mbag.end();
+    double map_lookup_ms = elapsed_ms(start);
+    start = monotonic_now_us();
+    for( unsigned r = 0; r < lookups; ++r )
+    {
+        const std::u16string& p = probes[r % n_loaded];
+        hits -= fbag.find(p.data(), p.size()) != nullptr;
+    }
+    double folded_lookup_ms = elapsed_ms(start);
+
+    printf("bags %u, %zu properties saved, %zu names probed on load\n", rounds, n_saved, n_loaded);
+    printf("std::map         %7.1f ms, %5.0f ns per bag, %4.1f ns per lookup\n",
+           map_ms, map_ms * 1e6 / rounds, map_lookup_ms * 1e6 / lookups);
+    printf("folded_name_map  %7.1f ms, %5.0f ns per bag, %4.1f ns per lookup\n",
+           folded_ms, folded_ms * 1e6 / rounds, folded_lookup_ms * 1e6 / lookups);
+    return found == 0 && hits == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * bench_meta_index.cpp: benchmark of the playlist metadata search index
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "meta_index.h"
+#include "test.h"
+
+/*
+ * bench_meta_index [items]
+ *
+ * Indexes a synthetic playlist of 50000 items, with the title, artist,
+ * album, genre and MRL vlc_player indexes, then runs prefix queries of
+ * one to four words through meta_index and through a scan of every
+ * item's text, what a page filtering the playlist has to do. Reports
+ * the build time and the time per query of each.
+ */
+
+static const char *const words[] = {
+    "love", "night", "summer", "blue", "fire", "dream", "heart", "city",
+    "light", "rain", "road", "home", "star", "river", "gold", "shadow",
+    "dance", "wild", "silver", "ocean", "morning", "echo", "storm", "velvet",
+};
+static const char *const genres[] = {
+    "Rock", "Pop", "Jazz", "Classical", "Electronic", "Hip-Hop", "Folk", "Metal",
+};
+
+static uint32_t next(uint32_t& x)
+{
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return x;
+}
+
+static bool is_word(unsigned char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+        || (c >= '0' && c <= '9') || c >= 0x80;
+}
+
+// whether a word of text starts with prefix, text and prefix folded
+static bool has_prefix(const std::string& text, const std::string& prefix)
+{
+    for( size_t at = text.find( prefix ); at != std::string::npos;
+         at = text.find( prefix, at + 1 ) )
+    {
+        if( at == 0 || !is_word( text[at - 1] ) )
+            return true;
+    }
+    return false;
+}
+
+static std::string folded(std::string s)
+{
+    for( auto& c : s )
+        if( c >= 'A' && c <= 'Z' )
+            c = c - 'A' + 'a';
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned count = argc > 1 ? (unsigned)atoi(argv[1]) : 50000;
+    const size_t n_words = sizeof(words) / sizeof(*words);
+    const size_t n_genres = sizeof(genres) / sizeof(*genres);
+
+    uint32_t x = 2463534242u;
+    std::vector<std::string> fields[5];
+    for( auto& f : fields )
+        f.resize( count );
+    for( unsigned i = 0; i < count; ++i )
+    {
+        std::string n = std::to_string( i );
+        fields[0][i] = std::string( words[next( x ) % n_words] ) + " " + words[next( x ) % n_words]
+                     + " " + words[next( x ) % n_words] + " " + n;
+        fields[1][i] = std::string( "The " ) + words[next( x ) % n_words] + "s " + std::to_string( next( x ) % 2000 );
+        fields[2][i] = std::string( words[next( x ) % n_words] ) + " Sessions Vol " + std::to_string( next( x ) % 40 );
+        fields[3][i] = genres[next( x ) % n_genres];
+        fields[4][i] = "http://media.example.com/library/" + n + "/track.mp3";
+    }
+
+    meta_index index;
+    uint64_t start = monotonic_now_us();
+    for( unsigned i = 0; i < count; ++i )
+    {
+        const char *texts[5];
+        for( int f = 0; f < 5; ++f )
+            texts[f] = fields[f][i].c_str();
+        index.set( index.push_back(), texts, 5 );
+    }
+    double build_ms = elapsed_ms(start);
+
+    // what a scan compares against: each item's text, folded once
+    std::vector<std::string> scan_text( count );
+    for( unsigned i = 0; i < count; ++i )
+        scan_text[i] = folded( fields[0][i] + " " + fields[1][i] + " " + fields[2][i]
+                             + " " + fields[3][i] + " " + fields[4][i] );
+
+    std::vector<std::vector<std::string> > queries;
+    for( int q = 0; q < 300; ++q )
+    {
+        std::vector<std::string> prefixes;
+        for( uint32_t k = 1 + next( x ) % 3; k > 0; --k )
+        {
+            std::string w = next( x ) % 4 ? words[next( x ) % n_words] : folded( genres[next( x ) % n_genres] );
+            prefixes.push_back( w.substr( 0, 2 + next( x ) % 3 ) );
+        }
+        // a number prefix spans thousands of words, one per title
+        if( q % 10 == 0 )
+            prefixes.push_back( std::to_string( 1 + next( x ) % 9 ) );
+        queries.push_back( prefixes );
+    }
+
+    size_t index_hits = 0;
+    std::vector<unsigned> positions;
+    start = monotonic_now_us();
+    for( const auto& q : queries )
+    {
+        std::string text;
+        for( const auto& p : q )
+            text += p + " ";
+        index.query( text.data(), text.size(), positions );
+        index_hits += positions.size();
+    }
+    double index_ms = elapsed_ms(start);
+
+    size_t scan_hits = 0;
+    start = monotonic_now_us();
+    for( const auto& q : queries )
+    {
+        for( unsigned i = 0; i < count; ++i )
+        {
+            bool all = true;
+            for( size_t p = 0; all && p < q.size(); ++p )
+                all = has_prefix( scan_text[i], q[p] );
+            scan_hits += all;
+        }
+    }
+    double scan_ms = elapsed_ms(start);
+
+    printf("items %u, queries %zu, hits %zu / %zu\n", count, queries.size(), index_hits, scan_hits);
+    printf("build       %.1f ms, %.2f us per item\n", build_ms, build_ms * 1000 / count);
+    printf("meta_index  %.1f ms, %.3f ms per query\n", index_ms, index_ms / queries.size());
+    printf("scan        %.1f ms, %.3f ms per query\n", scan_ms, scan_ms / queries.size());
+    return index_hits == scan_hits ? 0 : 1;
+}
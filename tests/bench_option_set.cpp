@@ -0,0 +1,120 @@
+/*****************************************************************************
+ * bench_option_set.cpp: memory and time report of interned media options
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "option_set.h"
+#include "option_tokenizer.h"
+#include "test.h"
+
+/*
+ * bench_option_set [items] [options per item] [distinct lists]
+ *
+ * Builds a playlist's worth of option lists, first as one tokenized copy
+ * per item like before interning, then through option_set_table, and
+ * reports the heap held and the time taken by each. The heap is measured
+ * by counting the bytes that go through operator new.
+ */
+
+static std::atomic<size_t> live_bytes(0);
+
+void *operator new(size_t size)
+{
+    size_t *p = static_cast<size_t*>(malloc(size + sizeof(size_t) * 2));
+    if( !p )
+        throw std::bad_alloc();
+    *p = size;
+    live_bytes += size;
+    return p + 2;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if( !ptr )
+        return;
+    size_t *p = static_cast<size_t*>(ptr) - 2;
+    live_bytes -= *p;
+    free(p);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned items = argc > 1 ? (unsigned)atoi(argv[1]) : 100000;
+    unsigned per_item = argc > 2 ? (unsigned)atoi(argv[2]) : 6;
+    unsigned distinct = argc > 3 ? (unsigned)atoi(argv[3]) : 4;
+    if( !distinct )
+        distinct = 1;
+
+    // the option text scripts typically pass with every item
+    std::vector<std::string> lists(distinct);
+    for( unsigned d = 0; d < distinct; ++d )
+    {
+        char opt[96];
+        for( unsigned k = 0; k < per_item; ++k )
+        {
+            snprintf(opt, sizeof(opt), " :option-%u=\"some value %u for list %u\"", k, k, d);
+            lists[d] += opt;
+        }
+    }
+
+    size_t base = live_bytes;
+    uint64_t start = monotonic_now_us();
+    {
+        std::vector<option_list> copies(items);
+        for( unsigned i = 0; i < items; ++i )
+            copies[i].parse(lists[i % distinct]);
+        double ms = elapsed_ms(start);
+        printf("per item copies  %8.1f ms, %8zu KiB held\n", ms, (live_bytes - base) / 1024);
+    }
+
+    base = live_bytes;
+    start = monotonic_now_us();
+    {
+        option_set_table table;
+        option_list scratch;
+        std::vector<option_set_ptr> sets(items);
+        for( unsigned i = 0; i < items; ++i )
+        {
+            scratch.clear();
+            scratch.parse(lists[i % distinct]);
+            sets[i] = table.intern(scratch.size(), scratch.argv());
+        }
+        double ms = elapsed_ms(start);
+        printf("interned sets    %8.1f ms, %8zu KiB held, %lu built, %lu shared\n",
+               ms, (live_bytes - base) / 1024, table.misses(), table.hits());
+    }
+    printf("items %u, %u options each, %u distinct lists\n", items, per_item, distinct);
+    return 0;
+}
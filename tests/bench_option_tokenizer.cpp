@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * bench_option_tokenizer.cpp: media option tokenizer throughput
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "option_tokenizer.h"
+#include "test.h"
+
+/*
+ * bench_option_tokenizer [strings]
+ *
+ * Splits typical option strings with option_list and with a copy of the
+ * former one allocation per option scheme, and reports the time per
+ * string of each.
+ */
+
+static size_t split_allocating(const char *s, char ***options)
+{
+    size_t capacity = 16, count = 0;
+    char **opts = (char **)malloc(capacity * sizeof(char *));
+    char *copy = strdup(s);
+    char *val = copy, *end = copy + strlen(copy);
+    while( val < end )
+    {
+        while( val < end && (*val == ' ' || *val == '\t') )
+            ++val;
+        char *start = val;
+        while( val < end && *val != ' ' && *val != '\t' )
+        {
+            char c = *(val++);
+            if( c == '\'' || c == '"' )
+                while( val < end && *(val++) != c )
+                    ;
+        }
+        if( val == start )
+            break;
+        if( count == capacity )
+        {
+            capacity += 16;
+            opts = (char **)realloc(opts, capacity * sizeof(char *));
+        }
+        *(val++) = '\0';
+        opts[count] = (char *)malloc(val - start);
+        memcpy(opts[count++], start, val - start);
+    }
+    free(copy);
+    *options = opts;
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned count = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+    static const char *samples[] = {
+        ":no-audio",
+        ":start-time=12.5 :stop-time=60 :input-repeat=2",
+        ":meta-title=\"Some long title with spaces\" :meta-artist='An Artist' "
+            ":sub-file=\"C:\\Videos\\movie.srt\" :audio-track=1 :sub-track=0",
+        ":network-caching=1000 :http-user-agent=\"Mozilla/5.0 (Windows NT 10.0)\" "
+            ":http-referrer=http://example.com/page :rtsp-tcp :no-video-title-show "
+            ":aspect-ratio=16:9 :crop=16:9 :deinterlace=1 :deinterlace-mode=yadif",
+    };
+    const unsigned n_samples = sizeof(samples) / sizeof(samples[0]);
+
+    size_t options = 0;
+    uint64_t start = monotonic_now_us();
+    for( unsigned i = 0; i < count; ++i )
+    {
+        char **opts;
+        size_t n = split_allocating(samples[i % n_samples], &opts);
+        options += n;
+        for( size_t j = 0; j < n; ++j )
+            free(opts[j]);
+        free(opts);
+    }
+    double alloc_ms = elapsed_ms(start);
+
+    size_t arena_options = 0;
+    option_list l;
+    start = monotonic_now_us();
+    for( unsigned i = 0; i < count; ++i )
+    {
+        // one list per item, cleared and reused like the add() path
+        l.clear();
+        arena_options += l.parse(samples[i % n_samples], strlen(samples[i % n_samples]));
+        l.argv();
+    }
+    double arena_ms = elapsed_ms(start);
+
+    printf("strings %u, options %zu / %zu\n", count, options, arena_options);
+    printf("allocating  %.1f ms, %.0f ns per string\n", alloc_ms, alloc_ms * 1e6 / count);
+    printf("arena       %.1f ms, %.0f ns per string\n", arena_ms, arena_ms * 1e6 / count);
+    return options == arena_options ? 0 : 1;
+}
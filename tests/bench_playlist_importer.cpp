@@ -0,0 +1,91 @@
+/*****************************************************************************
+ * bench_playlist_importer.cpp: benchmark of the streaming playlist import
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "playlist_importer.h"
+#include "test.h"
+
+/*
+ * bench_playlist_importer [entries]
+ *
+ * Imports a generated M3U of 100000 entries, each with a name and an
+ * option, fed in the 64 KiB chunks vlc_player::import_playlist reads,
+ * and reports the throughput next to a std::getline line split of the
+ * same text, the floor of any line by line parse.
+ */
+
+int main(int argc, char **argv)
+{
+    unsigned count = argc > 1 ? (unsigned)atoi(argv[1]) : 100000;
+
+    std::string text = "#EXTM3U\n";
+    for( unsigned i = 0; i < count; ++i )
+    {
+        std::string n = std::to_string( i );
+        text += "#EXTINF:" + std::to_string( 60 + i % 600 ) + " tvg-id=\"ch" + n
+              + "\" group-title=\"Group " + std::to_string( i % 50 ) + "\",Channel " + n + "\n";
+        text += "#EXTVLCOPT:network-caching=" + std::to_string( 300 + i % 7 * 100 ) + "\n";
+        text += "http://streams.example.com/live/" + n + "/index.m3u8\n";
+    }
+    double mb = text.size() / (1024.0 * 1024.0);
+
+    size_t lines = 0;
+    uint64_t start = monotonic_now_us();
+    {
+        std::istringstream in( text );
+        std::string line;
+        while( std::getline( in, line ) )
+            ++lines;
+    }
+    double getline_ms = elapsed_ms(start);
+
+    size_t entries = 0, batches = 0, names = 0;
+    start = monotonic_now_us();
+    {
+        playlist_importer importer( [&](std::vector<playlist_entry>& b) {
+            entries += b.size();
+            ++batches;
+            for( const auto& e : b )
+                names += !e.name.empty() && !e.options.empty();
+        } );
+        const size_t chunk = 64 * 1024;
+        for( size_t i = 0; i < text.size(); i += chunk )
+            importer.feed( text.data() + i, std::min( chunk, text.size() - i ) );
+        importer.finish();
+    }
+    double import_ms = elapsed_ms(start);
+
+    printf("entries %u, %.1f MiB, %zu lines\n", count, mb, lines);
+    printf("getline   %.1f ms, %.0f MiB/s\n", getline_ms, mb * 1000 / getline_ms);
+    printf("importer  %.1f ms, %.0f MiB/s, %.0f ns per entry, %zu batches\n",
+           import_ms, mb * 1000 / import_ms, import_ms * 1e6 / count, batches);
+    return entries == count && names == count ? 0 : 1;
+}
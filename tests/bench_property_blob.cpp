@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * bench_property_blob.cpp: property stream save and load throughput
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "property_blob.h"
+#include "test.h"
+
+/*
+ * bench_property_blob [rounds]
+ *
+ * Saves the control's properties the way IPersistStreamInit::Save does and
+ * loads them back, in the current format, then loads the same properties
+ * from a version 1 blob, and reports the time per save and per load.
+ */
+
+struct saved_property
+{
+    const char16_t *name;
+    int             type;
+    int32_t         value;
+    const char16_t *text;
+};
+
+static const saved_property bag[] = {
+    { u"MRL",               prt_string, 0,    u"http://media.example.com/library/shows/season1/episode01.mp4" },
+    { u"AutoPlay",          prt_bool,   1,    NULL },
+    { u"Toolbar",           prt_bool,   1,    NULL },
+    { u"ExtentWidth",       prt_int,    8467, NULL },
+    { u"ExtentHeight",      prt_int,    6350, NULL },
+    { u"AutoLoop",          prt_bool,   0,    NULL },
+    { u"Visible",           prt_bool,   1,    NULL },
+    { u"Volume",            prt_int,    100,  NULL },
+    { u"StartTime",         prt_int,    0,    NULL },
+    { u"BaseURL",           prt_string, 0,    u"http://media.example.com/" },
+    { u"BackColor",         prt_int,    0,    NULL },
+    { u"FullscreenEnabled", prt_bool,   1,    NULL },
+    { u"Branding",          prt_bool,   1,    NULL },
+};
+static const size_t bag_size = sizeof(bag) / sizeof(bag[0]);
+
+static size_t length(const char16_t *s)
+{
+    return std::char_traits<char16_t>::length(s);
+}
+
+static void put(std::vector<unsigned char>& b, const void *p, size_t n)
+{
+    b.insert(b.end(), (const unsigned char *)p, (const unsigned char *)p + n);
+}
+
+// the same bag as the former per property stream writes laid it out
+static std::vector<unsigned char> version1_blob()
+{
+    std::vector<unsigned char> b;
+    auto name = [&b](const char16_t *n, uint16_t type) {
+        uint32_t len = (uint32_t)length(n);
+        put(b, &len, sizeof(len));
+        put(b, n, len * sizeof(char16_t));
+        put(b, &type, sizeof(type));
+    };
+    int32_t count = (int32_t)bag_size;
+    name(u"(Count)", prt_int);
+    put(b, &count, sizeof(count));
+    for( size_t i = 0; i < bag_size; ++i )
+    {
+        name(bag[i].name, (uint16_t)bag[i].type);
+        if( bag[i].type == prt_bool )
+        {
+            int16_t v = bag[i].value ? -1 : 0;
+            put(b, &v, sizeof(v));
+        }
+        else if( bag[i].type == prt_int )
+            put(b, &bag[i].value, sizeof(bag[i].value));
+        else
+        {
+            uint32_t len = (uint32_t)length(bag[i].text);
+            put(b, &len, sizeof(len));
+            put(b, bag[i].text, len * sizeof(char16_t));
+        }
+    }
+    return b;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned rounds = argc > 1 ? (unsigned)atoi(argv[1]) : 200000;
+
+    size_t size = 0;
+    uint64_t start = monotonic_now_us();
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        property_blob_writer w;
+        for( size_t i = 0; i < bag_size; ++i )
+        {
+            const saved_property& p = bag[i];
+            size_t len = length(p.name);
+            if( p.type == prt_bool )
+                w.add_bool(p.name, len, p.value != 0);
+            else if( p.type == prt_int )
+                w.add_int(p.name, len, p.value);
+            else
+                w.add_string(p.name, len, p.text, length(p.text));
+        }
+        w.finish();
+        size = w.size();
+    }
+    double save_ms = elapsed_ms(start);
+
+    property_blob_writer w;
+    for( size_t i = 0; i < bag_size; ++i )
+    {
+        const saved_property& p = bag[i];
+        if( p.type == prt_bool )
+            w.add_bool(p.name, length(p.name), p.value != 0);
+        else if( p.type == prt_int )
+            w.add_int(p.name, length(p.name), p.value);
+        else
+            w.add_string(p.name, length(p.name), p.text, length(p.text));
+    }
+    w.finish();
+    std::vector<unsigned char> v1 = version1_blob();
+
+    size_t loaded = 0, consumed;
+    std::vector<property_record> records;
+    start = monotonic_now_us();
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        records.clear();
+        read_property_blob(w.data(), w.size(), records, consumed);
+        loaded += records.size();
+    }
+    double load_ms = elapsed_ms(start);
+
+    start = monotonic_now_us();
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        records.clear();
+        read_property_blob(&v1[0], v1.size(), records, consumed);
+        loaded -= records.size();
+    }
+    double load_v1_ms = elapsed_ms(start);
+
+    printf("%zu properties, %zu bytes in version 2, %zu bytes in version 1\n",
+           bag_size, size, v1.size());
+    printf("save            %6.1f ms, %5.0f ns per bag\n", save_ms, save_ms * 1e6 / rounds);
+    printf("load version 2  %6.1f ms, %5.0f ns per bag\n", load_ms, load_ms * 1e6 / rounds);
+    printf("load version 1  %6.1f ms, %5.0f ns per bag\n", load_v1_ms, load_v1_ms * 1e6 / rounds);
+    return loaded == 0 ? 0 : 1;
+}
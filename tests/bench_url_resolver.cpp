@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * bench_url_resolver.cpp: relative MRL resolution throughput
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "url_resolver.h"
+#include "test.h"
+
+/*
+ * bench_url_resolver [references]
+ *
+ * Resolves playlist sized batches of relative references against one base,
+ * with the base split once as VLCPlugin does, and set again for every
+ * reference as a resolver without the cache would, then normalizes the
+ * results like the MRL index does.
+ */
+
+int main(int argc, char **argv)
+{
+    unsigned count = argc > 1 ? (unsigned)atoi(argv[1]) : 1000000;
+    static const char base[] = "http://media.example.com/library/shows/season1/index.html?lang=en";
+    static const char *refs[] = {
+        "episode01.mp4",
+        "../season2/episode01.mp4",
+        "./extras/making%2Dof.mkv?t=10",
+        "/live/stream.m3u8",
+        "//cdn.example.net/a/b/../c.ts",
+        "rtsp://camera.local:554/stream1",
+        "subs/episode01.en.srt#cue",
+    };
+    const unsigned n_refs = sizeof(refs) / sizeof(refs[0]);
+    size_t lens[n_refs];
+    for( unsigned i = 0; i < n_refs; ++i )
+        lens[i] = strlen(refs[i]);
+
+    std::string out;
+    size_t bytes = 0;
+    url_resolver cached;
+    cached.set_base(base, sizeof(base) - 1);
+    uint64_t start = monotonic_now_us();
+    for( unsigned i = 0; i < count; ++i )
+    {
+        cached.resolve(refs[i % n_refs], lens[i % n_refs], out);
+        bytes += out.size();
+    }
+    double cached_ms = elapsed_ms(start);
+
+    start = monotonic_now_us();
+    for( unsigned i = 0; i < count; ++i )
+    {
+        url_resolver r;
+        r.set_base(base, sizeof(base) - 1);
+        r.resolve(refs[i % n_refs], lens[i % n_refs], out);
+        bytes -= out.size();
+    }
+    double uncached_ms = elapsed_ms(start);
+
+    std::string norm;
+    start = monotonic_now_us();
+    for( unsigned i = 0; i < count; ++i )
+    {
+        cached.resolve(refs[i % n_refs], lens[i % n_refs], out);
+        url_resolver::normalize(out.data(), out.size(), norm);
+    }
+    double normalize_ms = elapsed_ms(start);
+
+    printf("references %u\n", count);
+    printf("cached base       %7.1f ms, %4.0f ns per reference\n", cached_ms, cached_ms * 1e6 / count);
+    printf("base set per call %7.1f ms, %4.0f ns per reference\n", uncached_ms, uncached_ms * 1e6 / count);
+    printf("resolve+normalize %7.1f ms, %4.0f ns per reference\n", normalize_ms, normalize_ms * 1e6 / count);
+    return bytes == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+/*****************************************************************************
+ * bench_utf_transcoder.cpp: UTF-16/UTF-8 conversion throughput
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "utf_transcoder.h"
+#include "test.h"
+
+/*
+ * bench_utf_transcoder [megabytes]
+ *
+ * Converts ASCII, Latin and CJK text both ways with utf_transcoder and
+ * with a plain one code point at a time loop that sizes in one pass and
+ * converts in another, like the two Win32 calls did, and reports the
+ * throughput of each.
+ */
+
+static size_t scalar_utf16_to_utf8(const char16_t *s, size_t len, char *out)
+{
+    size_t n = 0;
+    for( size_t i = 0; i < len; ++i )
+    {
+        char32_t c = s[i];
+        if( c >= 0xD800 && c <= 0xDBFF && i + 1 < len && s[i + 1] >= 0xDC00 && s[i + 1] <= 0xDFFF )
+            c = 0x10000 + ((c - 0xD800) << 10) + (s[++i] - 0xDC00);
+        else if( c >= 0xD800 && c <= 0xDFFF )
+            c = 0xFFFD;
+        if( c < 0x80 )
+        {
+            if( out ) out[n] = (char)c;
+            n += 1;
+        }
+        else if( c < 0x800 )
+        {
+            if( out ) { out[n] = (char)(0xC0 | (c >> 6)); out[n + 1] = (char)(0x80 | (c & 0x3F)); }
+            n += 2;
+        }
+        else if( c < 0x10000 )
+        {
+            if( out ) { out[n] = (char)(0xE0 | (c >> 12)); out[n + 1] = (char)(0x80 | ((c >> 6) & 0x3F));
+                        out[n + 2] = (char)(0x80 | (c & 0x3F)); }
+            n += 3;
+        }
+        else
+        {
+            if( out ) { out[n] = (char)(0xF0 | (c >> 18)); out[n + 1] = (char)(0x80 | ((c >> 12) & 0x3F));
+                        out[n + 2] = (char)(0x80 | ((c >> 6) & 0x3F)); out[n + 3] = (char)(0x80 | (c & 0x3F)); }
+            n += 4;
+        }
+    }
+    return n;
+}
+
+static void run(const char *name, const std::u16string& text, unsigned rounds)
+{
+    std::string utf8(utf16_to_utf8_length(text.data(), text.size()), '\0');
+    std::u16string back(text.size(), u'\0');
+    double mb = rounds * text.size() * 2 / 1e6;
+
+    uint64_t start = monotonic_now_us();
+    size_t check = 0;
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        size_t n = scalar_utf16_to_utf8(text.data(), text.size(), NULL);
+        check += scalar_utf16_to_utf8(text.data(), text.size(), &utf8[0]) - n;
+    }
+    double scalar_ms = elapsed_ms(start);
+
+    start = monotonic_now_us();
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        size_t n = utf16_to_utf8_length(text.data(), text.size());
+        check += utf16_to_utf8(text.data(), text.size(), &utf8[0]) - n;
+    }
+    double to8_ms = elapsed_ms(start);
+
+    start = monotonic_now_us();
+    for( unsigned r = 0; r < rounds; ++r )
+    {
+        size_t n = utf8_to_utf16_length(utf8.data(), utf8.size());
+        check += utf8_to_utf16(utf8.data(), utf8.size(), &back[0]) - n;
+    }
+    double to16_ms = elapsed_ms(start);
+
+    printf("%-6s UTF-16 to UTF-8 %7.0f MB/s (two pass scalar %7.0f MB/s), "
+           "UTF-8 to UTF-16 %7.0f MB/s%s\n", name,
+           mb / to8_ms * 1000, mb / scalar_ms * 1000, mb / to16_ms * 1000,
+           check || back != text ? " MISMATCH" : "");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned megabytes = argc > 1 ? (unsigned)atoi(argv[1]) : 64;
+
+    // MRL sized strings: a path with a few non ASCII names in it
+    std::u16string ascii, latin, cjk;
+    for( int i = 0; i < 512; ++i )
+    {
+        ascii += (char16_t)('a' + i % 26);
+        latin += i % 7 ? (char16_t)('a' + i % 26) : (char16_t)(0xE0 + i % 16);
+        cjk += (char16_t)(0x4E00 + i * 37 % 0x5000);
+    }
+    unsigned rounds = megabytes * 1000000u / (ascii.size() * 2);
+
+    run("ascii", ascii, rounds);
+    run("latin", latin, rounds);
+    run("cjk", cjk, rounds);
+    return 0;
+}
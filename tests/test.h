@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * test.h: checks shared by the unit tests and benchmarks
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "monotonic_clock.h"
+
+/*
+ * A failed CHECK is reported with its location and the test goes on, the
+ * program then exits with test_result() so that make check counts it as
+ * failed. Benchmarks use the same clock as the code they measure.
+ */
+static int test_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++test_failures; \
+        } \
+    } while( 0 )
+
+static inline int test_result()
+{
+    if( test_failures )
+        fprintf(stderr, "%d check(s) failed\n", test_failures);
+    return test_failures ? 1 : 0;
+}
+
+static inline double elapsed_ms(uint64_t since_us)
+{
+    return (monotonic_now_us() - since_us) / 1000.0;
+}
+
+#endif //_TEST_H_
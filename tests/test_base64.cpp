@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * test_base64.cpp: unit tests of the base64 codec
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "base64.h"
+#include "test.h"
+
+static std::string encode(const char *s)
+{
+    std::string out;
+    base64_encode( (const unsigned char*)s, strlen( s ), out );
+    return out;
+}
+
+static bool decodes_to(const char *s, const char *expected)
+{
+    std::vector<unsigned char> out;
+    return base64_decode( s, strlen( s ), out )
+        && std::string( out.begin(), out.end() ) == expected;
+}
+
+static bool rejects(const char *s)
+{
+    std::vector<unsigned char> out;
+    return !base64_decode( s, strlen( s ), out ) && out.empty();
+}
+
+static void test_rfc4648_vectors()
+{
+    static const char *const vectors[][2] = {
+        { "", "" },
+        { "f", "Zg==" },
+        { "fo", "Zm8=" },
+        { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" },
+        { "fooba", "Zm9vYmE=" },
+        { "foobar", "Zm9vYmFy" },
+    };
+    for( const auto& v : vectors )
+    {
+        CHECK( encode( v[0] ) == v[1] );
+        CHECK( decodes_to( v[1], v[0] ) );
+    }
+}
+
+static void test_malformed()
+{
+    CHECK( rejects( "Zg=" ) );
+    CHECK( rejects( "Zm9v Yg==" ) );
+    CHECK( rejects( "Zm9vYg==Zm9v" ) );
+    CHECK( rejects( "Z===" ) );
+    CHECK( rejects( "Zm-v" ) );
+    // padding that drops set bits has another, canonical, spelling
+    CHECK( rejects( "Zh==" ) );
+    CHECK( rejects( "Zm9=" ) );
+}
+
+static void test_binary_round_trip()
+{
+    uint32_t x = 2463534242u;
+    for( size_t size = 0; size < 300; ++size )
+    {
+        std::vector<unsigned char> in( size );
+        for( auto& b : in )
+        {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            b = (unsigned char)x;
+        }
+        std::string text;
+        base64_encode( in.data(), in.size(), text );
+        CHECK( text.size() == (size + 2) / 3 * 4 );
+        std::vector<unsigned char> out;
+        CHECK( base64_decode( text.data(), text.size(), out ) );
+        CHECK( out == in );
+    }
+}
+
+int main()
+{
+    test_rfc4648_vectors();
+    test_malformed();
+    test_binary_round_trip();
+    return test_result();
+}
@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * test_command_executor.cpp: unit tests of the player command worker
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "command_executor.h"
+#include "test.h"
+
+enum { k_stop, k_play, k_seek, k_volume };
+
+// records what ran, in order, and lets the test hold the worker
+struct journal
+{
+    std::mutex        lock;
+    std::string       ran;
+    std::string       done;
+    std::atomic<bool> hold;
+    std::atomic<bool> holding;
+
+    journal() : hold(false), holding(false) {}
+
+    command_executor::command step(char c)
+    {
+        return [this, c]() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                ran += c;
+            }
+            holding = true;
+            while( hold )
+                std::this_thread::yield();
+            holding = false;
+            return c == 'x' ? -1 : 0;
+        };
+    }
+
+    void on_done(int kind, int status)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        done += (char)('0' + kind);
+        if( status )
+            done += '!';
+    }
+
+    std::string get_ran()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return ran;
+    }
+
+    std::string get_done()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return done;
+    }
+
+    bool wait_done(size_t count)
+    {
+        uint64_t start = monotonic_now_us();
+        while( get_done().size() < count && elapsed_ms(start) < 5000 )
+            std::this_thread::yield();
+        return get_done().size() >= count;
+    }
+
+    void wait_holding()
+    {
+        uint64_t start = monotonic_now_us();
+        while( !holding && elapsed_ms(start) < 5000 )
+            std::this_thread::yield();
+    }
+};
+
+static void test_runs_in_order()
+{
+    journal j;
+    command_executor e;
+    e.set_done_callback([&j](int kind, int status) { j.on_done(kind, status); });
+    e.post( k_play, j.step( 'a' ), false );
+    e.post( k_stop, j.step( 'x' ), false );
+    e.post( k_play, j.step( 'b' ), false );
+    CHECK( j.wait_done( 4 ) );
+    CHECK( j.get_ran() == "axb" );
+    CHECK( j.get_done() == "10!1" );
+    CHECK( e.collapsed_count() == 0 );
+}
+
+static void test_collapse_keeps_order()
+{
+    journal j;
+    command_executor e;
+    e.set_done_callback([&j](int kind, int status) { j.on_done(kind, status); });
+
+    j.hold = true;
+    e.post( k_stop, j.step( 's' ), false );
+    j.wait_holding();
+
+    // a seek posted before a play item, then a newer one after it: the
+    // newest seek must still run after the play item
+    e.post( k_seek, j.step( '1' ), true );
+    e.post( k_play, j.step( 'p' ), false );
+    e.post( k_seek, j.step( '2' ), true );
+    e.post( k_volume, j.step( 'v' ), true );
+    e.post( k_seek, j.step( '3' ), true );
+    // commands not posted as collapsible are never merged
+    e.post( k_play, j.step( 'q' ), false );
+    CHECK( e.collapsed_count() == 2 );
+
+    j.hold = false;
+    CHECK( j.wait_done( 5 ) );
+    CHECK( j.get_ran() == "spv3q" );
+    CHECK( j.get_done() == "01321" );
+}
+
+static void test_shutdown()
+{
+    journal j;
+    command_executor e;
+    e.set_done_callback([&j](int kind, int status) { j.on_done(kind, status); });
+
+    j.hold = true;
+    e.post( k_stop, j.step( 's' ), false );
+    j.wait_holding();
+    e.post( k_play, j.step( 'p' ), false );
+
+    std::thread release([&j]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        j.hold = false;
+    });
+    // waits for the running command, drops the pending one
+    e.shutdown();
+    release.join();
+    CHECK( j.get_ran() == "s" );
+    std::string done = j.get_done();
+    CHECK( done.empty() || done == "0" );
+
+    // nothing runs after a shutdown
+    e.post( k_play, j.step( 'z' ), false );
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK( j.get_ran() == "s" );
+    CHECK( j.get_done() == done );
+    e.shutdown();
+}
+
+static void test_destroy_without_post()
+{
+    command_executor e;
+    e.shutdown();
+}
+
+int main()
+{
+    test_runs_in_order();
+    test_collapse_keeps_order();
+    test_shutdown();
+    test_destroy_without_post();
+    return test_result();
+}
@@ -0,0 +1,141 @@
+/*****************************************************************************
+ * test_edl.cpp: unit tests of the segment options and gap statistics
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <locale.h>
+#include <string>
+#include <thread>
+
+#include "edl.h"
+#include "test.h"
+
+static unsigned options(int64_t start, int64_t stop, std::string out[2])
+{
+    vlc_edl_segment seg;
+    seg.mrl = "file:///a.mkv";
+    seg.start_ms = start;
+    seg.stop_ms = stop;
+    return edl_segment_options( seg, out );
+}
+
+static void test_segment_options()
+{
+    std::string o[2];
+    CHECK( options( 10000, 25000, o ) == 2 );
+    CHECK( o[0] == ":start-time=10.000" && o[1] == ":stop-time=25.000" );
+    CHECK( options( 180000, 220000, o ) == 2 );
+    CHECK( o[0] == ":start-time=180.000" && o[1] == ":stop-time=220.000" );
+    CHECK( options( 1, 1999, o ) == 2 );
+    CHECK( o[0] == ":start-time=0.001" && o[1] == ":stop-time=1.999" );
+
+    // a range from the start, or to the end
+    CHECK( options( 0, 5000, o ) == 1 && o[0] == ":stop-time=5.000" );
+    CHECK( options( 5000, 0, o ) == 1 && o[0] == ":start-time=5.000" );
+    CHECK( options( 5000, -1, o ) == 1 && o[0] == ":start-time=5.000" );
+    CHECK( options( 0, 0, o ) == 0 );
+    // a stop not after the start plays to the end
+    CHECK( options( 5000, 5000, o ) == 1 && o[0] == ":start-time=5.000" );
+    CHECK( options( 5000, 4000, o ) == 1 );
+
+    // no decimal comma, whatever the locale
+    if( setlocale( LC_NUMERIC, "de_DE.UTF-8" ) || setlocale( LC_NUMERIC, "fr_FR.UTF-8" ) )
+    {
+        CHECK( options( 12345, 0, o ) == 1 && o[0] == ":start-time=12.345" );
+        setlocale( LC_NUMERIC, "C" );
+    }
+}
+
+static bool sets_range(const char *option)
+{
+    return edl_sets_time_range( 1, &option );
+}
+
+static void test_time_range_options()
+{
+    CHECK( sets_range( ":start-time=10" ) );
+    CHECK( sets_range( "start-time=10.5" ) );
+    CHECK( sets_range( ":stop-time=3" ) );
+    CHECK( sets_range( "stop-time=3" ) );
+    CHECK( !sets_range( ":start-paused" ) );
+    CHECK( !sets_range( ":run-time=5" ) );
+    CHECK( !sets_range( ":no-audio" ) );
+    CHECK( !sets_range( "" ) );
+
+    const char *optv[] = { ":no-audio", ":audio-track-id=2", ":stop-time=40" };
+    CHECK( edl_sets_time_range( 3, optv ) );
+    CHECK( !edl_sets_time_range( 2, optv ) );
+    CHECK( !edl_sets_time_range( 0, NULL ) );
+
+    // what edl_segment_options writes is seen as a range
+    std::string o[2];
+    options( 10000, 0, o );
+    CHECK( sets_range( o[0].c_str() ) );
+}
+
+static void test_gap_stats()
+{
+    edl_gap_stats gaps;
+    vlc_player_gap_stats s;
+    gaps.get( s );
+    CHECK( s.count == 0 && s.last_us == 0 && s.mean_us == 0 && s.max_us == 0 );
+
+    gaps.record( 3000 );
+    gaps.record( 9000 );
+    gaps.record( 6000 );
+    gaps.get( s );
+    CHECK( s.count == 3 && s.last_us == 6000 && s.mean_us == 6000 && s.max_us == 9000 );
+
+    gaps.reset();
+    gaps.get( s );
+    CHECK( s.count == 0 && s.max_us == 0 && s.mean_us == 0 );
+}
+
+static void test_gap_stats_concurrent()
+{
+    // recorded from libvlc's thread while scripts read them
+    edl_gap_stats gaps;
+    std::thread t1( [&gaps]() { for( uint64_t i = 1; i <= 100000; ++i ) gaps.record( i ); } );
+    std::thread t2( [&gaps]() { for( uint64_t i = 1; i <= 100000; ++i ) gaps.record( 200000 - i ); } );
+    vlc_player_gap_stats s;
+    for( int i = 0; i < 1000; ++i )
+    {
+        gaps.get( s );
+        CHECK( s.max_us <= 199999 );
+    }
+    t1.join();
+    t2.join();
+    gaps.get( s );
+    CHECK( s.count == 200000 );
+    CHECK( s.max_us == 199999 );
+    CHECK( s.mean_us == 100000 );
+}
+
+int main()
+{
+    test_segment_options();
+    test_time_range_options();
+    test_gap_stats();
+    test_gap_stats_concurrent();
+    return test_result();
+}
@@ -0,0 +1,137 @@
+/*****************************************************************************
+ * test_event_dispatcher.cpp: unit tests of the per thread event dispatcher
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <thread>
+
+#include "event_dispatcher.h"
+#include "test.h"
+
+#if defined(_WIN32)
+
+int main()
+{
+    // the Windows backend needs a message pump, nothing to drive it here
+    return 77;
+}
+
+#else
+
+static void test_runs_in_order()
+{
+    std::shared_ptr<event_dispatcher> d = event_dispatcher::current();
+    std::string order;
+    int owner;
+    CHECK( d->post( &owner, [&order]() { order += 'a'; } ) );
+    CHECK( d->post( &owner, [&order]() { order += 'b'; } ) );
+    CHECK( d->post( &owner, [&order]() { order += 'c'; } ) );
+    CHECK( order.empty() );
+
+    CHECK( d->wait_and_drain( 0 ) );
+    CHECK( order == "abc" );
+    // the wakeup was consumed with the tasks
+    CHECK( !d->wait_and_drain( 0 ) );
+}
+
+static void test_task_posting_a_task()
+{
+    std::shared_ptr<event_dispatcher> d = event_dispatcher::current();
+    std::string order;
+    int owner;
+    d->post( &owner, [&]() {
+        order += '1';
+        d->post( &owner, [&order]() { order += '2'; } );
+    } );
+    CHECK( d->wait_and_drain( 0 ) );
+    CHECK( order == "12" );
+    CHECK( !d->wait_and_drain( 0 ) );
+}
+
+static void test_cancel()
+{
+    std::shared_ptr<event_dispatcher> d = event_dispatcher::current();
+    std::string order;
+    int first, second;
+    d->post( &first, [&order]() { order += 'a'; } );
+    d->post( &second, [&order]() { order += 'b'; } );
+    d->post( &first, [&order]() { order += 'c'; } );
+    d->cancel( &first );
+    CHECK( d->wait_and_drain( 0 ) );
+    CHECK( order == "b" );
+
+    // a task canceling another owner's queued work
+    order.clear();
+    d->post( &second, [&]() { order += 'x'; d->cancel( &first ); } );
+    d->post( &first, [&order]() { order += 'y'; } );
+    CHECK( d->wait_and_drain( 0 ) );
+    CHECK( order == "x" );
+}
+
+static void test_one_dispatcher_per_thread()
+{
+    std::shared_ptr<event_dispatcher> d = event_dispatcher::current();
+    CHECK( event_dispatcher::current() == d );
+    CHECK( d->wakeup_fd() >= 0 );
+
+    event_dispatcher *other = NULL;
+    std::thread t( [&other]() { other = event_dispatcher::current().get(); } );
+    t.join();
+    CHECK( other != NULL && other != d.get() );
+}
+
+static void test_post_from_other_thread()
+{
+    std::shared_ptr<event_dispatcher> d = event_dispatcher::current();
+    const int count = 10000;
+    int owner;
+    int ran = 0;
+    std::thread::id ran_on;
+    std::thread producer( [&]() {
+        for( int i = 0; i < count; ++i )
+            d->post( &owner, [&]() { ++ran; ran_on = std::this_thread::get_id(); } );
+    } );
+
+    uint64_t start = monotonic_now_us();
+    while( ran < count && elapsed_ms( start ) < 5000 )
+        d->wait_and_drain( 100 );
+    producer.join();
+    d->wait_and_drain( 0 );
+
+    CHECK( ran == count );
+    CHECK( ran_on == std::this_thread::get_id() );
+}
+
+int main()
+{
+    std::shared_ptr<event_dispatcher> keep = event_dispatcher::current();
+    test_runs_in_order();
+    test_task_posting_a_task();
+    test_cancel();
+    test_one_dispatcher_per_thread();
+    test_post_from_other_thread();
+    return test_result();
+}
+
+#endif
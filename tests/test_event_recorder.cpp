@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * test_event_recorder.cpp: flight recorder ring and replay tests
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <vector>
+
+#include "event_recorder.h"
+#include "test.h"
+
+static long replay_all(const char *path, std::vector<event_record>& out)
+{
+    out.clear();
+    return event_recorder::replay(path, event_recorder::replay_fast,
+                                  [&out](const event_record& rec) { out.push_back(rec); });
+}
+
+static void test_round_trip(const char *path)
+{
+    {
+        event_recorder rec;
+        CHECK( rec.open(path, 100) );
+        rec.record(erk_event, 1);
+        rec.record(erk_command, 2, (int64_t)-42);
+        rec.record(erk_dispatch, 3, 0.5);
+    }
+
+    std::vector<event_record> records;
+    CHECK( replay_all(path, records) == 3 );
+    CHECK( records.size() == 3 );
+    if( records.size() != 3 )
+        return;
+    CHECK( records[0].kind == erk_event && records[0].id == 1 && records[0].arg_type == era_none );
+    CHECK( records[1].kind == erk_command && records[1].id == 2 );
+    CHECK( records[1].arg_type == era_int && records[1].arg.i == -42 );
+    CHECK( records[2].kind == erk_dispatch && records[2].arg_type == era_float );
+    CHECK( records[2].arg.f == 0.5 );
+    CHECK( records[0].timestamp_us <= records[1].timestamp_us );
+    CHECK( records[1].timestamp_us <= records[2].timestamp_us );
+}
+
+static void test_ring_keeps_latest(const char *path)
+{
+    // the capacity is rounded up to 64, older records are overwritten
+    {
+        event_recorder rec;
+        CHECK( rec.open(path, 40) );
+        for( int i = 0; i < 1000; ++i )
+            rec.record(erk_event, i);
+    }
+
+    std::vector<event_record> records;
+    CHECK( replay_all(path, records) == 64 );
+    for( size_t i = 0; i < records.size(); ++i )
+        CHECK( records[i].id == int32_t(1000 - 64 + i) );
+}
+
+static void test_closed_recorder(const char *path)
+{
+    event_recorder rec;
+    CHECK( !rec.is_open() );
+    rec.record(erk_event, 1);
+    CHECK( !rec.open("", 64) );
+    CHECK( rec.open(path, 64) );
+    CHECK( rec.is_open() );
+    rec.close();
+    CHECK( !rec.is_open() );
+    rec.record(erk_event, 1);
+
+    std::vector<event_record> records;
+    CHECK( replay_all(path, records) == 0 );
+}
+
+static void test_invalid_files(const char *path)
+{
+    std::vector<event_record> records;
+    CHECK( replay_all("/nonexistent/recording", records) == -1 );
+
+    FILE *f = fopen(path, "wb");
+    CHECK( f != NULL );
+    if( !f )
+        return;
+    fputs("not a recording, not a recording", f);
+    fclose(f);
+    CHECK( replay_all(path, records) == -1 );
+    CHECK( records.empty() );
+}
+
+int main()
+{
+    // written in the build directory
+    const char *path = "test_event_recorder.dat";
+
+    test_round_trip(path);
+    test_ring_keeps_latest(path);
+    test_closed_recorder(path);
+    test_invalid_files(path);
+
+    remove(path);
+    return test_result();
+}
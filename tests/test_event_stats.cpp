@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * test_event_stats.cpp: unit tests of the event delivery statistics
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+
+#include "event_stats.h"
+#include "test.h"
+
+static void test_histogram_buckets()
+{
+    latency_histogram h;
+    CHECK( h.mean_us() == 0 );
+    CHECK( h.percentile_us( 0.99 ) == 0 );
+
+    h.add( 0 );
+    h.add( 1 );
+    h.add( 3 );
+    h.add( 1000 );
+    CHECK( h.count == 4 );
+    CHECK( h.total_us == 1004 );
+    CHECK( h.max_us == 1000 );
+    CHECK( h.bucket[0] == 1 && h.bucket[1] == 1 && h.bucket[2] == 1 );
+    CHECK( h.bucket[10] == 1 );
+    CHECK( h.mean_us() == 251 );
+    CHECK( h.percentile_us( 0.5 ) == 4 );
+    CHECK( h.percentile_us( 0.99 ) == 1024 );
+
+    // the last bucket has no upper bound, the maximum stands for it
+    h.add( (uint64_t)1 << 40 );
+    CHECK( h.bucket[latency_histogram::buckets - 1] == 1 );
+    CHECK( h.percentile_us( 1.0 ) == (uint64_t)1 << 40 );
+}
+
+static void test_stats_and_reset()
+{
+    event_stats s;
+    s.queued( 3 );
+    s.queued( 7 );
+    s.queued( 2 );
+    s.dropped();
+    s.delivered( 205, 100, 150 );
+    s.delivered( 205, 100, 90 );
+    s.delivered( -606, 0, 10 );
+    s.woken( 10, 30 );
+
+    CHECK( s.depth_high_water() == 7 );
+    CHECK( s.dropped_count() == 1 );
+    CHECK( s.latencies().size() == 2 );
+    CHECK( s.latencies().at( 205 ).count == 2 );
+    // a clock going backwards counts as no latency
+    CHECK( s.latencies().at( 205 ).bucket[0] == 1 );
+    CHECK( s.wakeup().max_us == 20 );
+
+    std::string report = s.report();
+    CHECK( report.find( "event -606: count 1," ) != std::string::npos );
+    CHECK( report.find( "event 205: count 2, mean 25 us" ) != std::string::npos );
+    CHECK( report.find( "wakeup 0: count 1" ) != std::string::npos );
+    CHECK( report.find( "queue high water 7, dropped 1\n" ) != std::string::npos );
+
+    s.reset();
+    CHECK( s.latencies().empty() );
+    CHECK( s.wakeup().count == 0 );
+    CHECK( s.depth_high_water() == 0 && s.dropped_count() == 0 );
+    CHECK( s.report() == "wakeup 0: count 0, mean 0 us, p50 < 0 us, p99 < 0 us, max 0 us\n"
+                         "queue high water 0, dropped 0\n" );
+}
+
+int main()
+{
+    test_histogram_buckets();
+    test_stats_and_reset();
+    return test_result();
+}
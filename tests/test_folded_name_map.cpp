@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * test_folded_name_map.cpp: unit tests of the case-folded name map
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <memory>
+#include <string>
+
+#include "folded_name_map.h"
+#include "test.h"
+
+static int *find(folded_name_map<int>& m, const std::u16string& name)
+{
+    return m.find(name.data(), name.size());
+}
+
+static void assign(folded_name_map<int>& m, const std::u16string& name, int v)
+{
+    m.assign(name.data(), name.size(), std::move(v));
+}
+
+static void test_case_folding()
+{
+    folded_name_map<int> m;
+    CHECK( m.empty() );
+    CHECK( find(m, u"Volume") == NULL );
+
+    assign(m, u"Volume", 50);
+    CHECK( find(m, u"volume") && *find(m, u"volume") == 50 );
+    CHECK( find(m, u"VOLUME") && *find(m, u"VOLUME") == 50 );
+    CHECK( find(m, u"Volum") == NULL );
+    CHECK( find(m, u"Volumes") == NULL );
+
+    // only ASCII letters fold
+    assign(m, u"Été", 1);
+    CHECK( find(m, u"ÉTé") != NULL );
+    CHECK( find(m, u"été") == NULL );
+
+    // a name in another case replaces the value and keeps the first spelling
+    assign(m, u"VOLUME", 80);
+    CHECK( m.size() == 2 );
+    CHECK( *find(m, u"Volume") == 80 );
+    CHECK( m.begin()->name == u"Volume" );
+}
+
+static void test_order_and_growth()
+{
+    folded_name_map<int> m;
+    const int count = 1000;
+    for( int i = 0; i < count; ++i )
+        assign(m, u"Name" + std::u16string(1, char16_t(u'A' + i % 26)) + std::u16string(i / 26 + 1, u'x'), i);
+    CHECK( m.size() == (size_t)count );
+
+    int expected = 0;
+    for( auto it = m.begin(); it != m.end(); ++it, ++expected )
+        CHECK( it->value == expected );
+
+    for( int i = 0; i < count; ++i )
+    {
+        std::u16string name = u"NAME" + std::u16string(1, char16_t(u'a' + i % 26)) + std::u16string(i / 26 + 1, u'X');
+        int *v = find(m, name);
+        CHECK( v && *v == i );
+    }
+
+    m.clear();
+    CHECK( m.empty() );
+    CHECK( find(m, u"NameAx") == NULL );
+    assign(m, u"again", 1);
+    CHECK( *find(m, u"AGAIN") == 1 );
+}
+
+static void test_move_only_values()
+{
+    folded_name_map<std::unique_ptr<int> > m;
+    std::u16string name = u"BaseURL";
+    m.assign(name.data(), name.size(), std::unique_ptr<int>(new int(7)));
+    std::unique_ptr<int> *v = m.find(u"baseurl", 7);
+    CHECK( v && **v == 7 );
+    m.assign(u"BASEURL", 7, std::unique_ptr<int>(new int(8)));
+    CHECK( **m.find(u"baseurl", 7) == 8 );
+}
+
+int main()
+{
+    test_case_folding();
+    test_order_and_growth();
+    test_move_only_values();
+    return test_result();
+}
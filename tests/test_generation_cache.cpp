@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * test_generation_cache.cpp: unit tests of the lazily invalidated cache
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <thread>
+
+#include "generation_cache.h"
+#include "test.h"
+
+static int released = 0;
+
+struct release_string
+{
+    void operator()(std::string *s) const
+    {
+        ++released;
+        delete s;
+    }
+};
+
+typedef generation_cache<long, std::string*, release_string> string_cache;
+
+static void test_hit_and_miss()
+{
+    released = 0;
+    {
+        string_cache c;
+        CHECK( c.find( 1 ) == NULL );
+        CHECK( c.insert( 1, new std::string( "one" ) ) );
+        CHECK( c.find( 1 ) && **c.find( 1 ) == "one" );
+        CHECK( c.find( 2 ) == NULL );
+
+        // a second store of the same key replaces, and frees, the first
+        CHECK( c.insert( 1, new std::string( "uno" ) ) );
+        CHECK( released == 1 );
+        CHECK( **c.find( 1 ) == "uno" );
+        CHECK( c.size() == 1 );
+    }
+    // destruction frees what is left
+    CHECK( released == 2 );
+}
+
+static void test_invalidation_is_lazy()
+{
+    released = 0;
+    string_cache c;
+    c.insert( 1, new std::string( "a" ) );
+    c.insert( 2, new std::string( "b" ) );
+
+    c.invalidate();
+    CHECK( released == 0 );
+    CHECK( c.size() == 2 );
+
+    CHECK( c.find( 1 ) == NULL );
+    CHECK( released == 2 );
+    CHECK( c.size() == 0 );
+}
+
+static void test_store_racing_invalidation()
+{
+    released = 0;
+    string_cache c;
+    CHECK( c.find( 1 ) == NULL );
+    // the value was read from libvlc before this change was signaled
+    c.invalidate();
+    std::string *stale = new std::string( "stale" );
+    CHECK( !c.insert( 1, stale ) );
+    CHECK( released == 0 );
+    delete stale;
+
+    // once a lookup saw the new generation, stores are kept again
+    CHECK( c.find( 1 ) == NULL );
+    CHECK( c.insert( 1, new std::string( "fresh" ) ) );
+    CHECK( **c.find( 1 ) == "fresh" );
+}
+
+static void test_invalidate_from_other_threads()
+{
+    released = 0;
+    int inserted = 0;
+    {
+        string_cache c;
+        std::thread t1( [&c]() { for( int i = 0; i < 100000; ++i ) c.invalidate(); } );
+        std::thread t2( [&c]() { for( int i = 0; i < 100000; ++i ) c.invalidate(); } );
+        for( long i = 0; i < 100000; ++i )
+        {
+            if( !c.find( i % 16 ) )
+            {
+                std::string *s = new std::string( "v" );
+                if( c.insert( i % 16, s ) )
+                    ++inserted;
+                else
+                    delete s;
+            }
+        }
+        t1.join();
+        t2.join();
+        c.invalidate();
+        CHECK( c.find( 0 ) == NULL );
+        CHECK( c.size() == 0 );
+    }
+    // every value the cache took was released exactly once
+    CHECK( released == inserted );
+}
+
+int main()
+{
+    test_hit_and_miss();
+    test_invalidation_is_lazy();
+    test_store_racing_invalidation();
+    test_invalidate_from_other_threads();
+    return test_result();
+}
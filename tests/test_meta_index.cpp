@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * test_meta_index.cpp: unit tests of the playlist metadata search index
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ctype.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "meta_index.h"
+#include "test.h"
+
+static std::vector<unsigned> query(const meta_index& index, const char *q)
+{
+    std::vector<unsigned> positions;
+    index.query( q, strlen( q ), positions );
+    return positions;
+}
+
+static bool set(meta_index& index, uint32_t id, const char *title, const char *artist = NULL)
+{
+    const char *fields[] = { title, artist, "" };
+    return index.set( id, fields, 3 );
+}
+
+static void test_words_and_prefixes()
+{
+    meta_index index;
+    uint32_t a = index.push_back();
+    uint32_t b = index.push_back();
+    uint32_t c = index.push_back();
+    CHECK( set( index, a, "The Dark Side of the Moon", "Pink Floyd" ) );
+    CHECK( set( index, b, "Wish You Were Here", "Pink Floyd" ) );
+    CHECK( set( index, c, "caf\xC3\xA9-del_mar 2001", NULL ) );
+
+    CHECK( query( index, "pink" ) == std::vector<unsigned>({ 0, 1 }) );
+    CHECK( query( index, "PI fl" ) == std::vector<unsigned>({ 0, 1 }) );
+    CHECK( query( index, "moon pink" ) == std::vector<unsigned>({ 0 }) );
+    CHECK( query( index, "the" ) == std::vector<unsigned>({ 0 }) );
+    // every word must match, prefixes only
+    CHECK( query( index, "pink zeppelin" ).empty() );
+    CHECK( query( index, "oon" ).empty() );
+    // non-ASCII bytes are letters, punctuation splits words
+    CHECK( query( index, "caf\xC3\xA9" ) == std::vector<unsigned>({ 2 }) );
+    CHECK( query( index, "caf" ) == std::vector<unsigned>({ 2 }) );
+    CHECK( query( index, "del mar 20" ) == std::vector<unsigned>({ 2 }) );
+    CHECK( query( index, "" ).empty() );
+    CHECK( query( index, " -- " ).empty() );
+}
+
+static void test_updates_and_removals()
+{
+    meta_index index;
+    uint32_t ids[4];
+    for( auto& id : ids )
+        id = index.push_back();
+    for( int i = 0; i < 4; ++i )
+        set( index, ids[i], ("song " + std::to_string( i )).c_str() );
+    CHECK( query( index, "song" ) == std::vector<unsigned>({ 0, 1, 2, 3 }) );
+
+    // new metadata replaces the old words
+    set( index, ids[1], "renamed" );
+    CHECK( query( index, "song" ) == std::vector<unsigned>({ 0, 2, 3 }) );
+    CHECK( query( index, "renamed" ) == std::vector<unsigned>({ 1 }) );
+
+    // removal shifts the positions after, ids stay
+    index.erase( 0 );
+    CHECK( index.size() == 3 );
+    CHECK( index.position( ids[0] ) == -1 );
+    CHECK( index.position( ids[2] ) == 1 );
+    CHECK( !set( index, ids[0], "gone" ) );
+    CHECK( query( index, "song" ) == std::vector<unsigned>({ 1, 2 }) );
+    CHECK( query( index, "renamed" ) == std::vector<unsigned>({ 0 }) );
+    index.erase( 7 );
+    CHECK( index.size() == 3 );
+
+    index.clear();
+    CHECK( index.size() == 0 && query( index, "s" ).empty() );
+    CHECK( index.position( ids[1] ) == -1 );
+}
+
+static void test_reorder()
+{
+    meta_index index;
+    uint32_t a = index.push_back(), b = index.push_back(), c = index.push_back();
+    set( index, a, "alpha" );
+    set( index, b, "beta" );
+    set( index, c, "gamma" );
+
+    // c, new, a: b is removed
+    std::vector<uint32_t> ids;
+    index.reorder( { 2, -1, 0 }, ids );
+    CHECK( ids.size() == 3 && ids[0] == c && ids[2] == a && ids[1] != a && ids[1] != b );
+    CHECK( index.position( b ) == -1 );
+    CHECK( query( index, "alpha" ) == std::vector<unsigned>({ 2 }) );
+    CHECK( query( index, "gamma" ) == std::vector<unsigned>({ 0 }) );
+    CHECK( query( index, "beta" ).empty() );
+    // the new item has no text until set
+    CHECK( set( index, ids[1], "delta" ) );
+    CHECK( query( index, "d" ) == std::vector<unsigned>({ 1 }) );
+}
+
+// the index against a linear scan of the same texts
+struct reference
+{
+    std::vector<uint32_t>    ids;
+    std::vector<std::string> texts;
+
+    static std::vector<std::string> words(const std::string& s)
+    {
+        std::vector<std::string> w;
+        std::string cur;
+        for( unsigned char c : s + " " )
+        {
+            if( isalnum( c ) || c >= 0x80 )
+                cur += (char)tolower( c );
+            else if( !cur.empty() )
+            {
+                w.push_back( cur );
+                cur.clear();
+            }
+        }
+        return w;
+    }
+
+    std::vector<unsigned> query(const std::string& q) const
+    {
+        std::vector<unsigned> found;
+        std::vector<std::string> prefixes = words( q );
+        if( prefixes.empty() )
+            return found;
+        for( size_t i = 0; i < texts.size(); ++i )
+        {
+            std::vector<std::string> w = words( texts[i] );
+            bool all = true;
+            for( const auto& p : prefixes )
+            {
+                bool any = false;
+                for( const auto& x : w )
+                    any = any || x.compare( 0, p.size(), p ) == 0;
+                all = all && any;
+            }
+            if( all )
+                found.push_back( (unsigned)i );
+        }
+        return found;
+    }
+};
+
+static void test_fuzz()
+{
+    static const char *const vocabulary[] = {
+        "rock", "Rocket", "roll", "ROLLING", "stone", "stones", "a", "ab", "abc",
+        "caf\xC3\xA9", "caf\xC3\xA8", "2001", "20", "x-y", "moon.mp3", "",
+    };
+    const size_t n = sizeof(vocabulary) / sizeof(*vocabulary);
+    uint32_t x = 2463534242u;
+    auto next = [&x]() { x ^= x << 13; x ^= x >> 17; x ^= x << 5; return x; };
+
+    meta_index index;
+    reference ref;
+    for( int step = 0; step < 20000; ++step )
+    {
+        uint32_t op = next() % 100;
+        if( op < 30 || ref.ids.empty() )
+        {
+            ref.ids.push_back( index.push_back() );
+            ref.texts.push_back( "" );
+        }
+        else if( op < 70 )
+        {
+            size_t pos = next() % ref.ids.size();
+            std::string title = std::string( vocabulary[next() % n] ) + " " + vocabulary[next() % n];
+            std::string artist = vocabulary[next() % n];
+            CHECK( set( index, ref.ids[pos], title.c_str(), artist.c_str() ) );
+            ref.texts[pos] = title + " " + artist;
+        }
+        else if( op < 85 )
+        {
+            size_t pos = next() % ref.ids.size();
+            index.erase( pos );
+            ref.ids.erase( ref.ids.begin() + pos );
+            ref.texts.erase( ref.texts.begin() + pos );
+        }
+        else if( op < 88 )
+        {
+            // keep a random subset, shuffled, with some new items
+            std::vector<int> sources;
+            for( size_t i = 0; i < ref.ids.size(); ++i )
+                if( next() % 4 )
+                    sources.push_back( (int)i );
+            for( size_t i = 0; i < sources.size(); ++i )
+                std::swap( sources[i], sources[next() % sources.size()] );
+            for( uint32_t k = next() % 4; k > 0; --k )
+                sources.insert( sources.begin() + next() % (sources.size() + 1), -1 );
+            std::vector<uint32_t> ids;
+            index.reorder( sources, ids );
+            std::vector<std::string> texts;
+            for( int s : sources )
+                texts.push_back( s >= 0 ? ref.texts[s] : "" );
+            for( size_t i = 0; i < sources.size(); ++i )
+                CHECK( sources[i] < 0 || ids[i] == ref.ids[sources[i]] );
+            ref.ids = ids;
+            ref.texts = texts;
+        }
+        else if( op < 89 )
+        {
+            index.clear();
+            ref.ids.clear();
+            ref.texts.clear();
+        }
+        else
+        {
+            std::string q = std::string( vocabulary[next() % n] ).substr( 0, next() % 4 );
+            if( next() % 2 )
+                q += std::string( " " ) + vocabulary[next() % n];
+            std::vector<unsigned> expected = ref.query( q );
+            CHECK( query( index, q.c_str() ) == expected );
+        }
+        CHECK( index.size() == ref.ids.size() );
+    }
+}
+
+int main()
+{
+    test_words_and_prefixes();
+    test_updates_and_removals();
+    test_reorder();
+    test_fuzz();
+    return test_result();
+}
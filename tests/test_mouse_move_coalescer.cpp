@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * test_mouse_move_coalescer.cpp: mouse move merging tests
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mouse_move_coalescer.h"
+#include "test.h"
+
+static mouse_move_event move(short button, short shift, int x, int y)
+{
+    mouse_move_event ev;
+    ev.button = button;
+    ev.shift = shift;
+    ev.x = x;
+    ev.y = y;
+    return ev;
+}
+
+static void test_single_move()
+{
+    mouse_move_coalescer c;
+    mouse_move_event ev = move( 0, 0, 0, 0 );
+    CHECK( !c.pending() );
+    CHECK( !c.take( ev ) );
+
+    CHECK( c.push( move( 1, 2, 10, 20 ) ) );
+    CHECK( c.pending() );
+    CHECK( c.take( ev ) );
+    CHECK( ev.button == 1 && ev.shift == 2 && ev.x == 10 && ev.y == 20 );
+    CHECK( !c.pending() );
+    CHECK( !c.take( ev ) );
+    CHECK( c.merged_count() == 0 );
+}
+
+static void test_merge_keeps_latest_position()
+{
+    mouse_move_coalescer c;
+    mouse_move_event ev = move( 0, 0, 0, 0 );
+    CHECK( c.push( move( 0, 0, 1, 1 ) ) );
+    CHECK( !c.push( move( 1, 4, 2, 2 ) ) );
+    CHECK( !c.push( move( 2, 0, 3, 5 ) ) );
+    CHECK( c.merged_count() == 2 );
+
+    CHECK( c.take( ev ) );
+    // buttons held at any point are reported, the rest is the latest move
+    CHECK( ev.button == 3 );
+    CHECK( ev.shift == 0 );
+    CHECK( ev.x == 3 && ev.y == 5 );
+}
+
+static void test_take_starts_over()
+{
+    mouse_move_coalescer c;
+    mouse_move_event ev = move( 0, 0, 0, 0 );
+    c.push( move( 1, 0, 1, 1 ) );
+    c.push( move( 2, 0, 2, 2 ) );
+    CHECK( c.take( ev ) );
+
+    // a move after the delivery queues a new one, without the old buttons
+    CHECK( c.push( move( 4, 0, 7, 8 ) ) );
+    CHECK( c.take( ev ) );
+    CHECK( ev.button == 4 && ev.x == 7 && ev.y == 8 );
+}
+
+static void test_reset()
+{
+    mouse_move_coalescer c;
+    mouse_move_event ev = move( 0, 0, 0, 0 );
+    c.push( move( 1, 0, 1, 1 ) );
+    c.reset();
+    CHECK( !c.pending() );
+    CHECK( !c.take( ev ) );
+    CHECK( c.push( move( 0, 0, 5, 5 ) ) );
+}
+
+static void test_burst()
+{
+    // a burst between two deliveries costs a single queued event
+    mouse_move_coalescer c;
+    mouse_move_event ev = move( 0, 0, 0, 0 );
+    unsigned queued = 0, delivered = 0;
+    for( int i = 0; i < 10000; ++i )
+    {
+        if( c.push( move( 0, 0, i, -i ) ) )
+            ++queued;
+        if( i % 100 == 99 && c.take( ev ) )
+        {
+            ++delivered;
+            CHECK( ev.x == i && ev.y == -i );
+        }
+    }
+    CHECK( queued == 100 );
+    CHECK( delivered == 100 );
+    CHECK( c.merged_count() == 9900 );
+}
+
+int main()
+{
+    test_single_move();
+    test_merge_keeps_latest_position();
+    test_take_starts_over();
+    test_reset();
+    test_burst();
+    return test_result();
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * test_option_set.cpp: unit tests of the interned media option sets
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <string>
+
+#include "option_set.h"
+#include "test.h"
+
+static void test_validation()
+{
+    option_set_table t;
+    const char *opts[] = { ":a", "", ":b", NULL, ":a", ":c=1", ":b" };
+    option_set_ptr s = t.intern( 7, opts );
+    CHECK( s->size() == 3 );
+    CHECK( !strcmp( s->argv()[0], ":a" ) );
+    CHECK( !strcmp( s->argv()[1], ":b" ) );
+    CHECK( !strcmp( s->argv()[2], ":c=1" ) );
+    // the set owns its text
+    CHECK( s->argv()[0] != opts[0] );
+
+    option_set_ptr empty = t.intern( 0, NULL );
+    CHECK( empty->size() == 0 );
+    CHECK( empty->argv() == NULL );
+    const char *blank[] = { "", "" };
+    CHECK( t.intern( 2, blank ) == empty );
+}
+
+static void test_interning()
+{
+    option_set_table t;
+    std::string a = ":start-time=5", b = ":no-audio";
+    const char *first[] = { a.c_str(), b.c_str() };
+    option_set_ptr s1 = t.intern( 2, first );
+
+    // equal text at other addresses resolves to the same set
+    std::string a2 = a, b2 = b;
+    const char *second[] = { a2.c_str(), b2.c_str(), a2.c_str() };
+    CHECK( t.intern( 3, second ) == s1 );
+
+    // order matters
+    const char *swapped[] = { b.c_str(), a.c_str() };
+    option_set_ptr s2 = t.intern( 2, swapped );
+    CHECK( s2 != s1 );
+    CHECK( s2->hash() != s1->hash() );
+
+    CHECK( t.hits() == 1 );
+    CHECK( t.misses() == 2 );
+}
+
+static void test_sets_are_weak()
+{
+    option_set_table t;
+    const char *opts[] = { ":x" };
+    const option_set *raw;
+    {
+        option_set_ptr s = t.intern( 1, opts );
+        raw = s.get();
+        CHECK( t.intern( 1, opts ).get() == raw );
+    }
+    // the last user is gone, the next list builds a new set
+    unsigned long misses = t.misses();
+    option_set_ptr s = t.intern( 1, opts );
+    CHECK( t.misses() == misses + 1 );
+
+    // many short lived sets do not pile up, and live ones survive purges
+    char buf[32];
+    for( int i = 0; i < 10000; ++i )
+    {
+        snprintf( buf, sizeof(buf), ":n=%d", i );
+        const char *o[] = { buf };
+        t.intern( 1, o );
+    }
+    CHECK( t.intern( 1, opts ) == s );
+}
+
+int main()
+{
+    test_validation();
+    test_interning();
+    test_sets_are_weak();
+    return test_result();
+}
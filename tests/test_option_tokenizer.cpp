@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * test_option_tokenizer.cpp: unit and fuzz tests of the media option tokenizer
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "option_tokenizer.h"
+#include "test.h"
+
+// the splitting rules of the former parseStringOptions(), kept as the
+// reference the arena tokenizer has to match
+static std::vector<std::string> reference_split(const std::string& s)
+{
+    std::vector<std::string> out;
+    const char *val = s.c_str();
+    const char *end = val + strlen(val);
+    while( val < end )
+    {
+        while( val < end && (*val == ' ' || *val == '\t') )
+            ++val;
+        const char *start = val;
+        while( val < end && *val != ' ' && *val != '\t' )
+        {
+            char c = *(val++);
+            if( c == '\'' || c == '"' )
+                while( val < end && *(val++) != c )
+                    ;
+        }
+        if( val == start )
+            break;
+        out.push_back(std::string(start, val - start));
+        ++val;
+    }
+    return out;
+}
+
+static std::vector<std::string> split(option_list& l, const std::string& s)
+{
+    size_t first = l.size();
+    size_t n = l.parse(s);
+    CHECK( l.size() == first + n );
+
+    std::vector<std::string> out;
+    for( size_t i = first; i < l.size(); ++i )
+    {
+        option_view v = l[i];
+        CHECK( v.data[v.size] == '\0' );
+        out.push_back(std::string(v.data, v.size));
+    }
+    return out;
+}
+
+static void test_rules()
+{
+    option_list l;
+    std::vector<std::string> o = split(l, "  :no-audio\t:start-time=10  ");
+    CHECK( o.size() == 2 && o[0] == ":no-audio" && o[1] == ":start-time=10" );
+
+    o = split(l, ":meta-title=\"a b\" ':x=c\td' z");
+    CHECK( o.size() == 3 );
+    CHECK( o[0] == ":meta-title=\"a b\"" );
+    CHECK( o[1] == "':x=c\td'" );
+    CHECK( o[2] == "z" );
+
+    // a quote of the other kind does not close, an unterminated one runs
+    // to the end
+    o = split(l, "a\"b' c\" 'd e");
+    CHECK( o.size() == 2 && o[0] == "a\"b' c\"" && o[1] == "'d e" );
+
+    CHECK( split(l, "").empty() );
+    CHECK( split(l, " \t ").empty() );
+
+    l.append(std::string("verbatim \"option"));
+    CHECK( l[l.size() - 1].size == 16 );
+    CHECK( !strcmp(l[l.size() - 1].data, "verbatim \"option") );
+
+    const char **argv = l.argv();
+    CHECK( argv != NULL );
+    CHECK( !strcmp(argv[0], ":no-audio") );
+    CHECK( !strcmp(argv[l.size() - 1], "verbatim \"option") );
+
+    l.clear();
+    CHECK( l.empty() );
+    CHECK( l.argv() == NULL );
+}
+
+// strings over a small alphabet so that blanks and quotes are frequent
+static void test_fuzz_against_reference()
+{
+    static const char alphabet[] = "  \t\"'ab:=";
+    uint32_t seed = 2463534242u;
+    for( int round = 0; round < 200000; ++round )
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        std::string s;
+        uint32_t len = seed % 24;
+        uint32_t r = seed;
+        for( uint32_t i = 0; i < len; ++i )
+        {
+            r = r * 1103515245u + 12345u;
+            s += alphabet[(r >> 16) % (sizeof(alphabet) - 1)];
+        }
+
+        option_list l;
+        // a previous parse must not disturb the next one
+        if( round & 1 )
+            l.parse(std::string("x 'y"));
+        std::vector<std::string> got = split(l, s);
+        std::vector<std::string> want = reference_split(s);
+        if( got != want )
+        {
+            fprintf(stderr, "mismatch on [%s]\n", s.c_str());
+            CHECK( got == want );
+            break;
+        }
+    }
+}
+
+int main()
+{
+    test_rules();
+    test_fuzz_against_reference();
+    return test_result();
+}
@@ -0,0 +1,284 @@
+/*****************************************************************************
+ * test_playlist_engine.cpp: unit tests of the play order, repeat and shuffle
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "playlist_engine.h"
+#include "test.h"
+
+typedef playlist_engine<int> engine;
+
+// items valued 0 to n - 1, in list order
+static void fill(engine& e, int n)
+{
+    for( int i = 0; i < n; ++i )
+        e.push_back( i );
+}
+
+/* every item can be made current, which only holds if its rank and the
+ * play order agree; leaves no current item */
+static bool ranks_agree(engine& e)
+{
+    bool ok = true;
+    for( size_t p = 0; p < e.size(); ++p )
+    {
+        e.set_current( p );
+        ok = ok && e.current() == int( p );
+    }
+    e.reset_current();
+    return ok;
+}
+
+// values of the items next() plays until the end of the order
+static std::vector<int> play_out(engine& e)
+{
+    std::vector<int> played;
+    for( int pos; (pos = e.next()) >= 0 && played.size() <= e.size(); )
+        played.push_back( e[pos] );
+    return played;
+}
+
+static void test_list_order()
+{
+    engine e;
+    CHECK( e.current() == -1 );
+    CHECK( e.next() == -1 && e.prev() == -1 && e.peek_next() == -1 );
+
+    fill( e, 5 );
+    CHECK( e.current() == -1 );
+    for( int i = 0; i < 5; ++i )
+    {
+        CHECK( e.peek_next() == i );
+        CHECK( e.next() == i && e.current() == i );
+    }
+    // stays on the last item
+    CHECK( e.peek_next() == -1 );
+    CHECK( e.next() == -1 && e.current() == 4 );
+    CHECK( e.prev() == 3 && e.prev() == 2 );
+
+    e.set_current( 0 );
+    CHECK( e.prev() == -1 && e.current() == 0 );
+
+    // ids stay with their item as positions shift
+    uint32_t id = e.id_at( 2 );
+    e.insert( 0, 10 );
+    CHECK( e.position( id ) == 3 && e[3] == 2 );
+    e.erase( 3 );
+    CHECK( e.position( id ) == -1 );
+}
+
+static void test_insert_around_current()
+{
+    engine e;
+    fill( e, 5 );
+    e.set_current( 2 );
+
+    // before the current item, it shifts with its position
+    e.insert( 0, 10 );
+    CHECK( e.current() == 3 && e[3] == 2 );
+    e.insert( 3, 11 );
+    CHECK( e.current() == 4 && e[4] == 2 );
+    // right after it, the new item plays next
+    e.insert( 5, 12 );
+    CHECK( e.current() == 4 );
+    CHECK( e.peek_next() == 5 && e[5] == 12 );
+    CHECK( e.next() == 5 );
+    CHECK( e[e.next()] == 3 );
+    CHECK( ranks_agree( e ) );
+
+    // with no current item, next() plays the inserted item in its place
+    engine f;
+    fill( f, 3 );
+    f.insert( 0, 10 );
+    CHECK( f[f.next()] == 10 );
+    // appended after the end was reached
+    engine g;
+    fill( g, 2 );
+    g.set_current( 1 );
+    CHECK( g.next() == -1 );
+    g.push_back( 2 );
+    CHECK( g.next() == 2 );
+}
+
+static void test_erase_around_current()
+{
+    engine e;
+    fill( e, 6 );
+    e.set_current( 3 );
+
+    e.erase( 0 );
+    CHECK( e.current() == 2 && e[2] == 3 );
+    e.erase( 4 );
+    CHECK( e.current() == 2 && e[e.peek_next()] == 4 );
+
+    // the cursor stays between the neighbours of the erased item
+    e.erase( 2 );
+    CHECK( e.current() == -1 );
+    CHECK( e[e.peek_next()] == 4 );
+    CHECK( e[e.next()] == 4 );
+    CHECK( e.next() == -1 );
+    CHECK( ranks_agree( e ) );
+
+    e.set_current( 2 );
+    e.erase( 2 );
+    CHECK( e.current() == -1 && e.next() == -1 );
+    e.reset_current();
+    CHECK( e[e.next()] == 1 );
+
+    e.clear();
+    CHECK( e.empty() && e.current() == -1 && e.next() == -1 );
+}
+
+static void test_repeat_and_loop()
+{
+    engine e;
+    fill( e, 3 );
+
+    e.set_mode( engine::mode_repeat );
+    // no current item yet, the first one is picked
+    CHECK( e.next() == 0 );
+    CHECK( e.next() == 0 && e.prev() == 0 && e.peek_next() == 0 );
+    e.set_current( 2 );
+    CHECK( e.next() == 2 && e.peek_next() == 2 );
+
+    e.set_mode( engine::mode_loop );
+    CHECK( e.peek_next() == 0 );
+    CHECK( e.next() == 0 );
+    CHECK( e.prev() == 2 );
+    CHECK( e.prev() == 1 );
+
+    e.set_mode( engine::mode_default );
+    e.set_current( 2 );
+    CHECK( e.next() == -1 && e.current() == 2 );
+}
+
+static void test_shuffle()
+{
+    engine e( 1 );
+    fill( e, 20 );
+    e.set_current( 7 );
+
+    // the current item goes first, the others follow once each
+    e.set_shuffle( true );
+    CHECK( e.shuffle() && e.current() == 7 );
+    CHECK( e.prev() == -1 && e.current() == 7 );
+    std::vector<int> played = play_out( e );
+    CHECK( played.size() == 19 );
+    std::sort( played.begin(), played.end() );
+    for( int i = 0, v = 0; i < 19; ++i, ++v )
+    {
+        if( v == 7 )
+            ++v;
+        CHECK( played[i] == v );
+    }
+    CHECK( ranks_agree( e ) );
+
+    // unshuffled, the list order goes on from the current item
+    e.set_current( 12 );
+    e.set_shuffle( true );
+    e.next();
+    e.next();
+    int pos = e.current();
+    e.set_shuffle( false );
+    CHECK( !e.shuffle() && e.current() == pos );
+    if( pos + 1 < 20 )
+        CHECK( e.next() == pos + 1 );
+    CHECK( ranks_agree( e ) );
+
+    // peek_next() tells what next() plays within a pass
+    engine f( 2 );
+    fill( f, 50 );
+    f.set_shuffle( true );
+    for( int peek; (peek = f.peek_next()) >= 0; )
+        CHECK( f.next() == peek );
+    CHECK( f.next() == -1 );
+
+    // a looped pass is drawn only when it starts, the item that just
+    // played does not open it
+    f.set_mode( engine::mode_loop );
+    int last = f.current();
+    CHECK( f.peek_next() == -1 );
+    CHECK( f.next() >= 0 && f.current() != last );
+}
+
+static void test_shuffled_insert()
+{
+    engine e( 3 );
+    fill( e, 10 );
+    e.set_shuffle( true );
+    for( int i = 0; i < 5; ++i )
+        e.next();
+
+    /* new items get a rank among the ones not played yet, wherever they
+     * are inserted, so they are played in this pass */
+    for( int i = 0; i < 10; ++i )
+        e.insert( size_t( i * 2 ) % (e.size() + 1), 100 + i );
+    int current = e.current();
+    std::vector<int> played = play_out( e );
+    CHECK( played.size() == 15 );
+    for( int i = 0; i < 10; ++i )
+        CHECK( std::count( played.begin(), played.end(), 100 + i ) == 1 );
+    CHECK( e.current() != current );
+
+    // the slot of a new item has a rank that agrees with the order
+    CHECK( ranks_agree( e ) );
+    e.insert( 0, 200 );
+    e.insert( e.size(), 201 );
+    e.insert( e.size() / 2, 202 );
+    CHECK( ranks_agree( e ) );
+    e.erase( 0 );
+    e.erase( e.size() / 2 );
+    CHECK( ranks_agree( e ) );
+    e.set_shuffle( false );
+    CHECK( ranks_agree( e ) );
+}
+
+static void test_seed()
+{
+    // the same seed draws the same order, another one most likely not
+    engine a( 42 ), b( 42 ), c( 43 );
+    fill( a, 30 );
+    fill( b, 30 );
+    fill( c, 30 );
+    a.set_shuffle( true );
+    b.set_shuffle( true );
+    c.set_shuffle( true );
+    std::vector<int> pa = play_out( a ), pb = play_out( b ), pc = play_out( c );
+    CHECK( pa.size() == 30 && pa == pb );
+    CHECK( pa != pc );
+}
+
+int main()
+{
+    test_list_order();
+    test_insert_around_current();
+    test_erase_around_current();
+    test_repeat_and_loop();
+    test_shuffle();
+    test_shuffled_insert();
+    test_seed();
+    return test_result();
+}
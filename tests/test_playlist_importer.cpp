@@ -0,0 +1,220 @@
+/*****************************************************************************
+ * test_playlist_importer.cpp: unit tests of the M3U and XSPF importer
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "playlist_importer.h"
+#include "test.h"
+
+// imports text fed chunk bytes at a time, all at once if chunk is 0
+static std::vector<playlist_entry> import(const std::string& text, size_t chunk = 0,
+                                          const char *base = NULL, size_t batch = 256)
+{
+    std::vector<playlist_entry> entries;
+    size_t batches = 0;
+    playlist_importer importer( [&](std::vector<playlist_entry>& b) {
+        CHECK( !b.empty() && b.size() <= batch );
+        ++batches;
+        for( auto& e : b )
+            entries.push_back( std::move( e ) );
+    }, batch );
+    if( base )
+        importer.set_base( base, strlen( base ) );
+    if( chunk == 0 )
+        chunk = text.size();
+    for( size_t i = 0; i < text.size(); i += chunk )
+        importer.feed( text.data() + i, std::min( chunk, text.size() - i ) );
+    importer.finish();
+    CHECK( importer.count() == entries.size() );
+    CHECK( batches == (entries.size() + batch - 1) / batch );
+    return entries;
+}
+
+static bool same(const std::vector<playlist_entry>& a, const std::vector<playlist_entry>& b)
+{
+    if( a.size() != b.size() )
+        return false;
+    for( size_t i = 0; i < a.size(); ++i )
+    {
+        if( a[i].mrl != b[i].mrl || a[i].name != b[i].name || a[i].options != b[i].options )
+            return false;
+    }
+    return true;
+}
+
+static const char m3u[] =
+    "\xEF\xBB\xBF#EXTM3U\r\n"
+    "#EXTINF:123 tvg-name=\"A, B\" group=\"x\",  First Song \r\n"
+    "#EXTVLCOPT:start-time=10\r\n"
+    "#EXTVLCOPT: no-audio \r\n"
+    "music/first.mp3\r\n"
+    "\r\n"
+    "# a comment\n"
+    "http://example.com/second.ogg\n"
+    "#EXTINF:-1,Third\n"
+    "  ../third.flac";
+
+static void test_m3u()
+{
+    std::vector<playlist_entry> e = import( m3u );
+    CHECK( e.size() == 3 );
+    if( e.size() != 3 )
+        return;
+    CHECK( e[0].mrl == "music/first.mp3" );
+    CHECK( e[0].name == "First Song" );
+    CHECK( e[0].options.size() == 2 && e[0].options[0] == "start-time=10"
+           && e[0].options[1] == "no-audio" );
+    // names and options belong to the next location only
+    CHECK( e[1].mrl == "http://example.com/second.ogg" );
+    CHECK( e[1].name.empty() && e[1].options.empty() );
+    // the last line has no line feed
+    CHECK( e[2].mrl == "../third.flac" && e[2].name == "Third" );
+}
+
+static void test_m3u_base()
+{
+    std::vector<playlist_entry> e = import( m3u, 0, "http://host/lists/all.m3u" );
+    CHECK( e.size() == 3 );
+    if( e.size() != 3 )
+        return;
+    CHECK( e[0].mrl == "http://host/lists/music/first.mp3" );
+    CHECK( e[1].mrl == "http://example.com/second.ogg" );
+    CHECK( e[2].mrl == "http://host/third.flac" );
+}
+
+static const char xspf[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<playlist xmlns=\"http://xspf.org/ns/0/\" xmlns:vlc=\"http://www.videolan.org/vlc/playlist/ns/0/\" version=\"1\">\n"
+    " <title>ignored, outside any track</title>\n"
+    " <trackList>\n"
+    "  <track>\n"
+    "   <location>file:///C:/Music/A%20B.mp3</location>\n"
+    "   <title>Rock &amp; Roll &#233;&#x20AC;</title>\n"
+    "   <!-- <location>file:///commented.mp3</location> -->\n"
+    "   <extension application=\"http://www.videolan.org/vlc/playlist/0\">\n"
+    "    <vlc:id>0</vlc:id>\n"
+    "    <vlc:option>start-time=5</vlc:option>\n"
+    "    <vlc:option><![CDATA[meta-title=<raw> & more]]></vlc:option>\n"
+    "   </extension>\n"
+    "  </track>\n"
+    "  <track><title>no location, skipped</title></track>\n"
+    "  <track/>\n"
+    "  <track>\n"
+    "   <location>relative/b.ogg</location>\n"
+    "  </track>\n"
+    " </trackList>\n"
+    "</playlist>\n";
+
+static void test_xspf()
+{
+    std::vector<playlist_entry> e = import( xspf );
+    CHECK( e.size() == 2 );
+    if( e.size() != 2 )
+        return;
+    CHECK( e[0].mrl == "file:///C:/Music/A%20B.mp3" );
+    CHECK( e[0].name == "Rock & Roll \xC3\xA9\xE2\x82\xAC" );
+    CHECK( e[0].options.size() == 2 && e[0].options[0] == "start-time=5"
+           && e[0].options[1] == "meta-title=<raw> & more" );
+    CHECK( e[1].mrl == "relative/b.ogg" && e[1].name.empty() && e[1].options.empty() );
+
+    e = import( xspf, 0, "http://host/x/list.xspf" );
+    CHECK( e.size() == 2 && e[1].mrl == "http://host/x/relative/b.ogg" );
+}
+
+static void test_chunk_boundaries()
+{
+    // whatever the chunks, the same entries come out
+    std::vector<playlist_entry> whole_m3u = import( m3u );
+    std::vector<playlist_entry> whole_xspf = import( xspf );
+    for( size_t chunk = 1; chunk <= 64; ++chunk )
+    {
+        CHECK( same( import( m3u, chunk ), whole_m3u ) );
+        CHECK( same( import( xspf, chunk ), whole_xspf ) );
+    }
+}
+
+static void test_batches()
+{
+    std::string text;
+    for( int i = 0; i < 1000; ++i )
+        text += "#EXTINF:1,n" + std::to_string( i ) + "\nfile:///" + std::to_string( i ) + ".mp3\n";
+    for( size_t batch : { 1, 7, 256, 1000, 5000 } )
+    {
+        std::vector<playlist_entry> e = import( text, 4096, NULL, batch );
+        CHECK( e.size() == 1000 );
+        CHECK( e.size() == 1000 && e[999].mrl == "file:///999.mp3" && e[999].name == "n999" );
+    }
+}
+
+static void test_empty_and_blank()
+{
+    CHECK( import( "" ).empty() );
+    CHECK( import( "\xEF\xBB\xBF" ).empty() );
+    CHECK( import( " \r\n\t\n" ).empty() );
+    CHECK( import( "#EXTM3U\n#EXTINF:1,dangling\n" ).empty() );
+    CHECK( import( "<playlist><trackList/></playlist>" ).empty() );
+    // a document cut short keeps the tracks that were complete
+    std::string cut( xspf, strstr( xspf, "<track/>" ) );
+    CHECK( import( cut ).size() == 1 );
+}
+
+static void test_fuzz()
+{
+    // random bytes from the playlists' alphabet, fed whole and in random
+    // chunks, must give the same entries and never crash
+    static const char alphabet[] = "<>/!-[]CDATA#EXTINF:,\"&;x \n\r\ttrack location title option";
+    uint32_t x = 2463534242u;
+    for( int round = 0; round < 2000; ++round )
+    {
+        std::string text;
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        size_t len = x % 400;
+        // start some as XSPF
+        if( round & 1 )
+            text = "<track><location>";
+        for( size_t i = 0; i < len; ++i )
+        {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            text += alphabet[x % (sizeof(alphabet) - 1)];
+        }
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        CHECK( same( import( text, 1 + x % 17 ), import( text ) ) );
+    }
+}
+
+int main()
+{
+    test_m3u();
+    test_m3u_base();
+    test_xspf();
+    test_chunk_boundaries();
+    test_batches();
+    test_empty_and_blank();
+    test_fuzz();
+    return test_result();
+}
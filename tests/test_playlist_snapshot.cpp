@@ -0,0 +1,216 @@
+/*****************************************************************************
+ * test_playlist_snapshot.cpp: unit tests of the chunked playlist snapshots
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "playlist_snapshot.h"
+#include "test.h"
+
+typedef snapshot_publisher<int> publisher;
+static const size_t chunk = playlist_snapshot<int>::chunk_size;
+
+// publishes the model from position from on, like vlc_player::publish
+static void publish(publisher& p, const std::vector<int>& model, size_t from, int current = -1)
+{
+    p.publish( model.size(), from, current, [&model](size_t i) { return model[i]; } );
+}
+
+static bool same(const publisher::pointer& s, const std::vector<int>& model)
+{
+    if( s->size() != model.size() )
+        return false;
+    for( size_t i = 0; i < model.size(); ++i )
+    {
+        if( (*s)[i] != model[i] )
+            return false;
+    }
+    return true;
+}
+
+static void test_empty()
+{
+    publisher p;
+    publisher::pointer s = p.load();
+    CHECK( s && s->size() == 0 && s->current() == -1 );
+
+    std::vector<int> model;
+    publish( p, model, 0 );
+    CHECK( p.load()->size() == 0 );
+}
+
+static void test_chunk_boundary()
+{
+    publisher p;
+    std::vector<int> model;
+
+    // appends across the end of the first and second chunks
+    for( int i = 0; i < int( 2 * chunk + 3 ); ++i )
+    {
+        model.push_back( i );
+        publish( p, model, model.size() - 1 );
+        CHECK( p.load()->size() == model.size() );
+    }
+    CHECK( same( p.load(), model ) );
+
+    // the chunks before from are shared, the ones from it on are new
+    publisher::pointer before = p.load();
+    model.insert( model.begin() + chunk, -1 );
+    publish( p, model, chunk );
+    publisher::pointer after = p.load();
+    CHECK( same( after, model ) );
+    CHECK( &(*after)[0] == &(*before)[0] );
+    CHECK( &(*after)[chunk] != &(*before)[chunk] );
+    CHECK( (*before)[chunk] == int( chunk ) );
+
+    // inserting and erasing on either side of a boundary
+    const size_t at[] = { chunk - 1, chunk, chunk + 1, 2 * chunk - 1, 2 * chunk, 0 };
+    for( size_t pos : at )
+    {
+        model.insert( model.begin() + pos, 1000 + int( pos ) );
+        publish( p, model, pos );
+        CHECK( same( p.load(), model ) );
+        model.erase( model.begin() + pos + 1 );
+        publish( p, model, pos + 1 );
+        CHECK( same( p.load(), model ) );
+    }
+
+    // erasing from the end down to exactly one chunk, then to none
+    while( model.size() > chunk )
+    {
+        model.pop_back();
+        publish( p, model, model.size() );
+        CHECK( p.load()->size() == model.size() );
+    }
+    CHECK( same( p.load(), model ) );
+    model.erase( model.begin() + 1, model.end() );
+    publish( p, model, 1 );
+    CHECK( same( p.load(), model ) );
+    model.clear();
+    publish( p, model, 0 );
+    CHECK( p.load()->size() == 0 );
+}
+
+static void test_current_only()
+{
+    publisher p;
+    std::vector<int> model;
+    for( int i = 0; i < int( chunk + 10 ); ++i )
+        model.push_back( i );
+    publish( p, model, 0, -1 );
+
+    // no item changed, every chunk is kept
+    publisher::pointer before = p.load();
+    publish( p, model, model.size(), 5 );
+    publisher::pointer after = p.load();
+    CHECK( after->current() == 5 && before->current() == -1 );
+    CHECK( &(*after)[chunk] == &(*before)[chunk] );
+    CHECK( same( after, model ) );
+}
+
+static void test_old_snapshot_kept()
+{
+    publisher p;
+    std::vector<int> model;
+    for( int i = 0; i < int( 3 * chunk ); ++i )
+        model.push_back( i );
+    publish( p, model, 0, 1 );
+
+    // a reader holds on to it while the list changes under it
+    publisher::pointer held = p.load();
+    const std::vector<int> seen = model;
+    model.erase( model.begin(), model.begin() + chunk + 1 );
+    publish( p, model, 0, 0 );
+    model.clear();
+    publish( p, model, 0 );
+
+    CHECK( p.load()->size() == 0 );
+    CHECK( same( held, seen ) );
+    CHECK( held->current() == 1 );
+}
+
+/* readers load snapshots while a writer publishes, each must be one whole
+ * state of the list: a run of consecutive values, current on the last */
+static void test_concurrent_readers()
+{
+    publisher p;
+    std::atomic<bool> done( false );
+    std::atomic<int> torn( 0 );
+
+    auto reader = [&]() {
+        while( !done )
+        {
+            publisher::pointer s = p.load();
+            size_t n = s->size();
+            if( n == 0 )
+            {
+                if( s->current() != -1 )
+                    ++torn;
+                continue;
+            }
+            int first = (*s)[0];
+            if( s->current() != int( n - 1 ) || (*s)[n - 1] != first + int( n - 1 ) )
+                ++torn;
+            for( size_t i = 0; i < n; i += chunk / 2 )
+            {
+                if( (*s)[i] != first + int( i ) )
+                    ++torn;
+            }
+        }
+    };
+    std::thread r1( reader ), r2( reader );
+
+    std::vector<int> model;
+    int value = 0;
+    for( int round = 0; round < 20; ++round )
+    {
+        for( size_t i = 0; i < chunk + chunk / 2; ++i )
+        {
+            model.push_back( value++ );
+            publish( p, model, model.size() - 1, int( model.size() - 1 ) );
+        }
+        for( size_t i = 0; i < chunk; ++i )
+        {
+            model.erase( model.begin() );
+            publish( p, model, 0, int( model.size() ) - 1 );
+        }
+    }
+    done = true;
+    r1.join();
+    r2.join();
+    CHECK( torn == 0 );
+    CHECK( same( p.load(), model ) );
+}
+
+int main()
+{
+    test_empty();
+    test_chunk_boundary();
+    test_current_only();
+    test_old_snapshot_kept();
+    test_concurrent_readers();
+    return test_result();
+}
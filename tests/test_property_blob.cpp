@@ -0,0 +1,228 @@
+/*****************************************************************************
+ * test_property_blob.cpp: unit and fuzz tests of the property stream format
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "property_blob.h"
+#include "test.h"
+
+typedef std::vector<unsigned char> bytes;
+
+static bytes write_typical()
+{
+    property_blob_writer w;
+    w.add_string(u"MRL", 3, u"http://example.com/vidéo.mp4", 28);
+    w.add_bool(u"AutoPlay", 8, true);
+    w.add_bool(u"Toolbar", 7, false);
+    w.add_int(u"ExtentWidth", 11, 8467);
+    w.add_int(u"Volume", 6, 75);
+    w.add_string(u"BaseURL", 7, u"", 0);
+    // not a schema property: a record
+    w.add_int(u"Custom", 6, -5);
+    // names are case insensitive, as in the bag, the last value wins
+    w.add_bool(u"AUTOPLAY", 8, false);
+    w.add_empty(u"Nothing", 7);
+    CHECK( !w.add_int(u"", 0, 1) );
+    w.finish();
+    return bytes(w.data(), w.data() + w.size());
+}
+
+static const property_record *find(const std::vector<property_record>& r, const char16_t *name)
+{
+    for( const auto& p : r )
+        if( p.name == name )
+            return &p;
+    return NULL;
+}
+
+static void test_round_trip()
+{
+    bytes blob = write_typical();
+    // a container may keep its own data after the properties
+    bytes stream = blob;
+    stream.push_back(0xAB);
+
+    std::vector<property_record> r;
+    size_t consumed;
+    CHECK( read_property_blob(&stream[0], stream.size(), r, consumed) );
+    CHECK( consumed == blob.size() );
+    CHECK( r.size() == 8 );
+
+    const property_record *p = find(r, u"AutoPlay");
+    CHECK( p && p->type == prt_bool && p->int_value == 0 );
+    p = find(r, u"Toolbar");
+    CHECK( p && p->type == prt_bool && p->int_value == 0 );
+    p = find(r, u"ExtentWidth");
+    CHECK( p && p->type == prt_int && p->int_value == 8467 );
+    p = find(r, u"Volume");
+    CHECK( p && p->int_value == 75 );
+    p = find(r, u"MRL");
+    CHECK( p && p->type == prt_string && p->string_value == u"http://example.com/vidéo.mp4" );
+    p = find(r, u"BaseURL");
+    CHECK( p && p->type == prt_string && p->string_value.empty() );
+    p = find(r, u"Custom");
+    CHECK( p && p->type == prt_int && p->int_value == -5 );
+    CHECK( find(r, u"AUTOPLAY") == NULL );
+    p = find(r, u"Nothing");
+    CHECK( p && p->type == prt_empty );
+}
+
+static void put(bytes& b, const void *p, size_t n)
+{
+    b.insert(b.end(), (const unsigned char *)p, (const unsigned char *)p + n);
+}
+
+static void put_v1_name(bytes& b, const char16_t *name, uint16_t type)
+{
+    uint32_t len = (uint32_t)std::char_traits<char16_t>::length(name);
+    put(b, &len, sizeof(len));
+    put(b, name, len * sizeof(char16_t));
+    put(b, &type, sizeof(type));
+}
+
+static bytes write_v1()
+{
+    bytes b;
+    int32_t count = 3, volume = 42;
+    int16_t yes = -1;
+    put_v1_name(b, u"(Count)", prt_int);
+    put(b, &count, sizeof(count));
+    put_v1_name(b, u"Volume", prt_int);
+    put(b, &volume, sizeof(volume));
+    put_v1_name(b, u"AutoLoop", prt_bool);
+    put(b, &yes, sizeof(yes));
+    put_v1_name(b, u"MRL", prt_string);
+    uint32_t len = 5;
+    put(b, &len, sizeof(len));
+    put(b, u"a.mp4", len * sizeof(char16_t));
+    return b;
+}
+
+static void test_version1()
+{
+    bytes v1 = write_v1();
+    std::vector<property_record> r;
+    size_t consumed;
+    CHECK( read_property_blob(&v1[0], v1.size(), r, consumed) );
+    CHECK( consumed == v1.size() );
+    CHECK( r.size() == 3 );
+    CHECK( r.size() == 3 && r[0].name == u"Volume" && r[0].int_value == 42 );
+    CHECK( r.size() == 3 && r[1].type == prt_bool && r[1].int_value == 1 );
+    CHECK( r.size() == 3 && r[2].string_value == u"a.mp4" );
+
+    // a record cut short is corrupt
+    r.clear();
+    CHECK( !read_property_blob(&v1[0], v1.size() - 1, r, consumed) );
+}
+
+static void test_not_a_blob()
+{
+    static const unsigned char junk[] = "some other control's data";
+    std::vector<property_record> r;
+    size_t consumed = 99;
+    CHECK( read_property_blob(junk, sizeof(junk), r, consumed) );
+    CHECK( r.empty() && consumed == 0 );
+    CHECK( read_property_blob(junk, 0, r, consumed) );
+    CHECK( r.empty() && consumed == 0 );
+}
+
+static void test_corruption_is_detected()
+{
+    bytes blob = write_typical();
+    std::vector<property_record> r;
+    size_t consumed;
+
+    // every truncation after the magic fails
+    for( size_t n = 4; n < blob.size(); ++n )
+        CHECK( !read_property_blob(&blob[0], n, r, consumed) );
+
+    // and so does every single bit flip past the magic, through the CRC
+    for( size_t i = 4; i < blob.size(); ++i )
+    {
+        bytes bad = blob;
+        bad[i] ^= (unsigned char)(1 << (i % 8));
+        r.clear();
+        if( read_property_blob(&bad[0], bad.size(), r, consumed) )
+        {
+            fprintf(stderr, "flip at byte %zu not detected\n", i);
+            CHECK( !"corruption detected" );
+            break;
+        }
+    }
+}
+
+static uint32_t next_random(uint32_t& seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// mutated version 1 blobs have no checksum, they reach every field
+// parser; whatever happens, nothing is read past the end
+static void test_fuzz()
+{
+    bytes v1 = write_v1();
+    bytes v2 = write_typical();
+    uint32_t seed = 123456789u;
+    for( int round = 0; round < 100000; ++round )
+    {
+        bytes b = (round & 1) ? v1 : v2;
+        unsigned mutations = 1 + next_random(seed) % 4;
+        for( unsigned m = 0; m < mutations; ++m )
+        {
+            uint32_t r = next_random(seed);
+            size_t at = (r >> 8) % b.size();
+            switch( r % 3 )
+            {
+            case 0: b[at] = (unsigned char)(r >> 24); break;
+            case 1: b.resize(at ? at : 1); break;
+            default: b.insert(b.begin() + at, (unsigned char)(r >> 24)); break;
+            }
+        }
+        // a copy of exactly that size, so ASan sees any overread
+        std::vector<unsigned char> *exact = new std::vector<unsigned char>(b);
+        std::vector<property_record> records;
+        size_t consumed = 0;
+        bool ok = read_property_blob(&(*exact)[0], exact->size(), records, consumed);
+        CHECK( consumed <= exact->size() );
+        if( !ok )
+            CHECK( consumed == 0 );
+        delete exact;
+    }
+}
+
+int main()
+{
+    test_round_trip();
+    test_version1();
+    test_not_a_blob();
+    test_corruption_is_detected();
+    test_fuzz();
+    return test_result();
+}
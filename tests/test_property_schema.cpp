@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * test_property_schema.cpp: consistency tests of the persisted property schema
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ctype.h>
+#include <string.h>
+#include <string>
+
+#include "property_schema.h"
+#include "test.h"
+
+static const vlc_property_name *find(const char *name)
+{
+    return find_property(name, strlen(name));
+}
+
+static void test_names_are_grouped_in_load_order()
+{
+    bool seen[pp_count] = { false };
+    int last = -1;
+    for( size_t i = 0; i < property_names_count; ++i )
+    {
+        const vlc_property_name& n = property_names[i];
+        CHECK( n.id >= 0 && n.id < pp_count );
+        // names of one property follow each other, properties in enum order
+        CHECK( (int)n.id == last || (int)n.id == last + 1 );
+        last = n.id;
+        seen[n.id] = true;
+
+        // stored lowercased, the lookup folds the other side only
+        for( const char *c = n.name; *c; ++c )
+            CHECK( !isupper((unsigned char)*c) );
+
+        // an alias only changes how the value is written, not what it is
+        if( n.type != pt_html_color )
+            CHECK( n.type == property_schema[n.id].type );
+        else
+            CHECK( property_schema[n.id].type == pt_int );
+    }
+    for( int id = 0; id < pp_count; ++id )
+        CHECK( seen[id] );
+}
+
+static void test_saved_names_load_back()
+{
+    for( int id = 0; id < pp_count; ++id )
+    {
+        const char *saved = property_schema[id].saved_name;
+        if( !saved )
+            continue;
+        // what Save writes, Load reads as the same property and type
+        const vlc_property_name *n = find(saved);
+        CHECK( n != NULL );
+        CHECK( n && n->id == id && n->type == property_schema[id].type );
+    }
+}
+
+static void test_lookup()
+{
+    for( size_t i = 0; i < property_names_count; ++i )
+    {
+        const char *name = property_names[i].name;
+        CHECK( find(name) == &property_names[i] );
+
+        std::string upper(name);
+        for( auto& c : upper )
+            c = (char)toupper((unsigned char)c);
+        CHECK( find(upper.c_str()) == &property_names[i] );
+
+        // the length is part of the name, "fullscreen" is not "fullscreenenabled"
+        CHECK( find((std::string(name) + "x").c_str()) == NULL );
+    }
+
+    CHECK( find("") == NULL );
+    CHECK( find("unknown") == NULL );
+    CHECK( find("bgcolour") == NULL );
+    CHECK( find_property("fullscreenenabled", 10)->id == pp_fullscreen_enabled );
+    CHECK( find_property("fullscreenenabled", 10)->name[10] == '\0' );
+    CHECK( find("AutoStart")->id == pp_autoplay );
+    CHECK( find("BGCOLOR")->type == pt_html_color );
+}
+
+static void test_wide_lookup()
+{
+    CHECK( find_property(u"ShowDisplay", 11) == find("showdisplay") );
+    CHECK( find_property(U"Src", 3) == find("src") );
+    const char16_t accented[] = { 'm', 'r', 0xEC, 0 };
+    CHECK( find_property(accented, 3) == NULL );
+    // too long to be a property name
+    std::u16string long_name(40, u'a');
+    CHECK( find_property(long_name.c_str(), long_name.size()) == NULL );
+}
+
+int main()
+{
+    test_names_are_grouped_in_load_order();
+    test_saved_names_load_back();
+    test_lookup();
+    test_wide_lookup();
+    return test_result();
+}
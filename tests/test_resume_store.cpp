@@ -0,0 +1,145 @@
+/*****************************************************************************
+ * test_resume_store.cpp: unit tests of the shared resume positions
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "resume_store.h"
+#include "url_resolver.h"
+#include "test.h"
+
+static resume_entry entry(int64_t time)
+{
+    resume_entry e;
+    e.time = time;
+    e.audio_track = 1;
+    e.subtitle_track = -1;
+    e.video_track = 0;
+    return e;
+}
+
+static bool lookup(resume_store& store, const std::string& mrl, resume_entry& e)
+{
+    return store.lookup( mrl.data(), mrl.size(), e );
+}
+
+static void store(resume_store& s, const std::string& mrl, int64_t time)
+{
+    s.store( mrl.data(), mrl.size(), entry( time ) );
+}
+
+// the home slot, mirrors how resume_store hashes the normalized MRL
+static uint32_t home_slot(const std::string& mrl, uint32_t mask)
+{
+    std::string n;
+    url_resolver::normalize( mrl.data(), mrl.size(), n );
+    uint64_t h = 14695981039346656037ULL;
+    for( unsigned char c : n )
+        h = (h ^ c) * 1099511628211ULL;
+    return (uint32_t)(h ? h : 1) & mask;
+}
+
+static void test_store_lookup_erase(const char *path)
+{
+    resume_store s;
+    resume_entry e;
+    CHECK( !s.is_open() );
+    CHECK( !lookup( s, "file:///a.mkv", e ) );
+    CHECK( s.open( path, 64 ) );
+
+    store( s, "file:///a.mkv", 1000 );
+    store( s, "file:///b.mkv", 2000 );
+    CHECK( lookup( s, "file:///a.mkv", e ) && e.time == 1000 && e.audio_track == 1 );
+    // the same MRL, spelled differently
+    CHECK( lookup( s, "file:///x/../b.mkv", e ) && e.time == 2000 );
+
+    store( s, "file:///a.mkv", 1500 );
+    CHECK( lookup( s, "file:///a.mkv", e ) && e.time == 1500 );
+    s.erase( "file:///a.mkv", strlen( "file:///a.mkv" ) );
+    CHECK( !lookup( s, "file:///a.mkv", e ) );
+    CHECK( lookup( s, "file:///b.mkv", e ) );
+    s.close();
+
+    // positions outlive the store that wrote them
+    CHECK( s.open( path, 64 ) );
+    CHECK( lookup( s, "file:///b.mkv", e ) && e.time == 2000 );
+    // another table size starts over
+    CHECK( s.open( path, 128 ) );
+    CHECK( !lookup( s, "file:///b.mkv", e ) );
+}
+
+static void test_eviction_is_lru(const char *path)
+{
+    remove( path );
+    resume_store s;
+    CHECK( s.open( path, 64 ) );
+
+    // nine MRLs sharing a home slot, one more than its probe window holds
+    std::vector<std::string> mrls;
+    for( int i = 0; mrls.size() < 9; ++i )
+    {
+        std::string mrl = "file:///media/" + std::to_string( i ) + ".mp4";
+        if( home_slot( mrl, 63 ) == 5 )
+            mrls.push_back( mrl );
+    }
+    for( int i = 0; i < 8; ++i )
+        store( s, mrls[i], i );
+
+    // reading the oldest one makes the second the least recently used
+    resume_entry e;
+    CHECK( lookup( s, mrls[0], e ) && e.time == 0 );
+    store( s, mrls[8], 8 );
+    CHECK( lookup( s, mrls[0], e ) && e.time == 0 );
+    CHECK( !lookup( s, mrls[1], e ) );
+    for( int i = 2; i <= 8; ++i )
+        CHECK( lookup( s, mrls[i], e ) && e.time == i );
+}
+
+static void test_shared_between_stores(const char *path)
+{
+    remove( path );
+    resume_store a, b;
+    CHECK( a.open( path, 64 ) );
+    CHECK( b.open( path, 64 ) );
+    store( a, "file:///shared.ogg", 42 );
+    resume_entry e;
+    CHECK( lookup( b, "file:///shared.ogg", e ) && e.time == 42 );
+}
+
+int main()
+{
+    // written in the build directory
+    const char *path = "test_resume_store.dat";
+    remove( path );
+
+    test_store_lookup_erase(path);
+    test_eviction_is_lru(path);
+    test_shared_between_stores(path);
+
+    remove(path);
+    return test_result();
+}
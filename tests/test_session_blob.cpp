@@ -0,0 +1,137 @@
+/*****************************************************************************
+ * test_session_blob.cpp: unit tests of the saved session format
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include "session_blob.h"
+#include "test.h"
+
+static vlc_session sample()
+{
+    vlc_session s;
+    for( int i = 0; i < 3; ++i )
+    {
+        vlc_session_item item;
+        item.mrl = "file:///music/track" + std::to_string( i ) + ".flac";
+        item.options.push_back( ":start-time=" + std::to_string( 10 * i ) );
+        item.options.push_back( ":no-audio" );
+        item.meta.push_back( std::make_pair( 0, "Title \xC3\xA9" + std::to_string( i ) ) );
+        s.items.push_back( item );
+    }
+    s.current = 1;
+    s.time = 123456789012LL;
+    s.audio_track = 2;
+    s.subtitle_track = -1;
+    s.video_track = 0;
+    s.volume = 75;
+    s.mute = true;
+    s.loop = true;
+    s.rate = 1.5f;
+    return s;
+}
+
+static bool same(const vlc_session& a, const vlc_session& b)
+{
+    if( a.items.size() != b.items.size() )
+        return false;
+    for( size_t i = 0; i < a.items.size(); ++i )
+    {
+        if( a.items[i].mrl != b.items[i].mrl || a.items[i].options != b.items[i].options
+         || a.items[i].meta != b.items[i].meta )
+            return false;
+    }
+    return a.current == b.current && a.time == b.time
+        && a.audio_track == b.audio_track && a.subtitle_track == b.subtitle_track
+        && a.video_track == b.video_track && a.volume == b.volume
+        && a.mute == b.mute && a.loop == b.loop && a.rate == b.rate;
+}
+
+static void test_round_trip()
+{
+    std::vector<unsigned char> blob;
+    write_session( sample(), blob );
+    vlc_session s;
+    CHECK( read_session( blob.data(), blob.size(), s ) );
+    CHECK( same( s, sample() ) );
+
+    // nothing playing, no items
+    write_session( vlc_session(), blob );
+    CHECK( read_session( blob.data(), blob.size(), s ) );
+    CHECK( same( s, vlc_session() ) );
+}
+
+static void test_truncation_and_trailing_bytes()
+{
+    std::vector<unsigned char> blob;
+    write_session( sample(), blob );
+    vlc_session s = vlc_session();
+    for( size_t size = 0; size < blob.size(); ++size )
+        CHECK( !read_session( blob.data(), size, s ) );
+    // a rejected blob leaves the session as it was
+    CHECK( same( s, vlc_session() ) );
+
+    // bytes after the body are not part of the session, they are ignored
+    blob.push_back( 0 );
+    CHECK( read_session( blob.data(), blob.size(), s ) );
+}
+
+static void test_bit_flips()
+{
+    std::vector<unsigned char> blob;
+    write_session( sample(), blob );
+    for( size_t i = 0; i < blob.size(); ++i )
+    {
+        for( int bit = 0; bit < 8; ++bit )
+        {
+            std::vector<unsigned char> bad( blob );
+            bad[i] ^= (unsigned char)(1 << bit);
+            vlc_session s;
+            // the padding field is not checked, anything else is
+            if( i == 6 || i == 7 )
+                CHECK( read_session( bad.data(), bad.size(), s ) );
+            else
+                CHECK( !read_session( bad.data(), bad.size(), s ) );
+        }
+    }
+}
+
+static void test_bad_current()
+{
+    vlc_session in = sample();
+    in.current = 3;
+    std::vector<unsigned char> blob;
+    write_session( in, blob );
+    vlc_session s;
+    CHECK( !read_session( blob.data(), blob.size(), s ) );
+}
+
+int main()
+{
+    test_round_trip();
+    test_truncation_and_trailing_bytes();
+    test_bit_flips();
+    test_bad_current();
+    return test_result();
+}
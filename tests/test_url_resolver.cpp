@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * test_url_resolver.cpp: RFC 3986 conformance tests of the MRL resolver
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <string>
+
+#include "url_resolver.h"
+#include "test.h"
+
+static std::string resolve(const url_resolver& r, const char *ref)
+{
+    std::string out;
+    if( !r.resolve(ref, strlen(ref), out) )
+        return "<none>";
+    return out;
+}
+
+#define CHECK_RESOLVE(r, ref, want) \
+    do { \
+        std::string got = resolve(r, ref); \
+        if( got != want ) \
+            fprintf(stderr, "\"%s\" resolved to \"%s\", expected \"%s\"\n", ref, got.c_str(), want); \
+        CHECK( got == want ); \
+    } while( 0 )
+
+static void test_rfc3986_examples()
+{
+    url_resolver r;
+    const char base[] = "http://a/b/c/d;p?q";
+    CHECK( r.set_base(base, strlen(base)) );
+
+    // 5.4.1, normal examples
+    CHECK_RESOLVE( r, "g:h",     "g:h" );
+    CHECK_RESOLVE( r, "g",       "http://a/b/c/g" );
+    CHECK_RESOLVE( r, "./g",     "http://a/b/c/g" );
+    CHECK_RESOLVE( r, "g/",      "http://a/b/c/g/" );
+    CHECK_RESOLVE( r, "/g",      "http://a/g" );
+    CHECK_RESOLVE( r, "//g",     "http://g" );
+    CHECK_RESOLVE( r, "?y",      "http://a/b/c/d;p?y" );
+    CHECK_RESOLVE( r, "g?y",     "http://a/b/c/g?y" );
+    CHECK_RESOLVE( r, "#s",      "http://a/b/c/d;p?q#s" );
+    CHECK_RESOLVE( r, "g#s",     "http://a/b/c/g#s" );
+    CHECK_RESOLVE( r, "g?y#s",   "http://a/b/c/g?y#s" );
+    CHECK_RESOLVE( r, ";x",      "http://a/b/c/;x" );
+    CHECK_RESOLVE( r, "g;x",     "http://a/b/c/g;x" );
+    CHECK_RESOLVE( r, "g;x?y#s", "http://a/b/c/g;x?y#s" );
+    CHECK_RESOLVE( r, "",        "http://a/b/c/d;p?q" );
+    CHECK_RESOLVE( r, ".",       "http://a/b/c/" );
+    CHECK_RESOLVE( r, "./",      "http://a/b/c/" );
+    CHECK_RESOLVE( r, "..",      "http://a/b/" );
+    CHECK_RESOLVE( r, "../",     "http://a/b/" );
+    CHECK_RESOLVE( r, "../g",    "http://a/b/g" );
+    CHECK_RESOLVE( r, "../..",   "http://a/" );
+    CHECK_RESOLVE( r, "../../",  "http://a/" );
+    CHECK_RESOLVE( r, "../../g", "http://a/g" );
+
+    // 5.4.2, abnormal examples
+    CHECK_RESOLVE( r, "../../../g",    "http://a/g" );
+    CHECK_RESOLVE( r, "../../../../g", "http://a/g" );
+    CHECK_RESOLVE( r, "/./g",          "http://a/g" );
+    CHECK_RESOLVE( r, "/../g",         "http://a/g" );
+    CHECK_RESOLVE( r, "g.",            "http://a/b/c/g." );
+    CHECK_RESOLVE( r, ".g",            "http://a/b/c/.g" );
+    CHECK_RESOLVE( r, "g..",           "http://a/b/c/g.." );
+    CHECK_RESOLVE( r, "..g",           "http://a/b/c/..g" );
+    CHECK_RESOLVE( r, "./../g",        "http://a/b/g" );
+    CHECK_RESOLVE( r, "./g/.",         "http://a/b/c/g/" );
+    CHECK_RESOLVE( r, "g/./h",         "http://a/b/c/g/h" );
+    CHECK_RESOLVE( r, "g/../h",        "http://a/b/c/h" );
+    CHECK_RESOLVE( r, "g;x=1/./y",     "http://a/b/c/g;x=1/y" );
+    CHECK_RESOLVE( r, "g;x=1/../y",    "http://a/b/c/y" );
+    CHECK_RESOLVE( r, "g?y/./x",       "http://a/b/c/g?y/./x" );
+    CHECK_RESOLVE( r, "g?y/../x",      "http://a/b/c/g?y/../x" );
+    CHECK_RESOLVE( r, "g#s/./x",       "http://a/b/c/g#s/./x" );
+    CHECK_RESOLVE( r, "g#s/../x",      "http://a/b/c/g#s/../x" );
+    // strict parsers take this as absolute, so does the resolver
+    CHECK_RESOLVE( r, "http:g",        "http:g" );
+}
+
+static void test_vlc_forms()
+{
+    url_resolver r;
+    CHECK( !r.has_base() );
+    CHECK_RESOLVE( r, "g", "<none>" );
+    // absolute references need no base
+    CHECK_RESOLVE( r, "http://x/y", "http://x/y" );
+
+    // scheme plus demuxer counts as absolute, and is left alone
+    CHECK( url_resolver::scheme_length("http/ts://h/x", 13) == 8 );
+    CHECK( url_resolver::scheme_length("/tmp/a:b", 8) == 0 );
+    CHECK( url_resolver::scheme_length("1http:x", 7) == 0 );
+
+    const char path[] = "/home/user/videos/list.m3u";
+    CHECK( r.set_base(path, strlen(path)) );
+    CHECK_RESOLVE( r, "clip.mp4", "/home/user/videos/clip.mp4" );
+    CHECK_RESOLVE( r, "../music/a.mp3", "/home/user/music/a.mp3" );
+    CHECK_RESOLVE( r, "http/ts://h/./x", "http/ts://h/./x" );
+
+    CHECK( !r.set_base("videos/list", 11) );
+    CHECK( !r.has_base() );
+}
+
+static void test_normalize()
+{
+    static const char *cases[][2] = {
+        { "HTTP://Example.COM:/%7euser/./a/../b%2fc", "http://example.com/~user/b%2Fc" },
+        { "http://example.com", "http://example.com/" },
+        { "file:///C:/Videos/../Music/x.mp3", "file:///C:/Music/x.mp3" },
+        { "rtsp://HOST:554/Stream", "rtsp://host:554/Stream" },
+    };
+    for( size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i )
+    {
+        std::string out;
+        url_resolver::normalize(cases[i][0], strlen(cases[i][0]), out);
+        if( out != cases[i][1] )
+            fprintf(stderr, "\"%s\" normalized to \"%s\"\n", cases[i][0], out.c_str());
+        CHECK( out == cases[i][1] );
+    }
+}
+
+int main()
+{
+    test_rfc3986_examples();
+    test_vlc_forms();
+    test_normalize();
+    return test_result();
+}
@@ -0,0 +1,199 @@
+/*****************************************************************************
+ * test_utf_transcoder.cpp: unit tests of the UTF-16/UTF-8 conversions
+ *****************************************************************************
+ * Copyright © 2019 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+
+#include "utf_transcoder.h"
+#include "test.h"
+
+static std::string to_utf8(const std::u16string& s)
+{
+    std::string out(utf16_to_utf8_length(s.data(), s.size()), '\0');
+    size_t n = utf16_to_utf8(s.data(), s.size(), &out[0]);
+    CHECK( n == out.size() );
+    return out;
+}
+
+static std::u16string to_utf16(const std::string& s)
+{
+    std::u16string out(utf8_to_utf16_length(s.data(), s.size()), u'\0');
+    size_t n = utf8_to_utf16(s.data(), s.size(), &out[0]);
+    CHECK( n == out.size() );
+    return out;
+}
+
+// reference encoder, one code point at a time
+static void append_utf8(std::string& s, char32_t c)
+{
+    if( c < 0x80 )
+        s += (char)c;
+    else if( c < 0x800 )
+    {
+        s += (char)(0xC0 | (c >> 6));
+        s += (char)(0x80 | (c & 0x3F));
+    }
+    else if( c < 0x10000 )
+    {
+        s += (char)(0xE0 | (c >> 12));
+        s += (char)(0x80 | ((c >> 6) & 0x3F));
+        s += (char)(0x80 | (c & 0x3F));
+    }
+    else
+    {
+        s += (char)(0xF0 | (c >> 18));
+        s += (char)(0x80 | ((c >> 12) & 0x3F));
+        s += (char)(0x80 | ((c >> 6) & 0x3F));
+        s += (char)(0x80 | (c & 0x3F));
+    }
+}
+
+static void append_utf16(std::u16string& s, char32_t c)
+{
+    if( c < 0x10000 )
+        s += (char16_t)c;
+    else
+    {
+        c -= 0x10000;
+        s += (char16_t)(0xD800 | (c >> 10));
+        s += (char16_t)(0xDC00 | (c & 0x3FF));
+    }
+}
+
+static void test_known_strings()
+{
+    CHECK( to_utf8(u"") == "" );
+    CHECK( to_utf16("") == u"" );
+    CHECK( to_utf8(u"café € \U0001F3B5") == "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x8e\xb5" );
+    CHECK( to_utf16("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x8e\xb5") == u"café € \U0001F3B5" );
+
+    // long ASCII runs go through the block paths, with a tail on each side
+    std::string ascii;
+    std::u16string ascii16;
+    for( int i = 0; i < 1000; ++i )
+    {
+        ascii += (char)(' ' + i % 95);
+        ascii16 += (char16_t)(' ' + i % 95);
+    }
+    CHECK( to_utf8(ascii16) == ascii );
+    CHECK( to_utf16(ascii) == ascii16 );
+    CHECK( to_utf8(ascii16 + u"é" + ascii16) == ascii + "\xc3\xa9" + ascii );
+    CHECK( to_utf16(ascii + "\xc3\xa9" + ascii) == ascii16 + u"é" + ascii16 );
+}
+
+static void test_malformed()
+{
+    // unpaired surrogates, each one replaced
+    std::u16string lone;
+    lone += (char16_t)0xD800;
+    lone += u'a';
+    lone += (char16_t)0xDC00;
+    lone += (char16_t)0xDBFF;
+    CHECK( to_utf8(lone) == "\xef\xbf\xbd" "a" "\xef\xbf\xbd\xef\xbf\xbd" );
+
+    // one replacement per offending byte
+    CHECK( to_utf16("\xc0\x80") == u"��" );            // overlong
+    CHECK( to_utf16("\xed\xa0\x80") == u"���" );  // surrogate
+    CHECK( to_utf16("\xf4\x90\x80\x80") == u"����" );
+    CHECK( to_utf16("a\xe2\x82") == u"a��" );          // truncated
+    CHECK( to_utf16("\xe2(b") == u"�(b" );
+    CHECK( to_utf16("\xff\xfe") == u"��" );
+    CHECK( to_utf16("\x80z") == u"�z" );
+}
+
+static uint32_t next_random(uint32_t& seed)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void test_random_round_trip()
+{
+    uint32_t seed = 88172645u;
+    for( int round = 0; round < 20000; ++round )
+    {
+        std::string utf8;
+        std::u16string utf16;
+        size_t len = next_random(seed) % 64;
+        for( size_t i = 0; i < len; ++i )
+        {
+            uint32_t r = next_random(seed);
+            char32_t c;
+            // mostly ASCII runs, as in option strings and URLs
+            switch( r % 8 )
+            {
+            case 0: c = 0x80 + (r >> 8) % 0x780; break;
+            case 1: c = 0x800 + (r >> 8) % 0xF800; break;
+            case 2: c = 0x10000 + (r >> 8) % 0x100000; break;
+            default: c = (r >> 8) % 0x80; break;
+            }
+            if( c >= 0xD800 && c <= 0xDFFF )
+                c = 0xFFFD;
+            append_utf8(utf8, c);
+            append_utf16(utf16, c);
+        }
+        if( to_utf8(utf16) != utf8 || to_utf16(utf8) != utf16 )
+        {
+            CHECK( !"round trip" );
+            break;
+        }
+    }
+}
+
+// whatever the input, the sizing scan matches the conversion
+static void test_random_bytes()
+{
+    uint32_t seed = 2463534242u;
+    for( int round = 0; round < 20000; ++round )
+    {
+        std::string bytes;
+        std::u16string units;
+        size_t len = next_random(seed) % 48;
+        for( size_t i = 0; i < len; ++i )
+        {
+            uint32_t r = next_random(seed);
+            bytes += (char)(r & 0x80 ? r >> 8 : r % 0x80);
+            units += (char16_t)(r & 0x10 ? 0xD800 + (r >> 16) % 0x800 : r >> 16);
+        }
+        std::u16string decoded = to_utf16(bytes);
+        std::string encoded = to_utf8(units);
+        // and valid output converts back unchanged
+        if( to_utf8(to_utf16(encoded)) != encoded || to_utf16(to_utf8(decoded)) != decoded )
+        {
+            CHECK( !"stable output" );
+            break;
+        }
+    }
+}
+
+int main()
+{
+    test_known_strings();
+    test_malformed();
+    test_random_round_trip();
+    test_random_bytes();
+    return test_result();
+}